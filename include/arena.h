@@ -0,0 +1,37 @@
+// arena.h
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator for book storage: many books (one per symbol) carve their
+// sides out of a few large blocks instead of one malloc each, and the whole
+// lot is released at once. Individual allocations are never freed: when a
+// side grows, the old buffer stays in the arena until arena_reset/arena_free,
+// so with doubling growth at most half of a side's footprint is dead space.
+
+#define ARENA_DEFAULT_BLOCK_SIZE (1024 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;                // usable bytes after the header
+    size_t used;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;           // current block, older blocks follow
+    size_t block_size;
+    size_t allocated;           // bytes handed out, padding included
+} Arena;
+
+void arena_init(Arena* arena, size_t block_size);
+
+// Returns size bytes aligned to align (a power of two), NULL if out of memory.
+// Requests larger than the block size get a block of their own.
+void* arena_alloc(Arena* arena, size_t size, size_t align);
+
+// Forget every allocation, keeping the most recent block for reuse
+void arena_reset(Arena* arena);
+void arena_free(Arena* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,53 @@
+// book_query.h
+#ifndef BOOK_QUERY_H
+#define BOOK_QUERY_H
+
+#include <stdint.h>
+
+#include "orderbook.h"
+
+// Cost-to-fill queries over an SOA book: what a market order for a given
+// quantity, or a given notional, would pay sweeping one side from the touch.
+// A buy sweeps the asks, a sell the bids; both are stored best first, so the
+// same walk serves either side.
+//
+// The kernels keep a running prefix sum of the level amounts (quantity) or
+// of price * amount (notional) 4 levels at a time and only drop to scalar
+// code in the block where the target is reached. AVX2 on x86 (picked at load
+// time from cpu_features()), NEON on AArch64, scalar otherwise. Same value
+// range as book_scan.h: prices and amounts in [0, 2^52).
+
+typedef struct {
+    int64_t filled;         // lots taken, less than asked if the side is too thin
+    double notional;        // quote currency spent (price * quantity)
+    double vwap;            // notional / quantity filled, 0 if nothing filled
+    int64_t worst_price;    // ticks of the last level touched, 0 if none
+    int levels;             // levels touched, the last one possibly in part
+} BookFill;
+
+// Take quantity lots from the side. Returns 1 if it was all filled, 0 if the
+// side ran out first (fill has what there was).
+extern int (*book_query_quantity)(const SideSOA* side, int64_t quantity, BookFill* fill);
+
+// Spend up to notional (quote currency) on the side, in whole lots. Returns 1
+// if the target was reached, 0 if the side ran out first.
+extern int (*book_query_notional)(const SideSOA* side, double notional, BookFill* fill);
+
+// Scalar references
+int book_query_quantity_scalar(const SideSOA* side, int64_t quantity, BookFill* fill);
+int book_query_notional_scalar(const SideSOA* side, double notional, BookFill* fill);
+
+// Name of the kernels bound ("avx2", "neon", "scalar")
+const char* book_query_kernel(void);
+
+static inline int book_cost_to_fill(const OrderBookSOA* book, int is_buy, int64_t quantity,
+                                    BookFill* fill) {
+    return book_query_quantity(is_buy ? &book->asks : &book->bids, quantity, fill);
+}
+
+static inline int book_fill_notional(const OrderBookSOA* book, int is_buy, double notional,
+                                     BookFill* fill) {
+    return book_query_notional(is_buy ? &book->asks : &book->bids, notional, fill);
+}
+
+#endif // BOOK_QUERY_H
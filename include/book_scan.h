@@ -0,0 +1,51 @@
+// book_scan.h
+#ifndef BOOK_SCAN_H
+#define BOOK_SCAN_H
+
+#include <stdint.h>
+
+// Scans over one side of an SOA book (SideSOA columns: fixed-point 1e8
+// prices and amounts, best level first). Every kernel has a C reference and
+// a hand-written assembly version: AVX2 in book_scan_x86_64.S, NEON in
+// book_scan_aarch64.S. The book_scan_* pointers are bound at load time to
+// the assembly when the CPU has it (cpu_features.h), to the C otherwise.
+//
+// Prices and amounts must be in [0, 2^52): AVX2 has no int64 -> double
+// conversion, so the x86 VWAP kernel uses the 2^52 exponent trick. That is
+// 45M units at 1e8, far beyond any real level.
+
+// Total amount of the n best levels (n is clamped to count)
+int64_t book_scan_depth_c(const int64_t* amounts, int count, int n);
+
+// Index of the level at price, -1 if there is none. A linear scan from the
+// touch, where most lookups land.
+int book_scan_find_c(const int64_t* prices, int count, int64_t price);
+
+// Walk the levels best-first until size is filled. Returns the amount
+// filled (less than size if the side is too thin) and stores the sum of
+// price * amount taken in *notional (ticks * lots: divide by the amount
+// filled for the VWAP in ticks).
+int64_t book_scan_vwap_c(const int64_t* prices, const int64_t* amounts, int count,
+                         int64_t size, double* notional);
+
+#if defined(__x86_64__)
+int64_t book_scan_depth_avx2(const int64_t* amounts, int count, int n);
+int book_scan_find_avx2(const int64_t* prices, int count, int64_t price);
+int64_t book_scan_vwap_avx2(const int64_t* prices, const int64_t* amounts, int count,
+                            int64_t size, double* notional);
+#elif defined(__aarch64__)
+int64_t book_scan_depth_neon(const int64_t* amounts, int count, int n);
+int book_scan_find_neon(const int64_t* prices, int count, int64_t price);
+int64_t book_scan_vwap_neon(const int64_t* prices, const int64_t* amounts, int count,
+                            int64_t size, double* notional);
+#endif
+
+extern int64_t (*book_scan_depth)(const int64_t* amounts, int count, int n);
+extern int (*book_scan_find)(const int64_t* prices, int count, int64_t price);
+extern int64_t (*book_scan_vwap)(const int64_t* prices, const int64_t* amounts, int count,
+                                 int64_t size, double* notional);
+
+// Name of the kernels bound ("avx2", "neon" or "c")
+const char* book_scan_kernel(void);
+
+#endif // BOOK_SCAN_H
@@ -0,0 +1,83 @@
+// capture.h
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "orderbook.h"
+
+// Append-only binary capture of a depth stream, already decoded to
+// fixed-point levels (1e8 scale). Host byte order (little-endian on
+// every target we run on).
+//
+//  file:   CaptureFileHeader, then records back to back
+//  record: CaptureRecordHeader, then bid_count + ask_count DepthLevel
+//          (bids first, in the order they were received)
+//
+// Records are 8-byte aligned so levels can be read in place from a mapping.
+// A truncated last record (writer killed mid-write) is ignored by the reader.
+
+#define CAPTURE_MAGIC "OBCAP001"
+#define CAPTURE_VERSION 1
+
+typedef enum {
+    CAPTURE_SNAPSHOT = 1,   // REST snapshot, last_update_id = lastUpdateId
+    CAPTURE_DIFF = 2        // diff-depth event with U/u
+} CaptureRecordType;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t decimals;          // FIXED_POINT_DECIMALS
+    char symbol[16];
+} CaptureFileHeader;
+
+typedef struct {
+    uint32_t size;              // record size in bytes, header included
+    uint16_t type;              // CaptureRecordType
+    uint16_t reserved;
+    uint64_t recv_time_ns;      // CLOCK_REALTIME when the message arrived
+    uint64_t event_time;        // exchange "E" in ms, 0 for snapshots
+    uint64_t first_update_id;
+    uint64_t last_update_id;
+    uint32_t bid_count;
+    uint32_t ask_count;
+} CaptureRecordHeader;
+
+typedef struct {
+    FILE* file;
+    uint64_t records;
+} CaptureWriter;
+
+typedef struct {
+    const CaptureRecordHeader* header;
+    const DepthLevel* bids;
+    const DepthLevel* asks;
+} CaptureRecord;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+    const CaptureFileHeader* header;
+} CaptureReader;
+
+// Open for appending, writing the file header if the file is new.
+// Returns 0 on success, -1 on error (or if the file is not a capture).
+int capture_open(CaptureWriter* writer, const char* filename, const char* symbol);
+int capture_write_update(CaptureWriter* writer, uint64_t recv_time_ns, const DepthUpdate* update);
+int capture_write_snapshot(CaptureWriter* writer, uint64_t recv_time_ns, const OrderBook* ob);
+int capture_close(CaptureWriter* writer);
+
+// Memory-map a capture for reading. Returns 0 on success, -1 on error.
+int capture_map(CaptureReader* reader, const char* filename);
+// Next record, pointing straight into the mapping. Returns 1, or 0 at the end.
+int capture_next(CaptureReader* reader, CaptureRecord* record);
+void capture_rewind(CaptureReader* reader);
+void capture_unmap(CaptureReader* reader);
+
+uint64_t capture_now_ns(void);
+
+#endif // CAPTURE_H
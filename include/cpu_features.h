@@ -0,0 +1,26 @@
+// cpu_features.h
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// SIMD support of the host, probed once at load time: cpuid + xgetbv on x86
+// (the OS must also save the wider registers), getauxval(AT_HWCAP) on
+// Linux/AArch64. Kernels are compiled for every instruction set with target
+// attributes and bound from this at startup, so one binary runs the best
+// kernel on each host instead of assuming what the build machine had.
+//
+// ORDERBOOK_SIMD=scalar|sse2|avx2 in the environment caps what is reported,
+// to run the slower kernels on a fast host.
+
+typedef struct {
+    int sse2;
+    int avx2;
+    int avx512f;
+    int neon;
+} CpuFeatures;
+
+const CpuFeatures* cpu_features(void);
+
+// Widest instruction set reported: "avx512", "avx2", "sse2", "neon" or "scalar"
+const char* cpu_features_name(void);
+
+#endif // CPU_FEATURES_H
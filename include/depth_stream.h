@@ -0,0 +1,94 @@
+// depth_stream.h
+#ifndef DEPTH_STREAM_H
+#define DEPTH_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "orderbook.h"
+#include "top_of_book.h"
+
+// Keeps a persistent OrderBook in sync with the diff-depth stream
+// (<symbol>@depth / <symbol>@depth@100ms), following Binance's procedure:
+//  1. buffer events until a snapshot is available
+//  2. drop buffered events with u <= lastUpdateId of the snapshot
+//  3. the first applied event must satisfy U <= lastUpdateId + 1 <= u
+//  4. every following event must have U == previous u + 1, otherwise the
+//     book is out of sync and a new snapshot is needed
+
+typedef enum {
+    DEPTH_STREAM_BUFFERING,     // waiting for a snapshot
+    DEPTH_STREAM_LIVE,          // applying deltas in place
+    DEPTH_STREAM_RESYNC         // sequence gap, waiting for a new snapshot
+} DepthStreamState;
+
+typedef enum {
+    DEPTH_APPLIED,
+    DEPTH_BUFFERED,
+    DEPTH_STALE,                // already covered by the snapshot, dropped
+    DEPTH_GAP,                  // sequence gap detected, stream moved to RESYNC
+    DEPTH_PARSE_ERROR
+} DepthStreamResult;
+
+// Events kept while BUFFERING/RESYNC, the oldest dropped beyond this: a
+// snapshot newer than them makes them stale anyway (~7 min at 100ms)
+#define DEPTH_STREAM_MAX_PENDING 4096
+
+// Decoded event kept while BUFFERING/RESYNC: bids followed by asks
+typedef struct {
+    uint64_t first_update_id;
+    uint64_t last_update_id;
+    DepthLevel* levels;
+    int bid_count;
+    int ask_count;
+} DepthPendingUpdate;
+
+typedef struct {
+    OrderBook* book;
+    DepthStreamState state;
+    uint64_t last_update_id;
+    int awaiting_first_event;   // next event only needs U <= lastUpdateId + 1 <= u
+
+    // Events received while BUFFERING/RESYNC
+    DepthPendingUpdate* pending;
+    int pending_count;
+    int pending_capacity;
+
+    // Last parsed message, reused for every message
+    DepthUpdate update;
+
+    // Optional: top levels republished after every applied event and snapshot
+    TopOfBook* top;
+
+    // Stats
+    uint64_t applied;
+    uint64_t stale;
+    uint64_t gaps;
+    uint64_t dropped;           // buffered events evicted by DEPTH_STREAM_MAX_PENDING
+} DepthStream;
+
+void depth_stream_init(DepthStream* ds);
+void depth_stream_free(DepthStream* ds);
+
+// Install a snapshot book (its last_update_id is the REST lastUpdateId) and
+// replay the buffered events on top of it. Returns 1 if the stream is live,
+// 0 if the snapshot is older than the buffered events and a newer one is needed
+// (the stream stays in RESYNC; call again with a newer snapshot, from either
+// BUFFERING or RESYNC).
+int depth_stream_set_snapshot(DepthStream* ds, OrderBook* book);
+
+// Same, parsing a REST snapshot ({"lastUpdateId":..,"bids":..,"asks":..})
+// into the caller-owned book. Returns 0 as well if the snapshot is malformed.
+int depth_stream_load_snapshot(DepthStream* ds, OrderBook* book, const char* snapshot_json, size_t len);
+
+// Feed one websocket message (not necessarily NUL-terminated)
+DepthStreamResult depth_stream_on_message(DepthStream* ds, const char* msg, size_t len);
+
+// Feed an already decoded event, e.g. from a capture file
+DepthStreamResult depth_stream_on_levels(DepthStream* ds, uint64_t first_update_id, uint64_t last_update_id,
+                                         const DepthLevel* bids, int bid_count,
+                                         const DepthLevel* asks, int ask_count);
+
+const char* depth_stream_result_name(DepthStreamResult result);
+
+#endif // DEPTH_STREAM_H
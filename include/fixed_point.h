@@ -0,0 +1,28 @@
+// fixed_point.h
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+// Binance sends prices and quantities as decimal strings with 8 fractional
+// digits ("118728.39000000"), so everything is scaled by 1e8:
+// price ticks = price * 1e8, quantity lots = quantity * 1e8
+#define FIXED_POINT_DECIMALS 8
+#define FIXED_POINT_SCALE 100000000LL
+
+// Parse the decimal string [start, end) into a value scaled by FIXED_POINT_SCALE.
+// Strings with exactly 8 decimals (the Binance format) take a SWAR fast path,
+// anything else falls back to a scalar loop. Returns 1 on success, 0 on
+// malformed input or more than 8 decimals.
+int parse_fixed_point(const char* start, const char* end, int64_t* out);
+
+// Scalar reference decoder, used by the fallback path and the benchmark
+int parse_fixed_point_scalar(const char* start, const char* end, int64_t* out);
+
+// Both operands are exact, so the division is correctly rounded and gives
+// the same double atof() would for the original string
+static inline double fixed_point_to_double(int64_t value) {
+    return (double)value / (double)FIXED_POINT_SCALE;
+}
+
+#endif // FIXED_POINT_H
@@ -2,7 +2,30 @@
 #ifndef JSON_LOADER_H
 #define JSON_LOADER_H
 
+#include <stddef.h>
+
 char* load_json_file(const char* filename);
 void free_json_data(char* data);
 
+// Zero-copy loader: the file is memory-mapped read-only and pre-faulted.
+// The data is NOT NUL-terminated, use the *_n parsing functions on it.
+typedef struct {
+    const char* data;
+    size_t size;
+} MappedJson;
+
+int map_json_file(const char* filename, MappedJson* mapped);   // 0 on success, -1 on error
+void unmap_json_file(MappedJson* mapped);
+
+// Streaming reader for newline-delimited captures (one JSON message per line)
+// of any size: the file is read in chunk_size pieces and never held in RAM.
+// The callback gets each line without its '\n'; returning non-zero stops.
+// Returns the number of lines delivered, or -1 on error.
+typedef int (*json_line_callback)(const char* line, size_t len, void* user);
+
+#define JSON_STREAM_CHUNK_SIZE (4 * 1024 * 1024)
+
+long stream_json_lines(const char* filename, size_t chunk_size,
+                       json_line_callback callback, void* user);
+
 #endif
@@ -0,0 +1,68 @@
+// json_scan.h
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// simdjson-style stage 1 for depth messages: classify 64 bytes at a time
+// into a bitmask of structural characters  " , : [ ] { }  (bit i = byte i),
+// so the parser jumps from one structural character to the next with a
+// count-trailing-zeros instead of testing every byte.
+//
+// Kernels: AVX2 or SSE2 on x86 (picked at load time from cpu_features()),
+// NEON on AArch64, scalar otherwise. Escaped quotes are not tracked: depth
+// messages only carry numeric strings and symbols.
+
+#define JSON_SCAN_BLOCK 64
+
+// Structural mask of the 64 bytes at p (all readable): a pointer bound
+// before main to the best kernel the CPU supports
+extern uint64_t (*json_structural_mask)(const char* p);
+
+// Scalar reference, also used for the tail of a buffer
+uint64_t json_structural_mask_scalar(const char* p, int len);
+
+// Name of the kernel bound ("avx2", "sse2", "neon", "scalar")
+const char* json_scan_kernel(void);
+
+// Cursor over the structural characters of [start, end)
+typedef struct {
+    const char* block;          // start of the current 64-byte block
+    const char* end;
+    uint64_t mask;              // structural bits not returned yet
+} JsonScanner;
+
+static inline void json_scanner_load(JsonScanner* sc) {
+    long remaining = sc->end - sc->block;
+    sc->mask = remaining >= JSON_SCAN_BLOCK
+        ? json_structural_mask(sc->block)
+        : json_structural_mask_scalar(sc->block, (int)remaining);
+}
+
+static inline void json_scanner_init(JsonScanner* sc, const char* start, const char* end) {
+    sc->block = start;
+    sc->end = end;
+    if (start < end) {
+        json_scanner_load(sc);
+    } else {
+        sc->mask = 0;
+    }
+}
+
+// Next structural character, NULL at the end of the buffer
+static inline const char* json_scanner_next(JsonScanner* sc) {
+    while (sc->mask == 0) {
+        sc->block += JSON_SCAN_BLOCK;
+        if (sc->block >= sc->end) {
+            sc->block = sc->end;
+            return NULL;
+        }
+        json_scanner_load(sc);
+    }
+    const char* p = sc->block + __builtin_ctzll(sc->mask);
+    sc->mask &= sc->mask - 1;
+    return p;
+}
+
+#endif // JSON_SCAN_H
@@ -4,7 +4,12 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "arena.h"
+
+// Default depth cap per side; books can be configured deeper or shallower
 #define MAX_ORDERBOOK_ENTRIES 5000
+// Levels reserved per side on first use, doubled as the book deepens
+#define ORDERBOOK_INITIAL_CAPACITY 64
 
 // Order book entry structure
 typedef struct {
@@ -13,24 +18,40 @@ typedef struct {
     double amount;
 } OrderBookEntry;
 
-// Order book structure with fixed-size buffers
+// Order book structure with growable sides
+// Storage comes from the arena when one is set, from the heap otherwise, so a
+// zero-initialized book is valid (heap-backed, MAX_ORDERBOOK_ENTRIES deep).
 typedef struct {
-    OrderBookEntry bids[MAX_ORDERBOOK_ENTRIES];
-    OrderBookEntry asks[MAX_ORDERBOOK_ENTRIES];
+    OrderBookEntry* bids;
+    OrderBookEntry* asks;
     int bid_count;
     int ask_count;
+    int bid_capacity;
+    int ask_capacity;
+    int max_depth;              // levels kept per side, 0 = MAX_ORDERBOOK_ENTRIES
+    Arena* arena;
+    uint64_t last_update_id;
 } OrderBook;
 
 // START: Order book with separate arrays for prices and amounts (SOA - Structure of Arrays)
+// Fixed-point (1e8) columns, each starting on a cache line so depth scans
+// can use aligned vector loads
+#define SOA_ALIGNMENT 64
+
 typedef struct {
-    double prices[MAX_ORDERBOOK_ENTRIES];
-    double amounts[MAX_ORDERBOOK_ENTRIES];
+    int64_t* prices;            // SOA_ALIGNMENT aligned
+    int64_t* amounts;           // SOA_ALIGNMENT aligned
     int count;
+    int capacity;
 } SideSOA;
 
+// Same storage rules as OrderBook
 typedef struct {
     SideSOA bids;
     SideSOA asks;
+    int max_depth;
+    Arena* arena;
+    uint64_t last_update_id;
 } OrderBookSOA;
 // END
 
@@ -42,27 +63,113 @@ typedef struct {
 
 typedef struct {
     int count;
+    int capacity;
     double price;
-    Order entries[MAX_ORDERBOOK_ENTRIES];
+    Order* entries;
 } PriceLevel;
 
-// Order book per price level 
+// Order book per price level, allocated from an arena
 typedef struct {
-     OrderBookEntry bids[MAX_ORDERBOOK_ENTRIES];
-     OrderBookEntry asks[MAX_ORDERBOOK_ENTRIES];
+     PriceLevel* bids;
+     PriceLevel* asks;
      int bid_count;
      int ask_count;
  } OrderBookPriceLevel;
 // END
 
+// START: Diff-depth stream event (<symbol>@depth), prices/amounts in fixed-point (1e8)
+typedef struct {
+    int64_t price;
+    int64_t amount;     // 0 removes the level
+} DepthLevel;
+
+// Keys found by parse_depth_message
+#define DEPTH_FIELD_LAST_UPDATE_ID   0x01   // "lastUpdateId" (REST snapshot)
+#define DEPTH_FIELD_FIRST_UPDATE_ID  0x02   // "U"
+#define DEPTH_FIELD_FINAL_UPDATE_ID  0x04   // "u"
+#define DEPTH_FIELD_EVENT_TIME       0x08   // "E"
+#define DEPTH_FIELD_BIDS             0x10   // "bids" or "b"
+#define DEPTH_FIELD_ASKS             0x20   // "asks" or "a"
+
+typedef struct {
+    unsigned fields;            // DEPTH_FIELD_* present in the message
+    uint64_t event_time;        // "E"
+    uint64_t first_update_id;   // "U"
+    uint64_t last_update_id;    // "u", or "lastUpdateId" for a snapshot
+    DepthLevel bids[MAX_ORDERBOOK_ENTRIES];
+    DepthLevel asks[MAX_ORDERBOOK_ENTRIES];
+    int bid_count;
+    int ask_count;
+} DepthUpdate;
+// END
+
 // Main parsing function - parses a complete order book snapshot
+// Returns a shared static book, overwritten by the next call (not reentrant)
 OrderBook* parse_orderbook_snapshot(const char* json);
+// Same, for a buffer that is not NUL-terminated (mmap'd file, websocket frame)
+OrderBook* parse_orderbook_snapshot_n(const char* json, size_t len);
 
+// Reentrant version: parses into a caller-owned book, so each symbol/thread
+// can have its own. Returns 1 on a complete snapshot, 0 if malformed or
+// truncated (the levels parsed so far are kept).
+int parse_orderbook_snapshot_into(OrderBook* ob, const char* json, size_t len);
+
+// Parse a snapshot straight into fixed-point SOA columns, no intermediate
+// OrderBook. Same return value as parse_orderbook_snapshot_into.
+int parse_orderbook_snapshot_soa_into(OrderBookSOA* soa, const char* json, size_t len);
+
+// Single pass over one depth message, REST snapshot or diff event, with keys
+// handled in document order. Returns the bytes consumed through the closing
+// brace (the caller can continue from there), or 0 if malformed/truncated.
+size_t parse_depth_message(const char* json, size_t len, DepthUpdate* update);
+
+// Parse a diff-depth event, returns 1 on success and 0 on malformed input
+// or when U/u are missing
+int parse_depth_update(const char* json, DepthUpdate* update);
+int parse_depth_update_n(const char* json, size_t len, DepthUpdate* update);
+
+// Apply deltas in place: set the level quantity, amount 0 deletes the level
+int orderbook_apply_level(OrderBook* ob, int is_bid, int64_t price, int64_t amount);
+void orderbook_apply_update(OrderBook* ob, const DepthUpdate* update);
+
+// Rebuild a book from fixed-point levels (best first), e.g. a recorded snapshot
+void orderbook_load_levels(OrderBook* ob, uint64_t last_update_id,
+                           const DepthLevel* bids, int bid_count,
+                           const DepthLevel* asks, int ask_count);
+
+// Copies into a shared static SOA book (not reentrant)
 OrderBookSOA* orderBookSOA_from_simple_orderbook(OrderBook* ob);
+// Copies into a caller-owned SOA book, returns soa. Built with
+// -DORDERBOOK_VALIDATE (make VALIDATE=1) the copy is checked against the
+// source with compare_orderbook_snapshot.
+OrderBookSOA* orderBookSOA_from_simple_orderbook_into(OrderBookSOA* soa, const OrderBook* ob);
+// Shared static book, rebuilt on every call (not reentrant)
 OrderBookPriceLevel* orderBookPriceLevel_from_simple_orderbook(OrderBook* ob);
+// One single-order level per entry, allocated from the arena
+OrderBookPriceLevel* orderBookPriceLevel_from_simple_orderbook_into(OrderBookPriceLevel* book, Arena* arena,
+                                                                    const OrderBook* ob);
+
+// Check a SOA copy against its source book, returns the number of discrepancies
+int compare_orderbook_snapshot(const OrderBook* ob, const OrderBookSOA* ob_soa);
+
+// Set up an empty book: sides come from the arena (NULL = heap), at most
+// max_depth levels per side (0 = MAX_ORDERBOOK_ENTRIES). Does not release
+// previous storage, use free_orderbook for that.
+void orderbook_init(OrderBook* ob, Arena* arena, int max_depth);
+void orderbook_soa_init(OrderBookSOA* soa, Arena* arena, int max_depth);
+
+// Make room for capacity levels on one side (capped at max_depth).
+// Returns 1 on success, 0 if out of memory.
+int orderbook_reserve(OrderBook* ob, int is_bid, int capacity);
+int orderbook_soa_reserve(OrderBookSOA* soa, int is_bid, int capacity);
+
+// Bytes currently reserved by the sides
+size_t orderbook_memory(const OrderBook* ob);
+size_t orderbook_soa_memory(const OrderBookSOA* soa);
 
-// Free order book memory (no-op for this approach)
+// Free order book memory (heap-backed sides; arena-backed ones go with the arena)
 void free_orderbook(OrderBook* ob);
+void free_orderbook_soa(OrderBookSOA* soa);
 
 // Print order book
 void print_orderbook(OrderBook* ob);
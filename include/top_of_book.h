@@ -0,0 +1,63 @@
+// top_of_book.h
+#ifndef TOP_OF_BOOK_H
+#define TOP_OF_BOOK_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "orderbook.h"
+
+// Top N levels of a book published by the thread that owns it (the feed
+// handler) for any number of reader threads, through a seqlock: the writer
+// makes the sequence odd, stores the levels, then makes it even again.
+// Readers copy the levels and keep the copy only if the sequence was even
+// and unchanged across it.
+//
+// The writer never waits for readers, and readers never write shared
+// memory, so they don't slow the writer or each other down.
+// top_of_book_try_read is wait-free (one attempt). top_of_book_read retries
+// only while a publish overlaps the copy, which at a few hundred ns per
+// publish means one extra attempt at most in practice.
+
+#define TOP_OF_BOOK_LEVELS 10
+
+typedef struct {
+    double price;
+    double amount;
+} TopLevel;
+
+typedef struct {
+    uint64_t last_update_id;
+    int bid_count;
+    int ask_count;
+    int in_sync;                            // 0 while the publisher's book is out of sync
+    TopLevel bids[TOP_OF_BOOK_LEVELS];      // best first
+    TopLevel asks[TOP_OF_BOOK_LEVELS];
+} TopOfBookSnapshot;
+
+#define TOP_OF_BOOK_WORDS (sizeof(TopOfBookSnapshot) / sizeof(uint64_t))
+
+// The sequence and the levels each start a cache line, and the struct is
+// padded to whole lines, so nothing else shares them
+typedef struct {
+    _Alignas(64) _Atomic uint64_t sequence;  // odd while a publish is in progress
+    _Alignas(64) _Atomic uint64_t words[TOP_OF_BOOK_WORDS];
+} TopOfBook;
+
+void top_of_book_init(TopOfBook* top);
+
+// Writer side, single writer only
+void top_of_book_publish(TopOfBook* top, const TopOfBookSnapshot* snapshot);
+void top_of_book_publish_book(TopOfBook* top, const OrderBook* book);
+
+// Publishes an empty, out-of-sync snapshot: the book the levels came from
+// missed updates, so readers must not act on them until the next publish
+void top_of_book_publish_out_of_sync(TopOfBook* top, uint64_t last_update_id);
+
+// Returns 1 with a consistent copy, 0 if a publish raced with it
+int top_of_book_try_read(const TopOfBook* top, TopOfBookSnapshot* out);
+
+// Copies a consistent snapshot, returns the number of attempts it took
+int top_of_book_read(const TopOfBook* top, TopOfBookSnapshot* out);
+
+#endif // TOP_OF_BOOK_H
@@ -0,0 +1,82 @@
+// arena.c
+#include "../include/arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Block payload starts one cache line after the header
+#define ARENA_HEADER_SIZE 64
+
+static inline char* block_data(ArenaBlock* block) {
+    return (char*)block + ARENA_HEADER_SIZE;
+}
+
+void arena_init(Arena* arena, size_t block_size) {
+    arena->head = NULL;
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->allocated = 0;
+}
+
+static ArenaBlock* arena_new_block(Arena* arena, size_t min_size) {
+    size_t size = min_size > arena->block_size ? min_size : arena->block_size;
+    ArenaBlock* block = aligned_alloc(ARENA_HEADER_SIZE,
+                                      (ARENA_HEADER_SIZE + size + ARENA_HEADER_SIZE - 1) &
+                                      ~(size_t)(ARENA_HEADER_SIZE - 1));
+    if (!block) return NULL;
+
+    block->size = size;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+    return block;
+}
+
+void* arena_alloc(Arena* arena, size_t size, size_t align) {
+    ArenaBlock* block = arena->head;
+
+    if (block) {
+        uintptr_t base = (uintptr_t)block_data(block);
+        uintptr_t start = (base + block->used + align - 1) & ~(uintptr_t)(align - 1);
+        if (start + size <= base + block->size) {
+            arena->allocated += start + size - (base + block->used);
+            block->used = start + size - base;
+            return (void*)start;
+        }
+    }
+
+    // Block data is 64-byte aligned, enough for anything we store
+    block = arena_new_block(arena, size + (align > ARENA_HEADER_SIZE ? align : 0));
+    if (!block) return NULL;
+
+    uintptr_t base = (uintptr_t)block_data(block);
+    uintptr_t start = (base + align - 1) & ~(uintptr_t)(align - 1);
+    block->used = start + size - base;
+    arena->allocated += block->used;
+    return (void*)start;
+}
+
+void arena_reset(Arena* arena) {
+    ArenaBlock* keep = arena->head;
+    if (!keep) return;
+
+    ArenaBlock* block = keep->next;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+    arena->allocated = 0;
+}
+
+void arena_free(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->allocated = 0;
+}
@@ -1,12 +1,22 @@
+#define _GNU_SOURCE  // pthread_setaffinity_np
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 
-// Platform-specific SIMD headers
+#include "../include/fixed_point.h"
+#include "../include/json_loader.h"
+#include "../include/json_scan.h"
+#include "../include/cpu_features.h"
+#include "../include/book_scan.h"
+#include "../include/book_query.h"
+
+// Platform-specific SIMD headers. x86 kernels beyond SSE2 are compiled with
+// target attributes and only called if the CPU has them (section 5).
 #if defined(__x86_64__) || defined(_M_X64) || defined(__i386) || defined(_M_IX86)
-    #include <immintrin.h>  // For x86 AVX2/SSE
+    #include <immintrin.h>  // For x86 AVX2/AVX-512/SSE
     #define SIMD_X86
 #elif defined(__aarch64__) || defined(_M_ARM64)
     #include <arm_neon.h>   // For ARM NEON
@@ -24,6 +34,233 @@ typedef struct order {
     struct order* next;
 } order_t;
 
+// =============================================================================
+// SLAB ALLOCATOR (ORDERS, LEVELS AND NODES)
+// =============================================================================
+// Fixed-size objects are bump-allocated out of 2 MB slabs and recycled
+// through an intrusive free list, so the books below never call malloc on
+// their hot paths. A slab is one huge page when the system has them:
+// MAP_HUGETLB (reserved pages, vm.nr_hugepages) if asked for, otherwise
+// madvise(MADV_HUGEPAGE) so transparent huge pages can back it. Either way a
+// pool of a few thousand levels costs one TLB entry instead of hundreds.
+//
+// A pool is single-threaded. Threads sharing one go through a slab_cache_t
+// each, which moves SLAB_CACHE_BATCH objects at a time to and from the pool
+// under its lock.
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define SLAB_SIZE (2 * 1024 * 1024)
+#define SLAB_HEADER_SIZE 64             // objects start one cache line in
+#define SLAB_CACHE_BATCH 64
+
+typedef enum {
+    SLAB_PAGES_NORMAL,
+    SLAB_PAGES_THP,                     // madvise(MADV_HUGEPAGE)
+    SLAB_PAGES_HUGETLB                  // MAP_HUGETLB, THP if none are reserved
+} slab_pages_t;
+
+static const char* const slab_pages_names[] = { "normal", "thp", "hugetlb" };
+
+// Backing asked for by new slabs (benchmark --pages=normal|thp|hugetlb)
+static slab_pages_t slab_pages_wanted = SLAB_PAGES_THP;
+
+typedef struct slab {
+    struct slab* next;
+    slab_pages_t pages;                 // backing it actually got
+} slab_t;
+
+typedef struct {
+    size_t object_size;                 // multiple of 16, or of 64 from 64 up
+    char* cursor;                       // bump region of the current slab
+    char* end;
+    void* free_list;                    // chained through each object's first word
+    slab_t* slabs;                      // in use, newest first
+    slab_t* spare;                      // reserved, not started yet
+    size_t slab_count;
+    pthread_mutex_t lock;               // only taken by slab caches
+} slab_pool_t;
+
+typedef struct {
+    slab_pool_t* pool;
+    void* free_list;
+    int count;
+} slab_cache_t;
+
+// populate: fault the whole slab in now
+static slab_t* slab_map(int populate) {
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* memory = MAP_FAILED;
+    slab_pages_t pages = SLAB_PAGES_NORMAL;
+    
+#ifdef MAP_HUGETLB
+    if (slab_pages_wanted == SLAB_PAGES_HUGETLB) {
+        memory = mmap(NULL, SLAB_SIZE, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) pages = SLAB_PAGES_HUGETLB;
+    }
+#endif
+    if (memory == MAP_FAILED) {
+        // Over-map by a huge page so the slab can start on a 2 MB boundary
+        char* raw = mmap(NULL, 2 * SLAB_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (raw == MAP_FAILED) return NULL;
+        char* aligned = (char*)(((uintptr_t)raw + SLAB_SIZE - 1) & ~(uintptr_t)(SLAB_SIZE - 1));
+        if (aligned > raw) munmap(raw, aligned - raw);
+        munmap(aligned + SLAB_SIZE, raw + SLAB_SIZE - aligned);
+        memory = aligned;
+        
+#ifdef MADV_HUGEPAGE
+        if (slab_pages_wanted != SLAB_PAGES_NORMAL && madvise(memory, SLAB_SIZE, MADV_HUGEPAGE) == 0) {
+            pages = SLAB_PAGES_THP;
+        }
+#endif
+    }
+    if (populate) memset(memory, 0, SLAB_SIZE);
+    
+    slab_t* slab = memory;
+    slab->next = NULL;
+    slab->pages = pages;
+    return slab;
+}
+
+void slab_pool_init(slab_pool_t* pool, size_t object_size) {
+    memset(pool, 0, sizeof(*pool));
+    size_t align = object_size >= 64 ? 64 : 16;
+    pool->object_size = (object_size + align - 1) & ~(align - 1);
+    pthread_mutex_init(&pool->lock, NULL);
+}
+
+// Map and fault in enough slabs for count more objects, so a benchmark
+// doesn't time the page faults
+int slab_pool_reserve(slab_pool_t* pool, size_t count) {
+    size_t per_slab = (SLAB_SIZE - SLAB_HEADER_SIZE) / pool->object_size;
+    size_t available = (pool->end - pool->cursor) / pool->object_size;
+    for (slab_t* s = pool->spare; s; s = s->next) available += per_slab;
+    
+    while (available < count) {
+        slab_t* slab = slab_map(1);
+        if (!slab) return 0;
+        slab->next = pool->spare;
+        pool->spare = slab;
+        available += per_slab;
+    }
+    return 1;
+}
+
+// Objects handed out and not freed back to the pool (walks the free list)
+size_t slab_pool_in_use(const slab_pool_t* pool) {
+    size_t per_slab = (SLAB_SIZE - SLAB_HEADER_SIZE) / pool->object_size;
+    size_t in_use = pool->slab_count * per_slab;
+    if (pool->slabs) in_use -= (pool->end - pool->cursor) / pool->object_size;
+    for (void* object = pool->free_list; object; object = *(void**)object) in_use--;
+    return in_use;
+}
+
+void slab_pool_destroy(slab_pool_t* pool) {
+    for (int list = 0; list < 2; list++) {
+        slab_t* slab = list ? pool->spare : pool->slabs;
+        while (slab) {
+            slab_t* next = slab->next;
+            munmap(slab, SLAB_SIZE);
+            slab = next;
+        }
+    }
+    pthread_mutex_destroy(&pool->lock);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static void* slab_refill(slab_pool_t* pool) {
+    slab_t* slab = pool->spare;
+    if (slab) {
+        pool->spare = slab->next;
+    } else if (!(slab = slab_map(0))) {
+        return NULL;
+    }
+    
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->slab_count++;
+    pool->cursor = (char*)slab + SLAB_HEADER_SIZE;
+    pool->end = (char*)slab + SLAB_SIZE;
+    
+    void* object = pool->cursor;
+    pool->cursor += pool->object_size;
+    return object;
+}
+
+// Uninitialized object, NULL if out of memory
+static inline void* slab_alloc(slab_pool_t* pool) {
+    void* object = pool->free_list;
+    if (object) {
+        pool->free_list = *(void**)object;
+        return object;
+    }
+    if (pool->cursor + pool->object_size <= pool->end) {
+        object = pool->cursor;
+        pool->cursor += pool->object_size;
+        return object;
+    }
+    return slab_refill(pool);
+}
+
+static inline void slab_free(slab_pool_t* pool, void* object) {
+    *(void**)object = pool->free_list;
+    pool->free_list = object;
+}
+
+// Backing of the newest slab, what the pool is getting now
+static slab_pages_t slab_pool_pages(const slab_pool_t* pool) {
+    return pool->slabs ? pool->slabs->pages : pool->spare ? pool->spare->pages : SLAB_PAGES_NORMAL;
+}
+
+void slab_cache_init(slab_cache_t* cache, slab_pool_t* pool) {
+    cache->pool = pool;
+    cache->free_list = NULL;
+    cache->count = 0;
+}
+
+void* slab_cache_alloc(slab_cache_t* cache) {
+    if (!cache->free_list) {
+        pthread_mutex_lock(&cache->pool->lock);
+        while (cache->count < SLAB_CACHE_BATCH) {
+            void* object = slab_alloc(cache->pool);
+            if (!object) break;
+            *(void**)object = cache->free_list;
+            cache->free_list = object;
+            cache->count++;
+        }
+        pthread_mutex_unlock(&cache->pool->lock);
+        if (!cache->free_list) return NULL;
+    }
+    
+    void* object = cache->free_list;
+    cache->free_list = *(void**)object;
+    cache->count--;
+    return object;
+}
+
+// Hand objects back to the pool down to keep of them
+static void slab_cache_trim(slab_cache_t* cache, int keep) {
+    pthread_mutex_lock(&cache->pool->lock);
+    while (cache->count > keep) {
+        void* object = cache->free_list;
+        cache->free_list = *(void**)object;
+        cache->count--;
+        slab_free(cache->pool, object);
+    }
+    pthread_mutex_unlock(&cache->pool->lock);
+}
+
+void slab_cache_free(slab_cache_t* cache, void* object) {
+    *(void**)object = cache->free_list;
+    cache->free_list = object;
+    if (++cache->count >= 2 * SLAB_CACHE_BATCH) slab_cache_trim(cache, SLAB_CACHE_BATCH);
+}
+
+// Before the thread exits
+void slab_cache_flush(slab_cache_t* cache) {
+    if (cache->count) slab_cache_trim(cache, 0);
+}
+
 // =============================================================================
 // 1. SIMPLE LINKED LIST IMPLEMENTATION
 // =============================================================================
@@ -37,8 +274,20 @@ typedef struct price_level {
 typedef struct simple_book {
     price_level_t* bids;    // Sorted descending (highest first)
     price_level_t* asks;    // Sorted ascending (lowest first)
+    slab_pool_t levels;
 } simple_book_t;
 
+void simple_book_init(simple_book_t* book) {
+    book->bids = book->asks = NULL;
+    slab_pool_init(&book->levels, sizeof(price_level_t));
+}
+
+// Levels go back with their slabs; orders belong to the caller
+void simple_book_free(simple_book_t* book) {
+    slab_pool_destroy(&book->levels);
+    book->bids = book->asks = NULL;
+}
+
 // Simple insertion - O(n) worst case
 void simple_insert_order(simple_book_t* book, order_t* order, int is_bid) {
     price_level_t** head = is_bid ? &book->bids : &book->asks;
@@ -62,7 +311,7 @@ void simple_insert_order(simple_book_t* book, order_t* order, int is_bid) {
     }
     
     // Create new price level
-    price_level_t* new_level = malloc(sizeof(price_level_t));
+    price_level_t* new_level = slab_alloc(&book->levels);
     new_level->price = order->price;
     new_level->total_quantity = order->quantity;
     new_level->orders = order;
@@ -73,103 +322,396 @@ void simple_insert_order(simple_book_t* book, order_t* order, int is_bid) {
     else *head = new_level;
 }
 
+// Remove a whole price level - O(n) search, O(1) unlink
+int simple_delete_level(simple_book_t* book, uint64_t price, int is_bid) {
+    price_level_t** link = is_bid ? &book->bids : &book->asks;
+    
+    while (*link && 
+           ((is_bid && (*link)->price > price) || 
+            (!is_bid && (*link)->price < price))) {
+        link = &(*link)->next;
+    }
+    
+    if (!*link || (*link)->price != price) return 0;
+    
+    price_level_t* level = *link;
+    *link = level->next;
+    slab_free(&book->levels, level);
+    return 1;
+}
+
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it
+void simple_update_level(simple_book_t* book, uint64_t price, uint32_t quantity, int is_bid) {
+    if (quantity == 0) {
+        simple_delete_level(book, price, is_bid);
+        return;
+    }
+    
+    price_level_t** link = is_bid ? &book->bids : &book->asks;
+    
+    while (*link && 
+           ((is_bid && (*link)->price > price) || 
+            (!is_bid && (*link)->price < price))) {
+        link = &(*link)->next;
+    }
+    
+    if (*link && (*link)->price == price) {
+        (*link)->total_quantity = quantity;
+        return;
+    }
+    
+    price_level_t* new_level = slab_alloc(&book->levels);
+    new_level->price = price;
+    new_level->total_quantity = quantity;
+    new_level->orders = NULL;
+    new_level->next = *link;
+    *link = new_level;
+}
+
+// Take quantity off the order with this id (L3 semantics), removing the
+// order once it reaches zero and the level once it has no orders.
+// No order index: walks every order on both sides - O(orders).
+// Returns the quantity removed, 0 if the id is unknown.
+uint32_t simple_reduce_order(simple_book_t* book, uint64_t id, uint32_t quantity) {
+    for (int side = 0; side < 2; side++) {
+        price_level_t** level_link = side ? &book->asks : &book->bids;
+        
+        for (; *level_link; level_link = &(*level_link)->next) {
+            price_level_t* level = *level_link;
+            
+            for (order_t** link = &level->orders; *link; link = &(*link)->next) {
+                order_t* order = *link;
+                if (order->id != id) continue;
+                
+                uint32_t removed = quantity < order->quantity ? quantity : order->quantity;
+                order->quantity -= removed;
+                level->total_quantity -= removed;
+                if (order->quantity == 0) *link = order->next;
+                if (!level->orders) {
+                    *level_link = level->next;
+                    slab_free(&book->levels, level);
+                }
+                return removed;
+            }
+        }
+    }
+    return 0;
+}
+
 // =============================================================================
 // 2. ARRAY-BASED IMPLEMENTATION (CACHE-FRIENDLY)
 // =============================================================================
 #define MAX_PRICE_LEVELS 1000
-#define ORDERS_PER_LEVEL 64
+#define ARRAY_CHUNK_ORDERS 7            // 16 + 7 * 32 bytes, one 256-byte pool object
 
+// A level's orders, oldest first, in fixed-size chunks chained from the level:
+// appends go to the last chunk, fills consume from the first
+typedef struct array_order_chunk {
+    struct array_order_chunk* next;
+    uint32_t head;                     // first order not filled yet
+    uint32_t tail;                     // one past the newest order
+    order_t orders[ARRAY_CHUNK_ORDERS];
+} array_order_chunk_t;
+
+// Cold part of a level, 24 bytes: only touched once the search has found it
 typedef struct {
-    uint64_t price;
     uint32_t count;
     uint32_t total_quantity;
-    order_t orders[ORDERS_PER_LEVEL];  // Fixed-size array for cache locality
+    array_order_chunk_t* first;
+    array_order_chunk_t* last;
 } array_price_level_t;
 
+// Levels are stored worst-to-best: bids ascending, asks descending, so the
+// best price is the last element. Most updates land near the touch, and
+// inserting/deleting there only shifts the few levels above it.
+//
+// Prices live in their own dense arrays (hot), parallel to the level records
+// (cold): the binary search reads 8 prices per cache line instead of one
+// record each, and the whole index of a 1000-level side is 8 KB.
 typedef struct {
+    uint64_t bid_prices[MAX_PRICE_LEVELS];
+    uint64_t ask_prices[MAX_PRICE_LEVELS];
     array_price_level_t bids[MAX_PRICE_LEVELS];
     array_price_level_t asks[MAX_PRICE_LEVELS];
     int bid_count;
     int ask_count;
+    slab_pool_t chunks;
 } array_book_t;
 
-// Binary search for price level - O(log n)
-int find_price_level(array_price_level_t* levels, int count, uint64_t price, int is_bid) {
-    int left = 0, right = count - 1;
+void array_book_init(array_book_t* book) {
+    book->bid_count = book->ask_count = 0;
+    slab_pool_init(&book->chunks, sizeof(array_order_chunk_t));
+}
+
+void array_book_free(array_book_t* book) {
+    slab_pool_destroy(&book->chunks);
+    book->bid_count = book->ask_count = 0;
+}
+
+// Queue an order at the back of a level; 0 if out of memory
+static inline int array_level_append(array_book_t* book, array_price_level_t* level, const order_t* order) {
+    array_order_chunk_t* chunk = level->last;
+    
+    if (!chunk || chunk->tail == ARRAY_CHUNK_ORDERS) {
+        chunk = slab_alloc(&book->chunks);
+        if (!chunk) return 0;
+        chunk->next = NULL;
+        chunk->head = chunk->tail = 0;
+        if (level->last) level->last->next = chunk; else level->first = chunk;
+        level->last = chunk;
+    }
     
-    while (left <= right) {
-        int mid = (left + right) / 2;
-        uint64_t mid_price = levels[mid].price;
-        
-        if (mid_price == price) return mid;
-        
-        if ((is_bid && mid_price > price) || (!is_bid && mid_price < price)) {
-            left = mid + 1;
-        } else {
-            right = mid - 1;
-        }
+    chunk->orders[chunk->tail++] = *order;
+    level->count++;
+    level->total_quantity += order->quantity;
+    return 1;
+}
+
+static inline void array_level_release(array_book_t* book, array_price_level_t* level) {
+    array_order_chunk_t* chunk = level->first;
+    while (chunk) {
+        array_order_chunk_t* next = chunk->next;
+        slab_free(&book->chunks, chunk);
+        chunk = next;
+    }
+}
+
+#define ARRAY_BEST_BID_PRICE(book) ((book)->bid_prices[(book)->bid_count - 1])
+#define ARRAY_BEST_ASK_PRICE(book) ((book)->ask_prices[(book)->ask_count - 1])
+
+// Number of prices ordered strictly before price (ascending for bids,
+// descending for asks), i.e. where price is or would go. Branchless: the loop runs exactly
+// log2(count) times and each step is a conditional move, so the search never
+// mispredicts on random prices.
+static inline __attribute__((always_inline))
+int array_lower_bound(const uint64_t* prices, int count, uint64_t price, int ascending) {
+    if (count == 0) return 0;
+    const uint64_t* base = prices;
+    while (count > 1) {
+        int half = count / 2;
+        uint64_t p = base[half - 1];
+        base += (ascending ? p < price : p > price) ? half : 0;
+        count -= half;
     }
-    return -(left + 1);  // Negative insertion point
+    return (int)(base - prices) + (ascending ? *base < price : *base > price);
+}
+
+// find_price_level without the touch scan: binary search only
+int binary_find_price_level(const uint64_t* prices, int count, uint64_t price, int is_bid) {
+    int pos = is_bid ? array_lower_bound(prices, count, price, 1)
+                     : array_lower_bound(prices, count, price, 0);
+    if (pos < count && prices[pos] == price) return pos;
+    return -(pos + 1);
+}
+
+int simd_lower_bound(const uint64_t* prices, int count, uint64_t target, int ascending);  // section 5
+
+#define ARRAY_TOUCH_LEVELS 32
+
+// Search of a side's price index - O(log n) worst case. Most updates land
+// within a few levels of the touch (the end of the index): a price among the
+// last ARRAY_TOUCH_LEVELS is found by a backwards vector scan, which stops
+// after the block holding it, anything deeper by binary search of the rest.
+int find_price_level(const uint64_t* prices, int count, uint64_t price, int is_bid) {
+    int start = count - ARRAY_TOUCH_LEVELS;
+    int pos;
+    
+    if (start <= 0) {
+        pos = simd_lower_bound(prices, count, price, is_bid);
+    } else if (is_bid ? prices[start - 1] < price : prices[start - 1] > price) {
+        pos = start + simd_lower_bound(prices + start, ARRAY_TOUCH_LEVELS, price, is_bid);
+    } else {
+        pos = is_bid ? array_lower_bound(prices, start, price, 1)
+                     : array_lower_bound(prices, start, price, 0);
+    }
+    
+    if (pos < count && prices[pos] == price) return pos;
+    return -(pos + 1);  // Negative insertion point
+}
+
+// Make room for a level at pos, keeping the price index and records in step
+static inline void array_open_slot(uint64_t* prices, array_price_level_t* levels, int count, int pos) {
+    memmove(&prices[pos + 1], &prices[pos], (count - pos) * sizeof(uint64_t));
+    memmove(&levels[pos + 1], &levels[pos], (count - pos) * sizeof(array_price_level_t));
+}
+
+static inline void array_close_slot(uint64_t* prices, array_price_level_t* levels, int count, int pos) {
+    memmove(&prices[pos], &prices[pos + 1], (count - pos - 1) * sizeof(uint64_t));
+    memmove(&levels[pos], &levels[pos + 1], (count - pos - 1) * sizeof(array_price_level_t));
 }
 
 void array_insert_order(array_book_t* book, order_t* order, int is_bid) {
+    uint64_t* prices = is_bid ? book->bid_prices : book->ask_prices;
     array_price_level_t* levels = is_bid ? book->bids : book->asks;
     int* count = is_bid ? &book->bid_count : &book->ask_count;
     
-    int pos = find_price_level(levels, *count, order->price, is_bid);
+    int pos = find_price_level(prices, *count, order->price, is_bid);
     
     if (pos >= 0) {
         // Price level exists
-        if (levels[pos].count < ORDERS_PER_LEVEL) {
-            levels[pos].orders[levels[pos].count++] = *order;
-            levels[pos].total_quantity += order->quantity;
-        }
+        array_level_append(book, &levels[pos], order);
     } else {
         // Insert new price level
         pos = -(pos + 1);
         if (*count < MAX_PRICE_LEVELS) {
-            // Shift elements
-            memmove(&levels[pos + 1], &levels[pos], 
-                   (*count - pos) * sizeof(array_price_level_t));
+            // Shift the (better) levels above the insertion point
+            array_open_slot(prices, levels, *count, pos);
             
-            levels[pos].price = order->price;
-            levels[pos].count = 1;
-            levels[pos].total_quantity = order->quantity;
-            levels[pos].orders[0] = *order;
+            prices[pos] = order->price;
+            levels[pos] = (array_price_level_t){ 0 };
+            array_level_append(book, &levels[pos], order);
             (*count)++;
         }
     }
 }
 
+// Remove a whole price level - O(log n) search + shift of the better levels
+int array_delete_level(array_book_t* book, uint64_t price, int is_bid) {
+    uint64_t* prices = is_bid ? book->bid_prices : book->ask_prices;
+    array_price_level_t* levels = is_bid ? book->bids : book->asks;
+    int* count = is_bid ? &book->bid_count : &book->ask_count;
+    
+    int pos = find_price_level(prices, *count, price, is_bid);
+    if (pos < 0) return 0;
+    
+    array_level_release(book, &levels[pos]);
+    array_close_slot(prices, levels, *count, pos);
+    (*count)--;
+    return 1;
+}
+
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it
+void array_update_level(array_book_t* book, uint64_t price, uint32_t quantity, int is_bid) {
+    if (quantity == 0) {
+        array_delete_level(book, price, is_bid);
+        return;
+    }
+    
+    uint64_t* prices = is_bid ? book->bid_prices : book->ask_prices;
+    array_price_level_t* levels = is_bid ? book->bids : book->asks;
+    int* count = is_bid ? &book->bid_count : &book->ask_count;
+    
+    int pos = find_price_level(prices, *count, price, is_bid);
+    if (pos >= 0) {
+        levels[pos].total_quantity = quantity;
+        return;
+    }
+    
+    pos = -(pos + 1);
+    if (*count < MAX_PRICE_LEVELS) {
+        array_open_slot(prices, levels, *count, pos);
+        
+        prices[pos] = price;
+        levels[pos] = (array_price_level_t){ .total_quantity = quantity };
+        (*count)++;
+    }
+}
+
 // =============================================================================
 // 3. SKIP LIST IMPLEMENTATION (PROBABILISTIC)
 // =============================================================================
+// Nodes only carry the forward pointers of their own height (1.33 on
+// average with p = 1/4) and are carved out of 64 KB chunks from a slab
+// pool, with one free list per height, so a delete followed by an insert
+// reuses the same memory.
 #define MAX_SKIP_LEVEL 16
+#define SKIP_SLAB_SIZE (64 * 1024)
 
 typedef struct skip_node {
     uint64_t price;
     uint32_t total_quantity;
+    uint32_t level;
     order_t* orders;
-    struct skip_node* forward[MAX_SKIP_LEVEL];
-    int level;
+    struct skip_node* forward[];   // level entries
 } skip_node_t;
 
 typedef struct {
-    skip_node_t* header;
+    skip_node_t* header;            // MAX_SKIP_LEVEL forward pointers
     int level;
+    int count;
 } skip_list_t;
 
 typedef struct {
     skip_list_t bids;   // Descending order
     skip_list_t asks;   // Ascending order
+    slab_pool_t chunks; // SKIP_SLAB_SIZE each, nodes of any height are carved out of them
+    char* chunk;
+    size_t chunk_used;
+    skip_node_t* free_nodes[MAX_SKIP_LEVEL + 1];   // by height, chained through forward[0]
+    uint64_t rng;
 } skip_book_t;
 
-int random_level() {
-    int level = 1;
-    while ((rand() & 0xFFFF) < (0xFFFF >> 2) && level < MAX_SKIP_LEVEL) {
-        level++;
+static inline size_t skip_node_size(int level) {
+    return sizeof(skip_node_t) + level * sizeof(skip_node_t*);
+}
+
+static skip_node_t* skip_alloc_node(skip_book_t* book, int level) {
+    skip_node_t* node = book->free_nodes[level];
+    
+    if (node) {
+        book->free_nodes[level] = node->forward[0];
+    } else {
+        size_t size = skip_node_size(level);
+        if (!book->chunk || book->chunk_used + size > SKIP_SLAB_SIZE) {
+            book->chunk = slab_alloc(&book->chunks);
+            if (!book->chunk) return NULL;
+            book->chunk_used = 0;
+        }
+        node = (skip_node_t*)(book->chunk + book->chunk_used);
+        book->chunk_used += size;   // sizes are multiples of 8
+    }
+    
+    memset(node, 0, skip_node_size(level));
+    node->level = level;
+    return node;
+}
+
+static inline void skip_free_node(skip_book_t* book, skip_node_t* node) {
+    node->forward[0] = book->free_nodes[node->level];
+    book->free_nodes[node->level] = node;
+}
+
+// xorshift64: each pair of trailing zero bits promotes one level (p = 1/4)
+static inline int skip_random_level(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return 1 + __builtin_ctzll(x | (1ULL << (2 * (MAX_SKIP_LEVEL - 1)))) / 2;
+}
+
+int skip_book_init(skip_book_t* book) {
+    memset(book, 0, sizeof(*book));
+    slab_pool_init(&book->chunks, SKIP_SLAB_SIZE);
+    book->rng = 0x9E3779B97F4A7C15ULL;
+    book->bids.header = skip_alloc_node(book, MAX_SKIP_LEVEL);
+    book->asks.header = skip_alloc_node(book, MAX_SKIP_LEVEL);
+    book->bids.level = book->asks.level = 1;
+    return book->bids.header && book->asks.header;
+}
+
+void skip_book_free(skip_book_t* book) {
+    slab_pool_destroy(&book->chunks);
+    memset(book, 0, sizeof(*book));
+}
+
+// Fill update[i] with the last node at level i ordered before price
+static inline skip_node_t* skip_find_predecessors(skip_list_t* list, uint64_t price, int is_bid,
+                                                  skip_node_t** update) {
+    skip_node_t* current = list->header;
+    
+    for (int i = list->level - 1; i >= 0; i--) {
+        while (current->forward[i] &&
+               ((is_bid && current->forward[i]->price > price) ||
+                (!is_bid && current->forward[i]->price < price))) {
+            current = current->forward[i];
+        }
+        update[i] = current;
     }
-    return level;
+    return current->forward[0];
 }
 
 skip_node_t* skip_search(skip_list_t* list, uint64_t price, int is_bid) {
@@ -187,6 +729,71 @@ skip_node_t* skip_search(skip_list_t* list, uint64_t price, int is_bid) {
     return (current && current->price == price) ? current : NULL;
 }
 
+// Level at price, created empty if needed; NULL only if out of memory
+static skip_node_t* skip_find_or_insert(skip_book_t* book, uint64_t price, int is_bid) {
+    skip_list_t* list = is_bid ? &book->bids : &book->asks;
+    skip_node_t* update[MAX_SKIP_LEVEL];
+    skip_node_t* node = skip_find_predecessors(list, price, is_bid, update);
+    
+    if (node && node->price == price) return node;
+    
+    int level = skip_random_level(&book->rng);
+    node = skip_alloc_node(book, level);
+    if (!node) return NULL;
+    
+    for (int i = list->level; i < level; i++) {
+        update[i] = list->header;
+    }
+    if (level > list->level) list->level = level;
+    
+    node->price = price;
+    for (int i = 0; i < level; i++) {
+        node->forward[i] = update[i]->forward[i];
+        update[i]->forward[i] = node;
+    }
+    list->count++;
+    return node;
+}
+
+int skip_delete_level(skip_book_t* book, uint64_t price, int is_bid) {
+    skip_list_t* list = is_bid ? &book->bids : &book->asks;
+    skip_node_t* update[MAX_SKIP_LEVEL];
+    skip_node_t* node = skip_find_predecessors(list, price, is_bid, update);
+    
+    if (!node || node->price != price) return 0;
+    
+    for (int i = 0; i < (int)node->level; i++) {
+        update[i]->forward[i] = node->forward[i];
+    }
+    while (list->level > 1 && !list->header->forward[list->level - 1]) {
+        list->level--;
+    }
+    list->count--;
+    skip_free_node(book, node);
+    return 1;
+}
+
+void skip_insert_order(skip_book_t* book, order_t* order, int is_bid) {
+    skip_node_t* node = skip_find_or_insert(book, order->price, is_bid);
+    if (!node) return;
+    
+    order->next = node->orders;
+    node->orders = order;
+    node->total_quantity += order->quantity;
+}
+
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it
+void skip_update_level(skip_book_t* book, uint64_t price, uint32_t quantity, int is_bid) {
+    if (quantity == 0) {
+        skip_delete_level(book, price, is_bid);
+        return;
+    }
+    
+    skip_node_t* node = skip_find_or_insert(book, price, is_bid);
+    if (node) node->total_quantity = quantity;
+}
+
 // =============================================================================
 // 4. MEMORY-MAPPED PRICE ARRAY (ULTRA-FAST)
 // =============================================================================
@@ -200,13 +807,116 @@ typedef struct {
     order_t* first_order;
 } direct_price_level_t;
 
+// Hierarchical occupancy bitmap over prices: bit p of level 0 is set when
+// price p has quantity, bit w of level 1 when word w of level 0 is non-zero,
+// and so on. Finding the next/previous occupied price is one ctz/clz per
+// level (tzcnt/lzcnt on x86, rbit+clz on ARM) instead of a walk over empty
+// slots: 1M prices = 15625 + 245 + 4 words.
+#define BITMAP_LEVELS 3
+
+typedef struct {
+    uint64_t* words[BITMAP_LEVELS];
+    uint32_t word_count[BITMAP_LEVELS];
+} price_bitmap_t;
+
+int price_bitmap_init(price_bitmap_t* bm, uint64_t bits) {
+    for (int l = 0; l < BITMAP_LEVELS; l++) {
+        bm->word_count[l] = (bits + 63) / 64;
+        bm->words[l] = calloc(bm->word_count[l], sizeof(uint64_t));
+        if (!bm->words[l]) return 0;
+        bits = bm->word_count[l];
+    }
+    return 1;
+}
+
+void price_bitmap_free(price_bitmap_t* bm) {
+    for (int l = 0; l < BITMAP_LEVELS; l++) {
+        free(bm->words[l]);
+        bm->words[l] = NULL;
+    }
+}
+
+static inline void price_bitmap_set(price_bitmap_t* bm, uint64_t i) {
+    for (int l = 0; l < BITMAP_LEVELS; l++) {
+        uint64_t word = bm->words[l][i >> 6];
+        bm->words[l][i >> 6] = word | (1ULL << (i & 63));
+        if (word) return;  // upper levels already flag this word
+        i >>= 6;
+    }
+}
+
+static inline void price_bitmap_clear(price_bitmap_t* bm, uint64_t i) {
+    for (int l = 0; l < BITMAP_LEVELS; l++) {
+        bm->words[l][i >> 6] &= ~(1ULL << (i & 63));
+        if (bm->words[l][i >> 6]) return;  // word still occupied
+        i >>= 6;
+    }
+}
+
+// Lowest set bit >= i, -1 if none
+static inline int64_t price_bitmap_next(const price_bitmap_t* bm, uint64_t i) {
+    for (int l = 0; l < BITMAP_LEVELS; l++) {
+        uint64_t w = i >> 6;
+        if (w >= bm->word_count[l]) return -1;
+        
+        uint64_t mask = bm->words[l][w] & (~0ULL << (i & 63));
+        // The top level is small enough to scan
+        while (!mask && l == BITMAP_LEVELS - 1 && w + 1 < bm->word_count[l]) {
+            mask = bm->words[l][++w];
+        }
+        if (mask) {
+            uint64_t found = (w << 6) + __builtin_ctzll(mask);
+            while (l-- > 0) {
+                found = (found << 6) + __builtin_ctzll(bm->words[l][found]);
+            }
+            return found;
+        }
+        i = w + 1;
+    }
+    return -1;
+}
+
+// Highest set bit <= i, -1 if none
+static inline int64_t price_bitmap_prev(const price_bitmap_t* bm, uint64_t i) {
+    for (int l = 0; l < BITMAP_LEVELS; l++) {
+        uint64_t w = i >> 6;
+        if (w >= bm->word_count[l]) {
+            w = bm->word_count[l] - 1;
+            i = (w << 6) | 63;
+        }
+        
+        uint64_t mask = bm->words[l][w] & (~0ULL >> (63 - (i & 63)));
+        while (!mask && l == BITMAP_LEVELS - 1 && w > 0) {
+            mask = bm->words[l][--w];
+        }
+        if (mask) {
+            uint64_t found = (w << 6) + 63 - __builtin_clzll(mask);
+            while (l-- > 0) {
+                found = (found << 6) + 63 - __builtin_clzll(bm->words[l][found]);
+            }
+            return found;
+        }
+        if (w == 0) return -1;
+        i = w - 1;
+    }
+    return -1;
+}
+
 typedef struct {
     direct_price_level_t* bid_levels;    // Array indexed by (offset - price)
     direct_price_level_t* ask_levels;    // Array indexed by (price - offset)
     uint64_t bid_top;                    // Highest bid price seen
     uint64_t ask_top;                    // Lowest ask price seen
+    // Optional: occupied prices (indexed by price on both sides); without
+    // them a delete at the top rescans the level array for the new best
+    price_bitmap_t bid_bitmap;
+    price_bitmap_t ask_bitmap;
 } direct_book_t;
 
+static inline int direct_has_bitmaps(const direct_book_t* book) {
+    return book->bid_bitmap.words[0] != NULL;
+}
+
 // O(1) insertion!
 void direct_insert_order(direct_book_t* book, order_t* order, int is_bid) {
     direct_price_level_t* level;
@@ -226,6 +936,72 @@ void direct_insert_order(direct_book_t* book, order_t* order, int is_bid) {
     level->first_order = order;
     level->total_quantity += order->quantity;
     level->order_count++;
+    
+    if (direct_has_bitmaps(book)) {
+        price_bitmap_set(is_bid ? &book->bid_bitmap : &book->ask_bitmap, order->price);
+    }
+}
+
+// Level slot for a price, NULL outside the mapped range
+static inline direct_price_level_t* direct_level(direct_book_t* book, uint64_t price, int is_bid) {
+    if (is_bid) {
+        return price < PRICE_OFFSET ? &book->bid_levels[PRICE_OFFSET - price] : NULL;
+    }
+    return price < PRICE_RANGE ? &book->ask_levels[price] : NULL;
+}
+
+// O(1) removal. When the best level goes away the new best price comes from
+// the occupancy bitmap if the book has one, otherwise from scanning the array
+int direct_delete_level(direct_book_t* book, uint64_t price, int is_bid) {
+    direct_price_level_t* level = direct_level(book, price, is_bid);
+    if (!level || level->total_quantity == 0) return 0;
+    
+    level->total_quantity = 0;
+    level->order_count = 0;
+    level->first_order = NULL;
+    
+    if (direct_has_bitmaps(book)) {
+        price_bitmap_t* bm = is_bid ? &book->bid_bitmap : &book->ask_bitmap;
+        price_bitmap_clear(bm, price);
+        if (is_bid && price == book->bid_top) {
+            int64_t p = price > 0 ? price_bitmap_prev(bm, price - 1) : -1;
+            book->bid_top = p > 0 ? p : 0;
+        } else if (!is_bid && price == book->ask_top) {
+            int64_t p = price_bitmap_next(bm, price + 1);
+            book->ask_top = p > 0 ? p : 0;
+        }
+        return 1;
+    }
+    
+    if (is_bid && price == book->bid_top) {
+        uint64_t p = price;
+        while (p > 0 && book->bid_levels[PRICE_OFFSET - p].total_quantity == 0) p--;
+        book->bid_top = p;
+    } else if (!is_bid && price == book->ask_top) {
+        uint64_t p = price;
+        while (p < PRICE_RANGE && book->ask_levels[p].total_quantity == 0) p++;
+        book->ask_top = p < PRICE_RANGE ? p : 0;
+    }
+    return 1;
+}
+
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it
+void direct_update_level(direct_book_t* book, uint64_t price, uint32_t quantity, int is_bid) {
+    if (quantity == 0) {
+        direct_delete_level(book, price, is_bid);
+        return;
+    }
+    
+    direct_price_level_t* level = direct_level(book, price, is_bid);
+    if (!level) return;  // Invalid price
+    
+    if (level->total_quantity == 0 && direct_has_bitmaps(book)) {
+        price_bitmap_set(is_bid ? &book->bid_bitmap : &book->ask_bitmap, price);
+    }
+    level->total_quantity = quantity;
+    if (is_bid && price > book->bid_top) book->bid_top = price;
+    if (!is_bid && (price < book->ask_top || book->ask_top == 0)) book->ask_top = price;
 }
 
 // =============================================================================
@@ -234,6 +1010,7 @@ void direct_insert_order(direct_book_t* book, order_t* order, int is_bid) {
 
 #ifdef SIMD_X86
 // x86 AVX2 implementation
+__attribute__((target("avx2")))
 int simd_find_price_x86(uint64_t* prices, int count, uint64_t target) {
     __m256i target_vec = _mm256_set1_epi64x(target);
     
@@ -255,6 +1032,7 @@ int simd_find_price_x86(uint64_t* prices, int count, uint64_t target) {
     return -1;
 }
 
+__attribute__((target("avx2")))
 uint64_t simd_sum_quantities_x86(uint32_t* quantities, int count) {
     __m256i sum_vec = _mm256_setzero_si256();
     
@@ -336,32 +1114,180 @@ uint64_t simd_sum_quantities_generic(uint32_t* quantities, int count) {
     return sum;
 }
 
-// Platform-agnostic wrapper functions
-int simd_find_price(uint64_t* prices, int count, uint64_t target) {
-#ifdef SIMD_X86
-    return simd_find_price_x86(prices, count, target);
-#elif defined(SIMD_ARM)
-    return simd_find_price_arm(prices, count, target);
-#else
-    return simd_find_price_generic(prices, count, target);
-#endif
+// Ordered search over a sorted price column: the bound is the number of
+// prices ordered before target, i.e. where target is or would be inserted.
+// "Before" is < for ascending columns (bids), > for descending ones (asks);
+// an upper bound also counts prices equal to target. The columns are stored
+// worst-to-best, so the kernels scan backwards from the touch: the cost is
+// proportional to how far from the best price target lands.
+static inline int bound_before(uint64_t price, uint64_t target, int ascending, int upper) {
+    if (ascending) return upper ? price <= target : price < target;
+    return upper ? price >= target : price > target;
 }
 
-uint64_t simd_sum_quantities(uint32_t* quantities, int count) {
-#ifdef SIMD_X86
-    return simd_sum_quantities_x86(quantities, count);
+int simd_bound_generic(const uint64_t* prices, int count, uint64_t target, int ascending, int upper) {
+    int i = count;
+    while (i > 0 && !bound_before(prices[i - 1], target, ascending, upper)) i--;
+    return i;
+}
+
+#ifdef SIMD_X86
+// AVX2: 4 prices per compare. The prices before target are a prefix of the
+// column, so a block holding any of them ends the scan.
+__attribute__((target("avx2")))
+int simd_bound_x86(const uint64_t* prices, int count, uint64_t target, int ascending, int upper) {
+    // Only a signed 64-bit compare exists: flipping the sign bit maps
+    // unsigned order onto signed order
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i target_vec = _mm256_xor_si256(_mm256_set1_epi64x((long long)target), sign);
+    int i = count;
+    
+    for (; i >= 4; i -= 4) {
+        __m256i prices_vec = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&prices[i - 4]), sign);
+        // before = target > price (ascending lower), price > target (descending
+        // lower), and the complement of the other compare for upper bounds
+        __m256i cmp = ascending != upper ? _mm256_cmpgt_epi64(target_vec, prices_vec)
+                                         : _mm256_cmpgt_epi64(prices_vec, target_vec);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+        if (upper) mask ^= 0xF;
+        if (mask) return i - 4 + __builtin_popcount(mask);
+    }
+    return simd_bound_generic(prices, i, target, ascending, upper);
+}
+
+// AVX-512: 8 prices per compare, with native unsigned compares into a mask
+__attribute__((target("avx512f")))
+int simd_bound_x86_avx512(const uint64_t* prices, int count, uint64_t target, int ascending, int upper) {
+    __m512i target_vec = _mm512_set1_epi64((long long)target);
+    int i = count;
+    
+    for (; i >= 8; i -= 8) {
+        __m512i prices_vec = _mm512_loadu_si512(&prices[i - 8]);
+        __mmask8 mask = ascending
+            ? (upper ? _mm512_cmple_epu64_mask(prices_vec, target_vec)
+                     : _mm512_cmplt_epu64_mask(prices_vec, target_vec))
+            : (upper ? _mm512_cmpge_epu64_mask(prices_vec, target_vec)
+                     : _mm512_cmpgt_epu64_mask(prices_vec, target_vec));
+        if (mask) return i - 8 + __builtin_popcount(mask);
+    }
+    return simd_bound_generic(prices, i, target, ascending, upper);
+}
+#endif
+
+#ifdef SIMD_ARM
+// NEON: two 2-lane compares per step. A matching lane is all ones (-1), so
+// the negated lane sum counts the prices before target.
+int simd_bound_arm(const uint64_t* prices, int count, uint64_t target, int ascending, int upper) {
+    uint64x2_t target_vec = vdupq_n_u64(target);
+    int i = count;
+    
+    for (; i >= 4; i -= 4) {
+        uint64x2_t low = vld1q_u64(&prices[i - 4]);
+        uint64x2_t high = vld1q_u64(&prices[i - 2]);
+        uint64x2_t low_before, high_before;
+        if (ascending) {
+            low_before = upper ? vcleq_u64(low, target_vec) : vcltq_u64(low, target_vec);
+            high_before = upper ? vcleq_u64(high, target_vec) : vcltq_u64(high, target_vec);
+        } else {
+            low_before = upper ? vcgeq_u64(low, target_vec) : vcgtq_u64(low, target_vec);
+            high_before = upper ? vcgeq_u64(high, target_vec) : vcgtq_u64(high, target_vec);
+        }
+        int before = (int)(0 - vaddvq_u64(vaddq_u64(low_before, high_before)));
+        if (before) return i - 4 + before;
+    }
+    return simd_bound_generic(prices, i, target, ascending, upper);
+}
+#endif
+
+// Kernel per function, generic until simd_dispatch_init has probed the CPU.
+// Every kernel is compiled in, so one binary runs on any x86-64 (and uses
+// AVX-512 where present) instead of faulting where AVX2 is missing.
+typedef struct {
+    int (*find_price)(uint64_t* prices, int count, uint64_t target);
+    uint64_t (*sum_quantities)(uint32_t* quantities, int count);
+    int (*bound)(const uint64_t* prices, int count, uint64_t target, int ascending, int upper);
+    const char* find_price_kernel;
+    const char* sum_quantities_kernel;
+    const char* bound_kernel;
+} simd_dispatch_t;
+
+static simd_dispatch_t simd_dispatch = {
+    simd_find_price_generic, simd_sum_quantities_generic, simd_bound_generic,
+    "generic", "generic", "generic"
+};
+
+// Runs before main, while the process is still single-threaded
+__attribute__((constructor)) static void simd_dispatch_init(void) {
+    const CpuFeatures* cpu = cpu_features();
+#ifdef SIMD_X86
+    if (cpu->avx2) {
+        simd_dispatch = (simd_dispatch_t){ simd_find_price_x86, simd_sum_quantities_x86, simd_bound_x86,
+                                           "avx2", "avx2", "avx2" };
+    }
+    if (cpu->avx512f) {
+        simd_dispatch.bound = simd_bound_x86_avx512;
+        simd_dispatch.bound_kernel = "avx512";
+    }
 #elif defined(SIMD_ARM)
-    return simd_sum_quantities_arm(quantities, count);
+    if (cpu->neon) {
+        simd_dispatch = (simd_dispatch_t){ simd_find_price_arm, simd_sum_quantities_arm, simd_bound_arm,
+                                           "neon", "neon", "neon" };
+    }
 #else
-    return simd_sum_quantities_generic(quantities, count);
+    (void)cpu;
 #endif
 }
 
+int simd_find_price(uint64_t* prices, int count, uint64_t target) {
+    return simd_dispatch.find_price(prices, count, target);
+}
+
+uint64_t simd_sum_quantities(uint32_t* quantities, int count) {
+    return simd_dispatch.sum_quantities(quantities, count);
+}
+
+static inline int simd_bound(const uint64_t* prices, int count, uint64_t target, int ascending, int upper) {
+    return simd_dispatch.bound(prices, count, target, ascending, upper);
+}
+
+int simd_lower_bound(const uint64_t* prices, int count, uint64_t target, int ascending) {
+    return simd_bound(prices, count, target, ascending, 0);
+}
+
+int simd_upper_bound(const uint64_t* prices, int count, uint64_t target, int ascending) {
+    return simd_bound(prices, count, target, ascending, 1);
+}
+
+void print_simd_dispatch() {
+    printf("SIMD dispatch (CPU: %s): sum %s, find %s, lower/upper bound %s, JSON scan %s, "
+           "book scan %s, book query %s\n", cpu_features_name(),
+           simd_dispatch.sum_quantities_kernel, simd_dispatch.find_price_kernel,
+           simd_dispatch.bound_kernel, json_scan_kernel(), book_scan_kernel(), book_query_kernel());
+}
+
 // =============================================================================
 // 6. LOCK-FREE CONCURRENT STRUCTURE
 // =============================================================================
+// Harris-Michael sorted list of levels per side: a delete first marks the
+// level's next pointer (low bit), then unlinks it; traversals unlink any
+// marked level they pass. Unlinked levels are reclaimed with epoch-based
+// reclamation (EBR): each thread pins the global epoch around its
+// operations, and a level retired in epoch e is only reused once the epoch
+// has reached e + 2, when no pinned thread can still hold a pointer to it.
+// A deleted level's orders, and the queue an L2 update replaces, are
+// detached and retired the same way.
+//
+// Levels and orders come from slab pools owned by the book, through a
+// per-thread slab cache: a thread only takes the pool's lock once per
+// SLAB_CACHE_BATCH objects, and what it retires goes back into its own
+// cache, so no shared lock-free free stack (and no ABA) is needed.
 #include <stdatomic.h>
 
+#define LOCKFREE_MAX_THREADS 64
+#define LOCKFREE_ADVANCE_EVERY 64       // retires between epoch advance attempts
+#define LOCKFREE_PIN_BATCH 32           // ops per pin in lockfree_apply_ops
+#define LOCKFREE_MARK ((uintptr_t)1)
+
 typedef struct lockfree_order {
     uint64_t id;
     uint64_t price;
@@ -370,718 +1296,3908 @@ typedef struct lockfree_order {
     struct lockfree_order* _Atomic next;
 } lockfree_order_t;
 
+// One cache line per level so writers on neighbouring prices don't false-share
 typedef struct lockfree_level {
     uint64_t price;
     _Atomic uint32_t total_quantity;
     lockfree_order_t* _Atomic orders;
-    struct lockfree_level* _Atomic next;
-} lockfree_level_t;
+    _Atomic uintptr_t next;                  // LOCKFREE_MARK set: level deleted
+    struct lockfree_level* reclaim_next;     // limbo / free list link (owner only)
+} __attribute__((aligned(64))) lockfree_level_t;
 
 typedef struct {
-    lockfree_level_t* _Atomic bids;
-    lockfree_level_t* _Atomic asks;
+    _Atomic uint64_t state;                  // (epoch << 1) | pinned
+    slab_cache_t levels;
+    slab_cache_t orders;
+    lockfree_level_t* limbo[3];              // retired levels by epoch % 3
+    lockfree_order_t* order_limbo[3];        // retired order chains, same bags
+    uint64_t limbo_epoch[3];
+    int retired;
+} __attribute__((aligned(64))) lockfree_thread_t;
+
+typedef struct {
+    _Alignas(64) _Atomic uintptr_t bids;     // Descending order
+    _Alignas(64) _Atomic uintptr_t asks;     // Ascending order
+    _Alignas(64) _Atomic uint64_t epoch;
+    _Atomic int thread_count;
+    slab_pool_t level_pool;
+    slab_pool_t order_pool;
+    lockfree_thread_t threads[LOCKFREE_MAX_THREADS];
 } lockfree_book_t;
 
-// Lock-free insertion using compare-and-swap
-int lockfree_insert_order(lockfree_book_t* book, lockfree_order_t* order, int is_bid) {
-    lockfree_level_t* _Atomic * head = is_bid ? &book->bids : &book->asks;
+static inline lockfree_level_t* lockfree_ptr(uintptr_t link) {
+    return (lockfree_level_t*)(link & ~LOCKFREE_MARK);
+}
+
+// The pools grow on demand; reserve_levels of each are faulted in up front
+int lockfree_book_init(lockfree_book_t* book, size_t reserve_levels) {
+    memset(book, 0, sizeof(*book));
+    slab_pool_init(&book->level_pool, sizeof(lockfree_level_t));
+    slab_pool_init(&book->order_pool, sizeof(lockfree_order_t));
+    return slab_pool_reserve(&book->level_pool, reserve_levels) &&
+           slab_pool_reserve(&book->order_pool, reserve_levels);
+}
+
+// Single-threaded: every thread must be done with the book
+void lockfree_book_free(lockfree_book_t* book) {
+    slab_pool_destroy(&book->level_pool);
+    slab_pool_destroy(&book->order_pool);
+}
+
+// Each thread using the book needs its own record
+lockfree_thread_t* lockfree_thread_register(lockfree_book_t* book) {
+    int index = atomic_fetch_add(&book->thread_count, 1);
+    if (index >= LOCKFREE_MAX_THREADS) return NULL;
+    
+    lockfree_thread_t* t = &book->threads[index];
+    slab_cache_init(&t->levels, &book->level_pool);
+    slab_cache_init(&t->orders, &book->order_pool);
+    return t;
+}
+
+// Levels read between pin and unpin stay valid (not reused)
+static inline void lockfree_pin(lockfree_book_t* book, lockfree_thread_t* t) {
+    atomic_store(&t->state, (atomic_load(&book->epoch) << 1) | 1);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+static inline void lockfree_unpin(lockfree_thread_t* t) {
+    atomic_store_explicit(&t->state, 0, memory_order_release);
+}
+
+// The epoch moves on once every pinned thread has seen the current one
+static void lockfree_try_advance(lockfree_book_t* book) {
+    uint64_t epoch = atomic_load(&book->epoch);
+    int count = atomic_load(&book->thread_count);
+    
+    for (int i = 0; i < count && i < LOCKFREE_MAX_THREADS; i++) {
+        uint64_t state = atomic_load(&book->threads[i].state);
+        if ((state & 1) && (state >> 1) != epoch) return;
+    }
+    atomic_compare_exchange_strong(&book->epoch, &epoch, epoch + 1);
+}
+
+static inline void lockfree_free_orders(lockfree_thread_t* t, lockfree_order_t* order) {
+    while (order) {
+        lockfree_order_t* next = atomic_load_explicit(&order->next, memory_order_relaxed);
+        slab_cache_free(&t->orders, order);
+        order = next;
+    }
+}
+
+// Move a limbo bag into the thread's cache. A level's own chain is whatever
+// an insert racing its delete pushed after the orders were detached.
+static inline void lockfree_recycle(lockfree_thread_t* t, int bag) {
+    lockfree_level_t* level = t->limbo[bag];
+    while (level) {
+        lockfree_level_t* next = level->reclaim_next;
+        lockfree_free_orders(t, atomic_load_explicit(&level->orders, memory_order_relaxed));
+        slab_cache_free(&t->levels, level);
+        level = next;
+    }
+    t->limbo[bag] = NULL;
+    
+    lockfree_free_orders(t, t->order_limbo[bag]);
+    t->order_limbo[bag] = NULL;
+}
+
+// Bag for the current epoch, emptied first if it still holds an older one
+static int lockfree_limbo_bag(lockfree_book_t* book, lockfree_thread_t* t) {
+    uint64_t epoch = atomic_load(&book->epoch);
+    int bag = epoch % 3;
+    
+    // Same bag, older epoch: at least 3 epochs old, safe to reuse
+    if (t->limbo_epoch[bag] != epoch) {
+        lockfree_recycle(t, bag);
+        t->limbo_epoch[bag] = epoch;
+    }
+    return bag;
+}
+
+static inline void lockfree_count_retire(lockfree_book_t* book, lockfree_thread_t* t) {
+    if (++t->retired >= LOCKFREE_ADVANCE_EVERY) {
+        t->retired = 0;
+        lockfree_try_advance(book);
+    }
+}
+
+static void lockfree_retire(lockfree_book_t* book, lockfree_thread_t* t, lockfree_level_t* level) {
+    int bag = lockfree_limbo_bag(book, t);
+    level->reclaim_next = t->limbo[bag];
+    t->limbo[bag] = level;
+    lockfree_count_retire(book, t);
+}
+
+// A detached chain goes in whole, in front of the bag's other chains
+static void lockfree_retire_orders(lockfree_book_t* book, lockfree_thread_t* t, lockfree_order_t* orders) {
+    if (!orders) return;
+    
+    int bag = lockfree_limbo_bag(book, t);
+    lockfree_order_t* tail = orders;
+    for (lockfree_order_t* next; (next = atomic_load_explicit(&tail->next, memory_order_relaxed)); tail = next) {}
+    atomic_store_explicit(&tail->next, t->order_limbo[bag], memory_order_relaxed);
+    t->order_limbo[bag] = orders;
+    lockfree_count_retire(book, t);
+}
+
+static lockfree_level_t* lockfree_alloc_level(lockfree_book_t* book, lockfree_thread_t* t) {
+    lockfree_level_t* level = slab_cache_alloc(&t->levels);
+    if (level) return level;
+    
+    // Out of memory: reclaim whatever is two epochs old
+    lockfree_try_advance(book);
+    uint64_t epoch = atomic_load(&book->epoch);
+    for (int bag = 0; bag < 3; bag++) {
+        if (t->limbo[bag] && t->limbo_epoch[bag] + 2 <= epoch) lockfree_recycle(t, bag);
+    }
+    return slab_cache_alloc(&t->levels);
+}
+
+static inline int lockfree_before(uint64_t a, uint64_t b, int is_bid) {
+    return is_bid ? a > b : a < b;
+}
+
+// First live level not ordered before price, NULL at the end; *prev_out is
+// the link pointing at it. Marked levels on the way are unlinked and retired.
+static lockfree_level_t* lockfree_find(lockfree_book_t* book, lockfree_thread_t* t, uint64_t price,
+                                       int is_bid, _Atomic uintptr_t** prev_out) {
+retry:;
+    _Atomic uintptr_t* prev = is_bid ? &book->bids : &book->asks;
+    uintptr_t current = atomic_load(prev);
     
     while (1) {
-        lockfree_level_t* current = atomic_load(head);
-        lockfree_level_t* prev = NULL;
+        lockfree_level_t* level = lockfree_ptr(current);
+        if (!level) break;
         
-        // Find insertion point (simplified - full implementation needs ABA protection)
-        while (current && 
-               ((is_bid && current->price > order->price) ||
-                (!is_bid && current->price < order->price))) {
-            prev = current;
-            current = atomic_load(&current->next);
+        uintptr_t next = atomic_load(&level->next);
+        if (next & LOCKFREE_MARK) {
+            uintptr_t expected = (uintptr_t)level;
+            if (!atomic_compare_exchange_strong(prev, &expected, next & ~LOCKFREE_MARK)) goto retry;
+            lockfree_retire(book, t, level);
+            current = next & ~LOCKFREE_MARK;
+            continue;
         }
         
-        if (current && current->price == order->price) {
-            // Add to existing level
-            lockfree_order_t* old_head;
-            do {
-                old_head = atomic_load(&current->orders);
-                order->next = old_head;
-            } while (!atomic_compare_exchange_weak(&current->orders, &old_head, order));
-            
-            atomic_fetch_add(&current->total_quantity, order->quantity);
-            return 1;
+        if (!lockfree_before(level->price, price, is_bid)) {
+            *prev_out = prev;
+            return level;
         }
+        prev = &level->next;
+        current = next;
+    }
+    
+    *prev_out = prev;
+    return NULL;
+}
+
+// Level at price, linked in empty if needed; NULL only if the pool is exhausted
+static lockfree_level_t* lockfree_find_or_insert(lockfree_book_t* book, lockfree_thread_t* t,
+                                                 uint64_t price, int is_bid) {
+    lockfree_level_t* fresh = NULL;
+    
+    while (1) {
+        _Atomic uintptr_t* prev;
+        lockfree_level_t* level = lockfree_find(book, t, price, is_bid, &prev);
         
-        // Create new level - simplified version
-        lockfree_level_t* new_level = malloc(sizeof(lockfree_level_t));
-        new_level->price = order->price;
-        atomic_store(&new_level->total_quantity, order->quantity);
-        atomic_store(&new_level->orders, order);
-        order->next = NULL;
-        atomic_store(&new_level->next, current);
-        
-        // Try to insert
-        if (prev) {
-            if (atomic_compare_exchange_strong(&prev->next, &current, new_level)) {
-                return 1;
-            }
-        } else {
-            if (atomic_compare_exchange_strong(head, &current, new_level)) {
-                return 1;
+        if (level && level->price == price) {
+            if (fresh) {
+                // Never published: straight back to the cache
+                slab_cache_free(&t->levels, fresh);
             }
+            return level;
         }
         
-        // Failed, retry
-        free(new_level);
+        if (!fresh) {
+            fresh = lockfree_alloc_level(book, t);
+            if (!fresh) return NULL;
+            fresh->price = price;
+            atomic_store_explicit(&fresh->total_quantity, 0, memory_order_relaxed);
+            atomic_store_explicit(&fresh->orders, NULL, memory_order_relaxed);
+        }
+        atomic_store_explicit(&fresh->next, (uintptr_t)level, memory_order_relaxed);
+        
+        uintptr_t expected = (uintptr_t)level;
+        if (atomic_compare_exchange_strong(prev, &expected, (uintptr_t)fresh)) return fresh;
     }
 }
 
-// =============================================================================
-// BENCHMARK AND COMPARISON FUNCTIONS
-// =============================================================================
+// The functions below must be called pinned (lockfree_pin)
 
-void print_performance_characteristics() {
-    printf("ORDER BOOK DATA STRUCTURE COMPARISON:\n\n");
-    
-    printf("1. SIMPLE LINKED LIST:\n");
-    printf("   - Insertion: O(n) worst, O(1) best (front insertion)\n");
-    printf("   - Search: O(n)\n");
-    printf("   - Memory: ~24 bytes/level + 32 bytes/order\n");
-    printf("   - Cache: Poor (pointer chasing)\n");
-    printf("   - Pros: Simple, flexible\n");
-    printf("   - Cons: Slow for deep books\n\n");
-    
-    printf("2. ARRAY-BASED:\n");
-    printf("   - Insertion: O(log n) search + O(n) shift\n");
-    printf("   - Search: O(log n)\n");
-    printf("   - Memory: Fixed allocation, cache-friendly\n");
-    printf("   - Cache: Excellent (sequential access)\n");
-    printf("   - Pros: Fast reads, good cache locality\n");
-    printf("   - Cons: Expensive insertions, fixed capacity\n\n");
-    
-    printf("3. SKIP LIST:\n");
-    printf("   - Insertion: O(log n) expected\n");
-    printf("   - Search: O(log n) expected\n");
-    printf("   - Memory: ~40+ bytes/level (level-dependent)\n");
-    printf("   - Cache: Moderate (some pointer chasing)\n");
-    printf("   - Pros: Balanced performance\n");
-    printf("   - Cons: Probabilistic, complex\n\n");
-    
-    printf("4. DIRECT ARRAY MAPPING:\n");
-    printf("   - Insertion: O(1)\n");
-    printf("   - Search: O(1)\n");
-    printf("   - Memory: Large fixed allocation\n");
-    printf("   - Cache: Excellent\n");
-    printf("   - Pros: Fastest possible operations\n");
-    printf("   - Cons: Huge memory usage, limited price range\n\n");
-    
-    printf("5. LOCK-FREE:\n");
-    printf("   - Insertion: O(log n) with retry overhead\n");
-    printf("   - Search: O(log n)\n");
-    printf("   - Memory: Similar to skip list + atomic overhead\n");
-    printf("   - Cache: Moderate\n");
-    printf("   - Pros: High concurrency\n");
-    printf("   - Cons: Complex, ABA problems, retry storms\n\n");
+int lockfree_delete_level(lockfree_book_t* book, lockfree_thread_t* t, uint64_t price, int is_bid) {
+    while (1) {
+        _Atomic uintptr_t* prev;
+        lockfree_level_t* level = lockfree_find(book, t, price, is_bid, &prev);
+        if (!level || level->price != price) return 0;
+        
+        // Logical delete: once marked, nothing can link after this level
+        uintptr_t next = atomic_load(&level->next);
+        if (next & LOCKFREE_MARK) continue;
+        if (!atomic_compare_exchange_strong(&level->next, &next, next | LOCKFREE_MARK)) continue;
+        lockfree_retire_orders(book, t, atomic_exchange(&level->orders, NULL));
+        
+        uintptr_t expected = (uintptr_t)level;
+        if (atomic_compare_exchange_strong(prev, &expected, next)) {
+            lockfree_retire(book, t, level);
+        } else {
+            lockfree_find(book, t, price, is_bid, &prev);  // unlinks it
+        }
+        return 1;
+    }
 }
 
-// =============================================================================
-// MEMORY POOL FOR EFFICIENT ORDER ALLOCATION
-// =============================================================================
-
-// Memory pool for efficient order allocation
-typedef struct order_pool {
-    order_t* orders;
-    uint32_t* free_list;
-    uint32_t capacity;
-    uint32_t next_free;
-} order_pool_t;
+// An order racing a delete of its level is linearized before the delete
+// (it is reclaimed with the level)
+int lockfree_insert_order(lockfree_book_t* book, lockfree_thread_t* t, lockfree_order_t* order, int is_bid) {
+    lockfree_level_t* level = lockfree_find_or_insert(book, t, order->price, is_bid);
+    if (!level) return 0;
+    
+    lockfree_order_t* old_head = atomic_load(&level->orders);
+    do {
+        atomic_store_explicit(&order->next, old_head, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak(&level->orders, &old_head, order));
+    
+    atomic_fetch_add(&level->total_quantity, order->quantity);
+    return 1;
+}
 
-order_t* pool_alloc_order(order_pool_t* pool) {
-    if (pool->next_free >= pool->capacity) return NULL;
-    
-    uint32_t index = pool->free_list[pool->next_free++];
-    return &pool->orders[index];
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it. The quantity replaces
+// the level's order queue, so the queued orders are detached and retired.
+int lockfree_update_level(lockfree_book_t* book, lockfree_thread_t* t, uint64_t price,
+                          uint32_t quantity, int is_bid) {
+    if (quantity == 0) return lockfree_delete_level(book, t, price, is_bid);
+    
+    lockfree_level_t* level = lockfree_find_or_insert(book, t, price, is_bid);
+    if (!level) return 0;
+    lockfree_retire_orders(book, t, atomic_exchange(&level->orders, NULL));
+    atomic_store(&level->total_quantity, quantity);
+    return 1;
 }
 
-void pool_free_order(order_pool_t* pool, order_t* order) {
-    uint32_t index = order - pool->orders;
-    pool->free_list[--pool->next_free] = index;
+// Best live level of a side, NULL if empty
+static inline lockfree_level_t* lockfree_best(lockfree_book_t* book, int is_bid) {
+    uintptr_t link = atomic_load(is_bid ? &book->bids : &book->asks);
+    while (lockfree_ptr(link) && (atomic_load(&lockfree_ptr(link)->next) & LOCKFREE_MARK)) {
+        link = atomic_load(&lockfree_ptr(link)->next);
+    }
+    return lockfree_ptr(link);
 }
 
 // =============================================================================
-// BENCHMARK INFRASTRUCTURE
+// 7. SLIDING-WINDOW DIRECT BOOK (RE-CENTERING RING)
 // =============================================================================
+// Direct-mapped slots for WINDOW_TICKS prices around the mid, addressed as a
+// ring (price & WINDOW_MASK) so re-centering only touches the slots entering
+// or leaving the window. Levels outside it spill into a sorted overflow array
+// per side. 2 x 4096 x 16 bytes = 128 KB fits in L2 and works with real
+// prices (BTCUSDT is ~11.8M ticks at $0.01), unlike the fixed direct book.
+#define WINDOW_TICKS 4096
+#define WINDOW_MASK (WINDOW_TICKS - 1)
+#define WINDOW_MARGIN (WINDOW_TICKS / 4)   // re-center when the touch gets this close to an edge
 
-#include <time.h>
-#include <sys/time.h>
+typedef struct {
+    uint64_t price;
+    direct_price_level_t level;
+} window_overflow_level_t;
 
-// High precision timing
-static inline uint64_t get_time_ns() {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
-}
+// Stored worst-to-best like the array book: the best level is the last one
+typedef struct {
+    window_overflow_level_t* levels;
+    int count;
+    int capacity;
+} window_overflow_t;
 
-// Generate realistic order data
-typedef struct benchmark_order {
-    uint64_t id;
-    uint64_t price;
-    uint32_t quantity;
-    int is_bid;
-} benchmark_order_t;
+typedef struct {
+    direct_price_level_t bid_slots[WINDOW_TICKS];
+    direct_price_level_t ask_slots[WINDOW_TICKS];
+    price_bitmap_t bid_bitmap;           // occupied slots, by ring index
+    price_bitmap_t ask_bitmap;
+    uint64_t low;                        // window covers [low, low + WINDOW_TICKS)
+    int anchored;                        // the first update sets low
+    window_overflow_t bid_overflow;
+    window_overflow_t ask_overflow;
+    uint64_t recenters;
+} window_book_t;
 
-void generate_orders(benchmark_order_t* orders, int count, uint64_t base_price) {
-    srand(42); // Deterministic for consistent benchmarks
-    
-    for (int i = 0; i < count; i++) {
-        orders[i].id = i;
-        // Generate prices in a realistic spread around base_price
-        int price_offset = (rand() % 1000) - 500; // ±500 ticks
-        orders[i].price = base_price + price_offset;
-        orders[i].quantity = 100 + (rand() % 10000); // 100-10100 shares
-        orders[i].is_bid = rand() % 2;
-    }
+int window_book_init(window_book_t* book) {
+    memset(book, 0, sizeof(*book));
+    return price_bitmap_init(&book->bid_bitmap, WINDOW_TICKS) &&
+           price_bitmap_init(&book->ask_bitmap, WINDOW_TICKS);
 }
 
-// =============================================================================
-// BENCHMARK FUNCTIONS FOR EACH DATA STRUCTURE
-// =============================================================================
+void window_book_free(window_book_t* book) {
+    price_bitmap_free(&book->bid_bitmap);
+    price_bitmap_free(&book->ask_bitmap);
+    free(book->bid_overflow.levels);
+    free(book->ask_overflow.levels);
+}
 
-// Simple linked list benchmark
-double benchmark_simple_book(benchmark_order_t* orders, int count) {
-    simple_book_t book = {0};
-    
-    // Pre-allocate orders in a simple array (simplified pool)
-    order_t* order_storage = malloc(count * sizeof(order_t));
-    
-    uint64_t start = get_time_ns();
+static inline int window_contains(const window_book_t* book, uint64_t price) {
+    return price - book->low < WINDOW_TICKS;  // wraps for price < low
+}
+
+// Binary search in worst-to-best order, same convention as find_price_level
+static int window_overflow_find(const window_overflow_t* ov, uint64_t price, int is_bid) {
+    int left = 0, right = ov->count - 1;
     
-    for (int i = 0; i < count; i++) {
-        order_t* order = &order_storage[i];
-        order->id = orders[i].id;
-        order->price = orders[i].price;
-        order->quantity = orders[i].quantity;
-        order->next = NULL;
+    while (left <= right) {
+        int mid = (left + right) / 2;
+        uint64_t mid_price = ov->levels[mid].price;
+        
+        if (mid_price == price) return mid;
         
-        simple_insert_order(&book, order, orders[i].is_bid);
+        if ((is_bid && mid_price < price) || (!is_bid && mid_price > price)) {
+            left = mid + 1;
+        } else {
+            right = mid - 1;
+        }
+    }
+    return -(left + 1);
+}
+
+static direct_price_level_t* window_overflow_level(window_overflow_t* ov, uint64_t price,
+                                                   int is_bid, int create) {
+    int pos = window_overflow_find(ov, price, is_bid);
+    if (pos >= 0) return &ov->levels[pos].level;
+    if (!create) return NULL;
+    
+    if (ov->count == ov->capacity) {
+        int capacity = ov->capacity ? ov->capacity * 2 : 256;
+        window_overflow_level_t* levels = realloc(ov->levels, capacity * sizeof(window_overflow_level_t));
+        if (!levels) return NULL;
+        ov->levels = levels;
+        ov->capacity = capacity;
     }
     
-    uint64_t end = get_time_ns();
+    pos = -(pos + 1);
+    memmove(&ov->levels[pos + 1], &ov->levels[pos],
+            (ov->count - pos) * sizeof(window_overflow_level_t));
+    memset(&ov->levels[pos], 0, sizeof(window_overflow_level_t));
+    ov->levels[pos].price = price;
+    ov->count++;
+    return &ov->levels[pos].level;
+}
+
+// Best occupied price inside the window, 0 if none
+static uint64_t window_slots_best(const window_book_t* book, int is_bid) {
+    uint64_t first = book->low & WINDOW_MASK;     // slot of the lowest price
+    int64_t slot;
     
-    // Cleanup
-    price_level_t* current = book.bids;
-    while (current) {
-        price_level_t* next = current->next;
-        free(current);
-        current = next;
+    if (is_bid) {
+        // Highest price: the wrapped part [0, first) first, then [first, end)
+        slot = first ? price_bitmap_prev(&book->bid_bitmap, first - 1) : -1;
+        if (slot < 0) slot = price_bitmap_prev(&book->bid_bitmap, WINDOW_MASK);
+    } else {
+        slot = price_bitmap_next(&book->ask_bitmap, first);
+        if (slot < 0 && first) slot = price_bitmap_next(&book->ask_bitmap, 0);
     }
-    current = book.asks;
-    while (current) {
-        price_level_t* next = current->next;
-        free(current);
-        current = next;
+    return slot < 0 ? 0 : book->low + ((slot - first) & WINDOW_MASK);
+}
+
+// Best price of a side, 0 if the side is empty. Overflow levels beyond the
+// window on the touch side (possible until the next re-center) win.
+uint64_t window_best(const window_book_t* book, int is_bid) {
+    const window_overflow_t* ov = is_bid ? &book->bid_overflow : &book->ask_overflow;
+    uint64_t overflow_best = ov->count ? ov->levels[ov->count - 1].price : 0;
+    
+    if (overflow_best && (is_bid ? overflow_best >= book->low + WINDOW_TICKS
+                                 : overflow_best < book->low)) {
+        return overflow_best;
     }
-    free(order_storage);
-    
-    return (end - start) / 1000000.0; // Convert to milliseconds
+    uint64_t best = window_slots_best(book, is_bid);
+    return best ? best : overflow_best;
 }
 
-// Array-based benchmark
-double benchmark_array_book(benchmark_order_t* orders, int count) {
-    array_book_t book = {0};
+// Number of overflow levels stored before price (worse than it)
+static inline int window_overflow_rank(const window_overflow_t* ov, uint64_t price, int is_bid) {
+    int pos = window_overflow_find(ov, price, is_bid);
+    return pos >= 0 ? pos : -(pos + 1);
+}
+
+// Move the window to [low, low + WINDOW_TICKS): occupied slots that fall out
+// go to the overflow, overflow levels that fall in go to their slots. Cost is
+// the number of levels moved plus a bitmap walk, not the shift distance.
+static void window_recenter(window_book_t* book, uint64_t low) {
+    uint64_t old_low = book->low;
+    uint64_t shift = low > old_low ? low - old_low : old_low - low;
+    uint64_t leaving = shift < WINDOW_TICKS ? shift : WINDOW_TICKS;
+    uint64_t leave_start = low > old_low ? old_low : old_low + WINDOW_TICKS - leaving;
+    uint64_t first = leave_start & WINDOW_MASK;
+    
+    for (int side = 0; side < 2; side++) {
+        int is_bid = side == 0;
+        direct_price_level_t* slots = is_bid ? book->bid_slots : book->ask_slots;
+        price_bitmap_t* bm = is_bid ? &book->bid_bitmap : &book->ask_bitmap;
+        window_overflow_t* ov = is_bid ? &book->bid_overflow : &book->ask_overflow;
+        
+        // Walk the occupied slots of the leaving range, wrapping once
+        uint64_t offset = 0;
+        while (offset < leaving) {
+            uint64_t slot = (first + offset) & WINDOW_MASK;
+            int64_t hit = price_bitmap_next(bm, slot);
+            if (hit < 0) {
+                if (slot == 0) break;
+                offset += WINDOW_TICKS - slot;
+                continue;
+            }
+            offset += hit - slot;
+            if (offset >= leaving) break;
+            
+            direct_price_level_t* spilled = window_overflow_level(ov, leave_start + offset, is_bid, 1);
+            if (spilled) *spilled = slots[hit];
+            memset(&slots[hit], 0, sizeof(direct_price_level_t));
+            price_bitmap_clear(bm, hit);
+            offset++;
+        }
+    }
     
-    uint64_t start = get_time_ns();
+    book->low = low;
+    book->recenters++;
     
-    for (int i = 0; i < count; i++) {
-        order_t order = {
-            .id = orders[i].id,
-            .price = orders[i].price,
-            .quantity = orders[i].quantity
-        };
+    // Overflow is sorted, so the levels now inside the window are contiguous
+    for (int side = 0; side < 2; side++) {
+        int is_bid = side == 0;
+        direct_price_level_t* slots = is_bid ? book->bid_slots : book->ask_slots;
+        price_bitmap_t* bm = is_bid ? &book->bid_bitmap : &book->ask_bitmap;
+        window_overflow_t* ov = is_bid ? &book->bid_overflow : &book->ask_overflow;
+        
+        // Bids are stored ascending, asks descending
+        int start = is_bid ? window_overflow_rank(ov, low, 1)
+                           : window_overflow_rank(ov, low + WINDOW_TICKS - 1, 0);
+        int end = is_bid ? window_overflow_rank(ov, low + WINDOW_TICKS, 1)
+                         : (low ? window_overflow_rank(ov, low - 1, 0) : ov->count);
+        if (end <= start) continue;
         
-        array_insert_order(&book, &order, orders[i].is_bid);
+        for (int i = start; i < end; i++) {
+            slots[ov->levels[i].price & WINDOW_MASK] = ov->levels[i].level;
+            price_bitmap_set(bm, ov->levels[i].price & WINDOW_MASK);
+        }
+        memmove(&ov->levels[start], &ov->levels[end],
+                (ov->count - end) * sizeof(window_overflow_level_t));
+        ov->count -= end - start;
     }
-    
-    uint64_t end = get_time_ns();
-    return (end - start) / 1000000.0;
 }
 
-// Direct mapping benchmark
-double benchmark_direct_book(benchmark_order_t* orders, int count) {
-    direct_book_t book = {0};
-    
-    // Allocate the large arrays
-    book.bid_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
-    book.ask_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
-    
-    if (!book.bid_levels || !book.ask_levels) {
-        free(book.bid_levels);
-        free(book.ask_levels);
-        return -1; // Memory allocation failed
+// Lazy re-anchoring: only when an update lands near an edge or outside the
+// window, and only if the touch itself has drifted there
+static inline void window_maybe_recenter(window_book_t* book, uint64_t price) {
+    if (price - book->low - WINDOW_MARGIN < WINDOW_TICKS - 2 * WINDOW_MARGIN) return;
+    
+    uint64_t best_bid = window_best(book, 1);
+    uint64_t best_ask = window_best(book, 0);
+    uint64_t mid = best_bid && best_ask ? (best_bid + best_ask) / 2 : (best_bid ? best_bid : best_ask);
+    if (!mid) return;
+    
+    if (mid - book->low - WINDOW_MARGIN >= WINDOW_TICKS - 2 * WINDOW_MARGIN) {
+        window_recenter(book, mid > WINDOW_TICKS / 2 ? mid - WINDOW_TICKS / 2 : 0);
+    }
+}
+
+// Level for a price, created (empty) if needed; NULL only if out of memory
+static inline direct_price_level_t* window_level(window_book_t* book, uint64_t price,
+                                                 int is_bid, int create) {
+    if (!book->anchored) {
+        book->low = price > WINDOW_TICKS / 2 ? price - WINDOW_TICKS / 2 : 0;
+        book->anchored = 1;
+    }
+    if (window_contains(book, price)) {
+        return &(is_bid ? book->bid_slots : book->ask_slots)[price & WINDOW_MASK];
+    }
+    return window_overflow_level(is_bid ? &book->bid_overflow : &book->ask_overflow,
+                                 price, is_bid, create);
+}
+
+static inline void window_mark(window_book_t* book, uint64_t price, int is_bid) {
+    if (window_contains(book, price)) {
+        price_bitmap_set(is_bid ? &book->bid_bitmap : &book->ask_bitmap, price & WINDOW_MASK);
     }
+}
+
+// O(1) inside the window, O(log n) + shift in the overflow
+void window_insert_order(window_book_t* book, order_t* order, int is_bid) {
+    direct_price_level_t* level = window_level(book, order->price, is_bid, 1);
+    if (!level) return;
     
-    // Pre-allocate orders
-    order_t* order_pool = malloc(count * sizeof(order_t));
+    if (level->total_quantity == 0) window_mark(book, order->price, is_bid);
+    order->next = level->first_order;
+    level->first_order = order;
+    level->total_quantity += order->quantity;
+    level->order_count++;
     
-    uint64_t start = get_time_ns();
+    window_maybe_recenter(book, order->price);
+}
+
+int window_delete_level(window_book_t* book, uint64_t price, int is_bid) {
+    if (!book->anchored) return 0;
+    
+    if (window_contains(book, price)) {
+        direct_price_level_t* level = &(is_bid ? book->bid_slots : book->ask_slots)[price & WINDOW_MASK];
+        if (level->total_quantity == 0) return 0;
+        memset(level, 0, sizeof(*level));
+        price_bitmap_clear(is_bid ? &book->bid_bitmap : &book->ask_bitmap, price & WINDOW_MASK);
+    } else {
+        window_overflow_t* ov = is_bid ? &book->bid_overflow : &book->ask_overflow;
+        int pos = window_overflow_find(ov, price, is_bid);
+        if (pos < 0) return 0;
+        memmove(&ov->levels[pos], &ov->levels[pos + 1],
+                (ov->count - pos - 1) * sizeof(window_overflow_level_t));
+        ov->count--;
+    }
     
-    for (int i = 0; i < count; i++) {
-        order_t* order = &order_pool[i];
-        order->id = orders[i].id;
-        order->price = orders[i].price;
-        order->quantity = orders[i].quantity;
-        
-        // Adjust price to fit in our range
-        if (orders[i].is_bid && order->price < PRICE_OFFSET) {
-            direct_insert_order(&book, order, 1);
-        } else if (!orders[i].is_bid && order->price < PRICE_RANGE) {
-            direct_insert_order(&book, order, 0);
-        }
+    window_maybe_recenter(book, price);
+    return 1;
+}
+
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it
+void window_update_level(window_book_t* book, uint64_t price, uint32_t quantity, int is_bid) {
+    if (quantity == 0) {
+        window_delete_level(book, price, is_bid);
+        return;
     }
     
-    uint64_t end = get_time_ns();
+    direct_price_level_t* level = window_level(book, price, is_bid, 1);
+    if (!level) return;
     
-    // Cleanup
-    free(book.bid_levels);
-    free(book.ask_levels);
-    free(order_pool);
+    if (level->total_quantity == 0) window_mark(book, price, is_bid);
+    level->total_quantity = quantity;
     
+    window_maybe_recenter(book, price);
+}
+
+// =============================================================================
+// 8. B+TREE (CACHE-LINE NODES)
+// =============================================================================
+// O(log n) updates that stay cache-friendly for deep, sparse books: every
+// node is 128 bytes (two cache lines), keyed by price in ascending order on
+// both sides, and the leaves are linked so a depth walk from the touch is
+// sequential. Bids read their best from the last leaf, asks from the first.
+//
+// A leaf keeps what a search touches (keys, quantities, count) in its first
+// cache line and the order heads and links in the second. Deletes free a
+// node only once it is empty, without merging underfull neighbours: the
+// usual trade-off for books where levels come back near where they left.
+#define BTREE_NODE_SIZE 128
+#define BTREE_LEAF_KEYS 5
+#define BTREE_INNER_KEYS 7
+#define BTREE_MAX_HEIGHT 16
+
+typedef struct btree_leaf {
+    uint64_t keys[BTREE_LEAF_KEYS];
+    uint32_t quantities[BTREE_LEAF_KEYS];
+    uint32_t count;
+    order_t* first_orders[BTREE_LEAF_KEYS];
+    struct btree_leaf* prev;                     // lower prices
+    struct btree_leaf* next;                     // higher prices
+} __attribute__((aligned(64))) btree_leaf_t;
+
+typedef struct btree_inner {
+    uint64_t keys[BTREE_INNER_KEYS];             // keys[i]: lowest price under children[i + 1]
+    void* children[BTREE_INNER_KEYS + 1];
+    uint32_t count;                              // keys in use, children = count + 1
+} __attribute__((aligned(64))) btree_inner_t;
+
+_Static_assert(sizeof(btree_leaf_t) == BTREE_NODE_SIZE, "leaf must be two cache lines");
+_Static_assert(sizeof(btree_inner_t) == BTREE_NODE_SIZE, "inner node must be two cache lines");
+
+typedef struct {
+    void* root;                                  // a leaf when height == 1
+    int height;                                  // 0 when the side is empty
+    btree_leaf_t* first;                         // lowest prices
+    btree_leaf_t* last;                          // highest prices
+} btree_side_t;
+
+// Leaves and inner nodes share one slab pool (both are BTREE_NODE_SIZE, 64-byte aligned)
+typedef struct {
+    btree_side_t bids;
+    btree_side_t asks;
+    slab_pool_t nodes;
+    size_t node_count;
+} btree_book_t;
+
+static void* btree_alloc_node(btree_book_t* book) {
+    void* node = slab_alloc(&book->nodes);
+    if (!node) return NULL;
+    
+    memset(node, 0, BTREE_NODE_SIZE);
+    book->node_count++;
+    return node;
+}
+
+static void btree_free_node(btree_book_t* book, void* node) {
+    slab_free(&book->nodes, node);
+    book->node_count--;
+}
+
+void btree_book_init(btree_book_t* book) {
+    memset(book, 0, sizeof(*book));
+    slab_pool_init(&book->nodes, BTREE_NODE_SIZE);
+}
+
+void btree_book_free(btree_book_t* book) {
+    slab_pool_destroy(&book->nodes);
+    memset(book, 0, sizeof(*book));
+}
+
+// Nodes are at most 7 keys: a linear count beats a binary search
+static inline int btree_inner_slot(const btree_inner_t* node, uint64_t price) {
+    int slot = 0;
+    while (slot < (int)node->count && node->keys[slot] <= price) slot++;
+    return slot;
+}
+
+static inline int btree_leaf_lower_bound(const btree_leaf_t* leaf, uint64_t price) {
+    int pos = 0;
+    while (pos < (int)leaf->count && leaf->keys[pos] < price) pos++;
+    return pos;
+}
+
+// Descend to the leaf covering price, recording the inner nodes and the
+// child slot taken in each (path has height - 1 entries)
+static btree_leaf_t* btree_descend(const btree_side_t* side, uint64_t price,
+                                   btree_inner_t** path, int* slots) {
+    void* node = side->root;
+    for (int depth = 0; depth < side->height - 1; depth++) {
+        btree_inner_t* inner = node;
+        int slot = btree_inner_slot(inner, price);
+        path[depth] = inner;
+        slots[depth] = slot;
+        node = inner->children[slot];
+    }
+    return node;
+}
+
+// Add separator key / right child after a split at depth, splitting upwards
+static int btree_insert_separator(btree_book_t* book, btree_side_t* side, btree_inner_t** path,
+                                  int* slots, int depth, uint64_t key, void* right) {
+    while (depth >= 0) {
+        btree_inner_t* node = path[depth];
+        int slot = slots[depth];
+        
+        if (node->count < BTREE_INNER_KEYS) {
+            memmove(&node->keys[slot + 1], &node->keys[slot], (node->count - slot) * sizeof(uint64_t));
+            memmove(&node->children[slot + 2], &node->children[slot + 1],
+                    (node->count - slot) * sizeof(void*));
+            node->keys[slot] = key;
+            node->children[slot + 1] = right;
+            node->count++;
+            return 1;
+        }
+        
+        // Full: merge into scratch arrays, keep the lower half, push the middle key up
+        uint64_t keys[BTREE_INNER_KEYS + 1];
+        void* children[BTREE_INNER_KEYS + 2];
+        memcpy(keys, node->keys, slot * sizeof(uint64_t));
+        keys[slot] = key;
+        memcpy(&keys[slot + 1], &node->keys[slot], (BTREE_INNER_KEYS - slot) * sizeof(uint64_t));
+        memcpy(children, node->children, (slot + 1) * sizeof(void*));
+        children[slot + 1] = right;
+        memcpy(&children[slot + 2], &node->children[slot + 1], (BTREE_INNER_KEYS - slot) * sizeof(void*));
+        
+        btree_inner_t* sibling = btree_alloc_node(book);
+        if (!sibling) return 0;
+        
+        int left_keys = (BTREE_INNER_KEYS + 1) / 2;
+        int right_keys = BTREE_INNER_KEYS - left_keys;
+        node->count = left_keys;
+        memcpy(node->keys, keys, left_keys * sizeof(uint64_t));
+        memcpy(node->children, children, (left_keys + 1) * sizeof(void*));
+        sibling->count = right_keys;
+        memcpy(sibling->keys, &keys[left_keys + 1], right_keys * sizeof(uint64_t));
+        memcpy(sibling->children, &children[left_keys + 1], (right_keys + 1) * sizeof(void*));
+        
+        key = keys[left_keys];
+        right = sibling;
+        depth--;
+    }
+    
+    // Root split: the tree grows by one level
+    if (side->height == BTREE_MAX_HEIGHT) return 0;
+    btree_inner_t* root = btree_alloc_node(book);
+    if (!root) return 0;
+    root->count = 1;
+    root->keys[0] = key;
+    root->children[0] = side->root;
+    root->children[1] = right;
+    side->root = root;
+    side->height++;
+    return 1;
+}
+
+// Leaf and index of the level at price, created empty if needed.
+// Returns NULL only if out of memory.
+static btree_leaf_t* btree_find_or_insert(btree_book_t* book, btree_side_t* side,
+                                          uint64_t price, int* index) {
+    if (side->height == 0) {
+        btree_leaf_t* leaf = btree_alloc_node(book);
+        if (!leaf) return NULL;
+        side->root = side->first = side->last = leaf;
+        side->height = 1;
+    }
+    
+    btree_inner_t* path[BTREE_MAX_HEIGHT];
+    int slots[BTREE_MAX_HEIGHT];
+    btree_leaf_t* leaf = btree_descend(side, price, path, slots);
+    int pos = btree_leaf_lower_bound(leaf, price);
+    
+    if (pos < (int)leaf->count && leaf->keys[pos] == price) {
+        *index = pos;
+        return leaf;
+    }
+    
+    if (leaf->count == BTREE_LEAF_KEYS) {
+        // Split: upper half moves to a new leaf linked after this one
+        btree_leaf_t* right = btree_alloc_node(book);
+        if (!right) return NULL;
+        
+        int keep = (BTREE_LEAF_KEYS + 1) / 2;
+        int moved = BTREE_LEAF_KEYS - keep;
+        memcpy(right->keys, &leaf->keys[keep], moved * sizeof(uint64_t));
+        memcpy(right->quantities, &leaf->quantities[keep], moved * sizeof(uint32_t));
+        memcpy(right->first_orders, &leaf->first_orders[keep], moved * sizeof(order_t*));
+        right->count = moved;
+        leaf->count = keep;
+        
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next) leaf->next->prev = right; else side->last = right;
+        leaf->next = right;
+        
+        if (!btree_insert_separator(book, side, path, slots, side->height - 2, right->keys[0], right)) {
+            return NULL;
+        }
+        
+        if (pos > keep) {
+            leaf = right;
+            pos -= keep;
+        }
+    }
+    
+    memmove(&leaf->keys[pos + 1], &leaf->keys[pos], (leaf->count - pos) * sizeof(uint64_t));
+    memmove(&leaf->quantities[pos + 1], &leaf->quantities[pos], (leaf->count - pos) * sizeof(uint32_t));
+    memmove(&leaf->first_orders[pos + 1], &leaf->first_orders[pos], (leaf->count - pos) * sizeof(order_t*));
+    leaf->keys[pos] = price;
+    leaf->quantities[pos] = 0;
+    leaf->first_orders[pos] = NULL;
+    leaf->count++;
+    
+    *index = pos;
+    return leaf;
+}
+
+// Unlink an empty leaf and drop its slot from the parents, freeing any inner
+// node left without children and collapsing single-child roots
+static void btree_remove_leaf(btree_book_t* book, btree_side_t* side, btree_leaf_t* leaf,
+                              btree_inner_t** path, int* slots) {
+    if (leaf->prev) leaf->prev->next = leaf->next; else side->first = leaf->next;
+    if (leaf->next) leaf->next->prev = leaf->prev; else side->last = leaf->prev;
+    btree_free_node(book, leaf);
+    
+    int depth = side->height - 2;
+    while (depth >= 0) {
+        btree_inner_t* node = path[depth];
+        int slot = slots[depth];
+        
+        if (node->count > 0) {
+            // Child 0 takes key 0 with it, any other child the key on its left
+            int key = slot > 0 ? slot - 1 : 0;
+            memmove(&node->keys[key], &node->keys[key + 1], (node->count - key - 1) * sizeof(uint64_t));
+            memmove(&node->children[slot], &node->children[slot + 1], (node->count - slot) * sizeof(void*));
+            node->count--;
+            break;
+        }
+        
+        btree_free_node(book, node);
+        depth--;
+    }
+    
+    if (depth < 0) {
+        side->root = NULL;
+        side->height = 0;
+        return;
+    }
+    
+    while (side->height > 1 && ((btree_inner_t*)side->root)->count == 0) {
+        btree_inner_t* root = side->root;
+        side->root = root->children[0];
+        side->height--;
+        btree_free_node(book, root);
+    }
+}
+
+int btree_delete_level(btree_book_t* book, uint64_t price, int is_bid) {
+    btree_side_t* side = is_bid ? &book->bids : &book->asks;
+    if (side->height == 0) return 0;
+    
+    btree_inner_t* path[BTREE_MAX_HEIGHT];
+    int slots[BTREE_MAX_HEIGHT];
+    btree_leaf_t* leaf = btree_descend(side, price, path, slots);
+    int pos = btree_leaf_lower_bound(leaf, price);
+    if (pos == (int)leaf->count || leaf->keys[pos] != price) return 0;
+    
+    int tail = leaf->count - pos - 1;
+    memmove(&leaf->keys[pos], &leaf->keys[pos + 1], tail * sizeof(uint64_t));
+    memmove(&leaf->quantities[pos], &leaf->quantities[pos + 1], tail * sizeof(uint32_t));
+    memmove(&leaf->first_orders[pos], &leaf->first_orders[pos + 1], tail * sizeof(order_t*));
+    
+    if (--leaf->count == 0) {
+        btree_remove_leaf(book, side, leaf, path, slots);
+    }
+    return 1;
+}
+
+void btree_insert_order(btree_book_t* book, order_t* order, int is_bid) {
+    int index;
+    btree_leaf_t* leaf = btree_find_or_insert(book, is_bid ? &book->bids : &book->asks,
+                                              order->price, &index);
+    if (!leaf) return;
+    
+    order->next = leaf->first_orders[index];
+    leaf->first_orders[index] = order;
+    leaf->quantities[index] += order->quantity;
+}
+
+// Set the aggregated quantity of a level (L2 diff semantics):
+// creates the level if needed, quantity 0 deletes it
+void btree_update_level(btree_book_t* book, uint64_t price, uint32_t quantity, int is_bid) {
+    if (quantity == 0) {
+        btree_delete_level(book, price, is_bid);
+        return;
+    }
+    
+    int index;
+    btree_leaf_t* leaf = btree_find_or_insert(book, is_bid ? &book->bids : &book->asks, price, &index);
+    if (leaf) leaf->quantities[index] = quantity;
+}
+
+// Best price of a side, 0 if the side is empty
+static inline uint64_t btree_best(const btree_book_t* book, int is_bid) {
+    if (is_bid) {
+        return book->bids.last ? book->bids.last->keys[book->bids.last->count - 1] : 0;
+    }
+    return book->asks.first ? book->asks.first->keys[0] : 0;
+}
+
+// =============================================================================
+// 9. L3 MARKET-BY-ORDER BOOK (ORDER-ID INDEX)
+// =============================================================================
+// Every order sits in an intrusive doubly-linked FIFO queue at its level and
+// keeps a pointer to that level, so once it is found, cancel / reduce /
+// execute are O(1) unlinks. Orders are found by id through an open-addressing
+// table probed 16 slots at a time (SwissTable layout): one control byte per
+// slot holds 7 bits of the hash, and a single SIMD compare checks a whole
+// group of control bytes against them. Levels are direct-mapped over
+// L3_PRICE_RANGE ticks from base_price, with occupancy bitmaps for the best price.
+#define L3_PRICE_RANGE (1 << 14)
+#define L3_GROUP 16
+#define L3_CTRL_EMPTY 0x80
+#define L3_CTRL_DELETED 0xFE
+
+typedef struct l3_order {
+    uint64_t id;
+    uint64_t price;
+    uint32_t quantity;
+    int is_bid;
+    struct l3_order* prev;                 // towards the front of the queue
+    struct l3_order* next;
+    struct l3_level* level;
+} l3_order_t;
+
+typedef struct l3_level {
+    uint64_t total_quantity;
+    uint32_t order_count;
+    l3_order_t* head;                      // oldest order, executed first
+    l3_order_t* tail;
+} l3_level_t;
+
+typedef struct {
+    uint8_t* ctrl;                         // capacity + L3_GROUP (mirrors the first group)
+    l3_order_t** slots;
+    size_t capacity;                       // power of two, multiple of L3_GROUP
+    size_t live;
+    size_t used;                           // live + tombstones
+} l3_order_index_t;
+
+typedef struct {
+    l3_level_t bid_levels[L3_PRICE_RANGE];
+    l3_level_t ask_levels[L3_PRICE_RANGE];
+    price_bitmap_t bid_bitmap;
+    price_bitmap_t ask_bitmap;
+    uint64_t base_price;                   // price of level 0
+    l3_order_index_t index;
+    slab_pool_t orders;
+    uint64_t executed_quantity;
+} l3_book_t;
+
+static inline uint64_t l3_hash(uint64_t id) {
+    return id * 0x9E3779B97F4A7C15ULL;
+}
+
+// First group to probe. Bits of a multiplicative hash only depend on the id
+// bits at or below them, so the low bits would put ids that are multiples of
+// 2^k in a few groups: take the bits just under the 7-bit tag instead.
+static inline size_t l3_probe_start(size_t capacity, uint64_t hash) {
+    size_t pos = (hash << 7) >> (64 - __builtin_ctzll(capacity));
+    return pos & ~(size_t)(L3_GROUP - 1);
+}
+
+// Bit i set when ctrl[i] == tag, for the 16 control bytes of a group
+static inline uint32_t l3_group_match(const uint8_t* ctrl, uint8_t tag) {
+#ifdef SIMD_X86
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+#elif defined(SIMD_ARM)
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128,
+                                         1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t hits = vandq_u8(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(tag)), vld1q_u8(weights));
+    return vaddv_u8(vget_low_u8(hits)) | ((uint32_t)vaddv_u8(vget_high_u8(hits)) << 8);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < L3_GROUP; i++) {
+        mask |= (uint32_t)(ctrl[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+static int l3_index_init(l3_order_index_t* index, size_t capacity) {
+    size_t size = L3_GROUP;
+    while (size < capacity) size *= 2;
+    
+    index->capacity = size;
+    index->live = index->used = 0;
+    index->ctrl = malloc(size + L3_GROUP);
+    index->slots = calloc(size, sizeof(l3_order_t*));
+    if (!index->ctrl || !index->slots) return 0;
+    memset(index->ctrl, L3_CTRL_EMPTY, size + L3_GROUP);
+    return 1;
+}
+
+static void l3_index_free(l3_order_index_t* index) {
+    free(index->ctrl);
+    free(index->slots);
+}
+
+// Keep the mirrored group after the table in sync, so a group load at any
+// slot can read 16 bytes without wrapping
+static inline void l3_set_ctrl(l3_order_index_t* index, size_t slot, uint8_t value) {
+    index->ctrl[slot] = value;
+    if (slot < L3_GROUP) index->ctrl[index->capacity + slot] = value;
+}
+
+// Slot holding id, or -1. Probes group by group (triangular steps) and
+// stops at the first group that still has an empty slot.
+static inline int64_t l3_index_find(const l3_order_index_t* index, uint64_t id) {
+    uint64_t hash = l3_hash(id);
+    uint8_t tag = hash >> 57;
+    size_t mask = index->capacity - 1;
+    size_t pos = l3_probe_start(index->capacity, hash);
+    
+    for (size_t step = L3_GROUP; ; step += L3_GROUP) {
+        const uint8_t* group = index->ctrl + pos;
+        for (uint32_t hits = l3_group_match(group, tag); hits; hits &= hits - 1) {
+            size_t slot = pos + __builtin_ctz(hits);
+            if (index->slots[slot]->id == id) return slot;
+        }
+        if (l3_group_match(group, L3_CTRL_EMPTY)) return -1;
+        pos = (pos + step) & mask;
+    }
+}
+
+static int l3_index_insert(l3_order_index_t* index, l3_order_t* order);
+
+// Rehash into a table twice as large once live + tombstones pass 7/8
+static int l3_index_grow(l3_order_index_t* index) {
+    l3_order_index_t bigger;
+    size_t capacity = index->live * 2 > index->capacity ? index->capacity * 2 : index->capacity;
+    if (!l3_index_init(&bigger, capacity)) return 0;
+    
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->ctrl[i] < L3_CTRL_EMPTY) l3_index_insert(&bigger, index->slots[i]);
+    }
+    l3_index_free(index);
+    *index = bigger;
+    return 1;
+}
+
+// The id must not be in the table yet
+static int l3_index_insert(l3_order_index_t* index, l3_order_t* order) {
+    if ((index->used + 1) * 8 > index->capacity * 7 && !l3_index_grow(index)) return 0;
+    
+    uint64_t hash = l3_hash(order->id);
+    size_t mask = index->capacity - 1;
+    size_t pos = l3_probe_start(index->capacity, hash);
+    
+    for (size_t step = L3_GROUP; ; step += L3_GROUP) {
+        // Empty and deleted control bytes both have the top bit set
+        uint32_t free_slots = l3_group_match(index->ctrl + pos, L3_CTRL_EMPTY) |
+                              l3_group_match(index->ctrl + pos, L3_CTRL_DELETED);
+        if (free_slots) {
+            size_t slot = pos + __builtin_ctz(free_slots);
+            if (index->ctrl[slot] == L3_CTRL_EMPTY) index->used++;
+            l3_set_ctrl(index, slot, hash >> 57);
+            index->slots[slot] = order;
+            index->live++;
+            return 1;
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+// A group that still has an empty slot has never been full, so no probe
+// went past it: the slot can go back to empty instead of a tombstone
+static inline void l3_index_erase(l3_order_index_t* index, size_t slot) {
+    size_t group = slot & ~(size_t)(L3_GROUP - 1);
+    if (l3_group_match(index->ctrl + group, L3_CTRL_EMPTY)) {
+        l3_set_ctrl(index, slot, L3_CTRL_EMPTY);
+        index->used--;
+    } else {
+        l3_set_ctrl(index, slot, L3_CTRL_DELETED);
+    }
+    index->live--;
+}
+
+// Pool and index are sized for expected_orders resting at once, and grow past it
+int l3_book_init(l3_book_t* book, uint64_t base_price, size_t expected_orders) {
+    memset(book, 0, sizeof(*book));
+    book->base_price = base_price;
+    slab_pool_init(&book->orders, sizeof(l3_order_t));
+    
+    return slab_pool_reserve(&book->orders, expected_orders) &&
+           l3_index_init(&book->index, expected_orders + expected_orders / 4) &&
+           price_bitmap_init(&book->bid_bitmap, L3_PRICE_RANGE) &&
+           price_bitmap_init(&book->ask_bitmap, L3_PRICE_RANGE);
+}
+
+void l3_book_free(l3_book_t* book) {
+    l3_index_free(&book->index);
+    price_bitmap_free(&book->bid_bitmap);
+    price_bitmap_free(&book->ask_bitmap);
+    slab_pool_destroy(&book->orders);
+}
+
+// New order at the back of its level's queue
+int l3_add_order(l3_book_t* book, uint64_t id, uint64_t price, uint32_t quantity, int is_bid) {
+    uint64_t tick = price - book->base_price;
+    if (tick >= L3_PRICE_RANGE || l3_index_find(&book->index, id) >= 0) return 0;
+    
+    l3_order_t* order = slab_alloc(&book->orders);
+    if (!order) return 0;
+    order->id = id;
+    if (!l3_index_insert(&book->index, order)) {
+        slab_free(&book->orders, order);
+        return 0;
+    }
+    order->price = price;
+    order->quantity = quantity;
+    order->is_bid = is_bid;
+
+    l3_level_t* level = &(is_bid ? book->bid_levels : book->ask_levels)[tick];
+    order->level = level;
+    order->next = NULL;
+    order->prev = level->tail;
+    if (level->tail) level->tail->next = order; else level->head = order;
+    level->tail = order;
+    
+    if (level->order_count++ == 0) {
+        price_bitmap_set(is_bid ? &book->bid_bitmap : &book->ask_bitmap, tick);
+    }
+    level->total_quantity += quantity;
+    return 1;
+}
+
+static inline void l3_remove_order(l3_book_t* book, l3_order_t* order, size_t slot) {
+    l3_level_t* level = order->level;
+    
+    if (order->prev) order->prev->next = order->next; else level->head = order->next;
+    if (order->next) order->next->prev = order->prev; else level->tail = order->prev;
+    level->total_quantity -= order->quantity;
+    if (--level->order_count == 0) {
+        price_bitmap_clear(order->is_bid ? &book->bid_bitmap : &book->ask_bitmap,
+                           order->price - book->base_price);
+    }
+    
+    l3_index_erase(&book->index, slot);
+    slab_free(&book->orders, order);
+}
+
+int l3_cancel_order(l3_book_t* book, uint64_t id) {
+    int64_t slot = l3_index_find(&book->index, id);
+    if (slot < 0) return 0;
+    
+    l3_remove_order(book, book->index.slots[slot], slot);
+    return 1;
+}
+
+// Partial cancel: the order keeps its queue position; reducing it to
+// nothing removes it
+int l3_reduce_order(l3_book_t* book, uint64_t id, uint32_t quantity) {
+    int64_t slot = l3_index_find(&book->index, id);
+    if (slot < 0) return 0;
+    
+    l3_order_t* order = book->index.slots[slot];
+    if (quantity >= order->quantity) {
+        l3_remove_order(book, order, slot);
+    } else {
+        order->quantity -= quantity;
+        order->level->total_quantity -= quantity;
+    }
+    return 1;
+}
+
+// Fill against a resting order (L3 feeds name the order executed)
+int l3_execute_order(l3_book_t* book, uint64_t id, uint32_t quantity) {
+    int64_t slot = l3_index_find(&book->index, id);
+    if (slot < 0) return 0;
+    
+    l3_order_t* order = book->index.slots[slot];
+    uint32_t filled = quantity < order->quantity ? quantity : order->quantity;
+    book->executed_quantity += filled;
+    return l3_reduce_order(book, id, filled);
+}
+
+// Best price of a side, 0 if empty
+static inline uint64_t l3_best(const l3_book_t* book, int is_bid) {
+    int64_t tick = is_bid ? price_bitmap_prev(&book->bid_bitmap, L3_PRICE_RANGE - 1)
+                          : price_bitmap_next(&book->ask_bitmap, 0);
+    return tick < 0 ? 0 : book->base_price + tick;
+}
+
+// =============================================================================
+// 10. MATCHING ENGINE (PRICE-TIME PRIORITY ON THE ARRAY BOOK)
+// =============================================================================
+// Incoming orders cross the opposite side of an array_book_t from the best
+// level inwards. Within a level orders are queued oldest first, so filling
+// from the front of the first chunk gives time priority. Fills go into a buffer the caller
+// allocates up front, so nothing is allocated while matching.
+typedef enum {
+    MATCH_LIMIT,                           // cross up to price, rest the remainder
+    MATCH_MARKET,                          // cross at any price, drop the remainder
+    MATCH_IOC                              // cross up to price, drop the remainder
+} match_type_t;
+
+typedef struct {
+    match_type_t type;
+    uint64_t id;
+    uint64_t price;                        // ignored for market orders
+    uint32_t quantity;
+    int is_buy;
+} match_order_t;
+
+typedef struct {
+    uint64_t taker_id;
+    uint64_t maker_id;
+    uint64_t price;                        // the resting order's price
+    uint32_t quantity;
+} fill_t;
+
+typedef struct {
+    fill_t* fills;
+    int capacity;
+    int count;
+} fill_buffer_t;
+
+static inline int match_crosses(const match_order_t* order, uint64_t level_price) {
+    if (order->type == MATCH_MARKET) return 1;
+    return order->is_buy ? level_price <= order->price : level_price >= order->price;
+}
+
+typedef enum {
+    MATCH_COMPLETE,                        // remainder rested (limit) or dropped
+    MATCH_FILLS_FULL                       // stopped on a full fill buffer, see match_order
+} match_status_t;
+
+// Sets *filled to the quantity filled. If the fill buffer (capacity >= 1)
+// fills up while the order still crosses, matching stops there and returns
+// MATCH_FILLS_FULL without resting or dropping anything: resting then would
+// leave the book crossed. The caller drains the fills and calls again with
+// the quantity reduced by *filled. Resting goes through array_insert_order,
+// so it shares its MAX_PRICE_LEVELS limit.
+match_status_t match_order(array_book_t* book, const match_order_t* order, fill_buffer_t* out,
+                           uint32_t* filled) {
+    const uint64_t* prices = order->is_buy ? book->ask_prices : book->bid_prices;
+    array_price_level_t* levels = order->is_buy ? book->asks : book->bids;
+    int* count = order->is_buy ? &book->ask_count : &book->bid_count;
+    uint32_t remaining = order->quantity;
+    
+    while (remaining && *count > 0 && out->count < out->capacity &&
+           match_crosses(order, prices[*count - 1])) {
+        array_price_level_t* level = &levels[*count - 1];
+        uint64_t level_price = prices[*count - 1];
+        
+        while (level->first && remaining && out->count < out->capacity) {
+            array_order_chunk_t* chunk = level->first;
+            order_t* maker = &chunk->orders[chunk->head];
+            uint32_t quantity = remaining < maker->quantity ? remaining : maker->quantity;
+            
+            out->fills[out->count++] = (fill_t){ order->id, maker->id, level_price, quantity };
+            maker->quantity -= quantity;
+            // An L2 update may have set the total below what is queued
+            level->total_quantity -= quantity < level->total_quantity ? quantity : level->total_quantity;
+            remaining -= quantity;
+            
+            if (maker->quantity == 0) {
+                level->count--;
+                if (++chunk->head == chunk->tail) {
+                    level->first = chunk->next;
+                    if (!level->first) level->last = NULL;
+                    slab_free(&book->chunks, chunk);
+                }
+            }
+        }
+        
+        if (!level->first && level->total_quantity && remaining && out->count < out->capacity) {
+            // Quantity with no orders queued behind it, set by
+            // array_update_level: it fills like any other, with maker_id 0
+            uint32_t quantity = remaining < level->total_quantity ? remaining : level->total_quantity;
+            out->fills[out->count++] = (fill_t){ order->id, 0, level_price, quantity };
+            level->total_quantity -= quantity;
+            remaining -= quantity;
+        }
+        
+        if (!level->first && !level->total_quantity) {
+            // Level swept (best is last, so dropping it is just a decrement)
+            (*count)--;
+        }
+    }
+    
+    *filled = order->quantity - remaining;
+    if (remaining && *count > 0 && match_crosses(order, prices[*count - 1])) {
+        return MATCH_FILLS_FULL;
+    }
+    if (remaining && order->type == MATCH_LIMIT) {
+        order_t rest = { .id = order->id, .price = order->price, .quantity = remaining };
+        array_insert_order(book, &rest, order->is_buy);
+    }
+    return MATCH_COMPLETE;
+}
+
+// Match an order to completion, draining the fill buffer whenever it fills
+// up. Returns the number of fills.
+static uint64_t match_order_drained(array_book_t* book, const match_order_t* order,
+                                    fill_buffer_t* out) {
+    match_order_t rest = *order;
+    uint64_t fills = 0;
+    uint32_t filled;
+    out->count = 0;
+    while (match_order(book, &rest, out, &filled) == MATCH_FILLS_FULL) {
+        fills += out->count;
+        out->count = 0;
+        rest.quantity -= filled;
+    }
+    return fills + out->count;
+}
+
+// =============================================================================
+// BENCHMARK AND COMPARISON FUNCTIONS
+// =============================================================================
+
+void print_performance_characteristics() {
+    printf("ORDER BOOK DATA STRUCTURE COMPARISON:\n\n");
+    
+    printf("1. SIMPLE LINKED LIST:\n");
+    printf("   - Insertion: O(n) worst, O(1) best (front insertion)\n");
+    printf("   - Search: O(n)\n");
+    printf("   - Memory: ~24 bytes/level + 32 bytes/order\n");
+    printf("   - Cache: Poor (pointer chasing)\n");
+    printf("   - Pros: Simple, flexible\n");
+    printf("   - Cons: Slow for deep books\n\n");
+    
+    printf("2. ARRAY-BASED:\n");
+    printf("   - Insertion: O(log n) search + shift of the levels better than it\n");
+    printf("     (stored worst-to-best, so updates near the touch shift little)\n");
+    printf("   - Search: vector scan of the %d levels nearest the touch,\n", ARRAY_TOUCH_LEVELS);
+    printf("     branchless O(log n) binary search of the dense price index below\n");
+    printf("   - Memory: Dense 8-byte price index + 24-byte level records\n");
+    printf("     + chained %d-order chunks\n", ARRAY_CHUNK_ORDERS);
+    printf("   - Cache: Excellent (sequential access)\n");
+    printf("   - Pros: Fast reads, good cache locality, unbounded queues\n");
+    printf("   - Cons: Insertions shift levels, fixed level capacity\n\n");
+    
+    printf("3. SKIP LIST:\n");
+    printf("   - Insertion: O(log n) expected\n");
+    printf("   - Search: O(log n) expected\n");
+    printf("   - Memory: ~35 bytes/level (24 + 8 per forward pointer, 1.33 on average)\n");
+    printf("   - Cache: Moderate (some pointer chasing)\n");
+    printf("   - Pros: Balanced performance\n");
+    printf("   - Cons: Probabilistic, complex\n\n");
+    
+    printf("4. DIRECT ARRAY MAPPING:\n");
+    printf("   - Insertion: O(1)\n");
+    printf("   - Search: O(1)\n");
+    printf("   - Best price after a delete: O(levels of bitmap) with the\n");
+    printf("     occupancy bitmap, O(gap to next level) without\n");
+    printf("   - Memory: Large fixed allocation\n");
+    printf("   - Cache: Excellent\n");
+    printf("   - Pros: Fastest possible operations\n");
+    printf("   - Cons: Huge memory usage, limited price range\n\n");
+    
+    printf("5. LOCK-FREE (HARRIS-MICHAEL LIST + EPOCHS):\n");
+    printf("   - Insertion: O(n) walk + CAS, retried on conflict\n");
+    printf("   - Deletion: mark then unlink, reclaimed two epochs later\n");
+    printf("   - Memory: 64 bytes/level from a slab pool, per-thread caches\n");
+    printf("   - Cache: Moderate (pointer chasing, contended heads)\n");
+    printf("   - Pros: Concurrent writers and readers, no locks\n");
+    printf("   - Cons: Every writer fights over the same cache lines at the touch\n\n");
+    
+    printf("6. SLIDING-WINDOW DIRECT MAPPING:\n");
+    printf("   - Insertion: O(1) within %d ticks of the mid, O(log n) in the overflow\n", WINDOW_TICKS);
+    printf("   - Search: O(1) in the window, O(log n) outside\n");
+    printf("   - Re-center: lazy, O(ticks shifted) + overflow levels moving back in\n");
+    printf("   - Memory: ~128 KB of slots (fits in L2) + sorted overflow\n");
+    printf("   - Pros: Direct-mapping speed at any absolute price\n");
+    printf("   - Cons: Deep levels pay the overflow cost\n\n");
+    
+    printf("7. B+TREE (%d-BYTE NODES):\n", BTREE_NODE_SIZE);
+    printf("   - Insertion: O(log n), splits touch one node per level\n");
+    printf("   - Search: O(log n), a few cache lines per level\n");
+    printf("   - Best price: O(1) from the first/last leaf\n");
+    printf("   - Memory: proportional to levels, nodes recycled through a free list\n");
+    printf("   - Cache: Good (linked leaves make depth walks sequential)\n");
+    printf("   - Pros: Any price range, stays fast in deep sparse books\n");
+    printf("   - Cons: Slower than direct mapping near the touch\n\n");
+    
+    printf("8. L3 MARKET-BY-ORDER (ORDER-ID INDEX):\n");
+    printf("   - Add: O(1) append to the level's FIFO queue\n");
+    printf("   - Cancel/reduce/execute by id: O(1), one hash probe + unlink\n");
+    printf("   - Index: open addressing, %d control bytes compared per SIMD probe\n", L3_GROUP);
+    printf("   - Memory: direct-mapped levels + %zu bytes/order + ~1.3 index slots/order\n",
+           sizeof(l3_order_t));
+    printf("   - Pros: Queue position per order, no search on the hot path\n");
+    printf("   - Cons: Bounded price range, memory per resting order\n\n");
+    
+    printf("9. MATCHING ENGINE (ON THE ARRAY BOOK):\n");
+    printf("   - Limit / IOC / market orders, price-time priority\n");
+    printf("   - Per fill: O(1), orders consumed from the front of the best level's queue\n");
+    printf("   - Swept level: O(1) (best level is the last element)\n");
+    printf("   - Fills written to a caller-allocated buffer, no allocation\n\n");
+}
+
+// =============================================================================
+// BENCHMARK INFRASTRUCTURE
+// =============================================================================
+
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// High precision timing
+static inline uint64_t get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+typedef enum {
+    PERF_L1D_READ_MISSES,
+    PERF_LLC_MISSES
+} perf_counter_t;
+
+// Hardware counter for the calling thread, -1 where perf events are not
+// available (macOS, or perf_event_paranoid too strict in a VM/container)
+static int perf_counter_open(perf_counter_t counter) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    if (counter == PERF_L1D_READ_MISSES) {
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    } else {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    }
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)counter;
+    return -1;
+#endif
+}
+
+static void perf_counter_start(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+// Events counted since perf_counter_start, -1 if the counter is unavailable
+static int64_t perf_counter_stop(int fd) {
+#ifdef __linux__
+    uint64_t value;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+    return (int64_t)value;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+// Generate realistic order data
+typedef struct benchmark_order {
+    uint64_t id;
+    uint64_t price;
+    uint32_t quantity;
+    int is_bid;
+} benchmark_order_t;
+
+void generate_orders(benchmark_order_t* orders, int count, uint64_t base_price) {
+    srand(42); // Deterministic for consistent benchmarks
+    
+    for (int i = 0; i < count; i++) {
+        orders[i].id = i;
+        // Generate prices in a realistic spread around base_price
+        int price_offset = (rand() % 1000) - 500; // ±500 ticks
+        orders[i].price = base_price + price_offset;
+        orders[i].quantity = 100 + (rand() % 10000); // 100-10100 shares
+        orders[i].is_bid = rand() % 2;
+    }
+}
+
+// =============================================================================
+// BENCHMARK FUNCTIONS FOR EACH DATA STRUCTURE
+// =============================================================================
+
+// Mixed L2 workload: new orders, level quantity changes and level deletions
+typedef enum {
+    OP_INSERT,
+    OP_MODIFY,
+    OP_DELETE
+} book_op_type_t;
+
+typedef struct book_op {
+    book_op_type_t type;
+    uint64_t id;
+    uint64_t price;
+    uint32_t quantity;
+    int is_bid;
+} book_op_t;
+
+// Realistic diff-feed traffic: 20% new orders, 60% quantity changes and
+// 20% deletions, with most activity within a few ticks of the touch.
+// Bids sit below base_price and asks at or above it, so the book never crosses.
+void generate_book_ops(book_op_t* ops, int count, uint64_t base_price) {
+    srand(42); // Deterministic for consistent benchmarks
+    
+    for (int i = 0; i < count; i++) {
+        int r = rand() % 100;
+        ops[i].type = r < 20 ? OP_INSERT : (r < 80 ? OP_MODIFY : OP_DELETE);
+        ops[i].id = i;
+        
+        // 7 in 8 updates hit the first 10 levels, the rest up to 500 deep
+        uint64_t distance = (rand() % 8) ? rand() % 10 : rand() % 500;
+        ops[i].is_bid = rand() % 2;
+        ops[i].price = ops[i].is_bid ? base_price - 1 - distance : base_price + distance;
+        ops[i].quantity = 100 + (rand() % 10000);
+    }
+}
+
+// A deep book: the same mix spread uniformly over 5000 levels per side, as
+// when mirroring a full depth snapshot rather than trading the touch
+#define DEEP_BOOK_DEPTH 5000
+
+void generate_deep_ops(book_op_t* ops, int count, uint64_t base_price) {
+    srand(42);
+    
+    for (int i = 0; i < count; i++) {
+        int r = rand() % 100;
+        ops[i].type = r < 20 ? OP_INSERT : (r < 80 ? OP_MODIFY : OP_DELETE);
+        ops[i].id = i;
+        
+        uint64_t distance = rand() % DEEP_BOOK_DEPTH;
+        ops[i].is_bid = rand() % 2;
+        ops[i].price = ops[i].is_bid ? base_price - 1 - distance : base_price + distance;
+        ops[i].quantity = 100 + (rand() % 10000);
+    }
+}
+
+// A sweep thinning the book out: 55% of the ops delete the current best
+// level of a side, the rest add levels scattered up to 40000 ticks deep.
+// Every delete moves the top into a sparse (often empty) side, which is
+// what the direct book's best-price recovery has to handle.
+#define DELETE_HEAVY_DEPTH 40000
+
+void generate_delete_heavy_ops(book_op_t* ops, int count, uint64_t base_price) {
+    price_bitmap_t live[2];  // occupied distances from the touch, per side
+    price_bitmap_init(&live[0], DELETE_HEAVY_DEPTH);
+    price_bitmap_init(&live[1], DELETE_HEAVY_DEPTH);
+    srand(42);
+    
+    for (int i = 0; i < count; i++) {
+        int is_bid = rand() % 2;
+        int64_t best = price_bitmap_next(&live[is_bid], 0);
+        uint64_t distance;
+        
+        if (rand() % 100 < 55 && best >= 0) {
+            ops[i].type = OP_DELETE;
+            distance = best;
+            price_bitmap_clear(&live[is_bid], distance);
+        } else {
+            ops[i].type = OP_INSERT;
+            distance = (rand() % 4) ? rand() % DELETE_HEAVY_DEPTH : rand() % 10;
+            price_bitmap_set(&live[is_bid], distance);
+        }
+        
+        ops[i].id = i;
+        ops[i].is_bid = is_bid;
+        ops[i].price = is_bid ? base_price - 1 - distance : base_price + distance;
+        ops[i].quantity = 100 + (rand() % 10000);
+    }
+    
+    price_bitmap_free(&live[0]);
+    price_bitmap_free(&live[1]);
+}
+
+// A trending market at real BTCUSDT prices ($0.01 ticks, ~11.8M ticks):
+// the mid moves up one tick on 3 in 8 ops and down one on 1 in 8, each move
+// deleting the level it crossed so the book stays uncrossed; the other ops
+// follow generate_book_ops around the current mid. The prices are far outside
+// the direct book's range, and the touch drifts ~1/4 tick per op.
+#define BTC_TICK_PRICE 11872839ULL
+
+void generate_drifting_ops(book_op_t* ops, int count, uint64_t base_price) {
+    uint64_t mid = base_price;
+    srand(42);
+    
+    for (int i = 0; i < count; i++) {
+        int r = rand() % 8;
+        ops[i].id = i;
+        ops[i].quantity = 100 + (rand() % 10000);
+        
+        if (r < 3) {
+            // Old best ask is now below the mid
+            ops[i].type = OP_DELETE;
+            ops[i].is_bid = 0;
+            ops[i].price = mid++;
+        } else if (r == 3) {
+            // Old best bid is now at the mid
+            ops[i].type = OP_DELETE;
+            ops[i].is_bid = 1;
+            ops[i].price = --mid;
+        } else {
+            int t = rand() % 100;
+            ops[i].type = t < 20 ? OP_INSERT : (t < 80 ? OP_MODIFY : OP_DELETE);
+            uint64_t distance = (rand() % 8) ? rand() % 10 : rand() % 500;
+            ops[i].is_bid = rand() % 2;
+            ops[i].price = ops[i].is_bid ? mid - 1 - distance : mid + distance;
+        }
+    }
+}
+
+// L3 (market-by-order) events, ITCH style: adds carry price and side, every
+// other event only names an order id.
+#define L3_LIVE_TARGET 2000
+
+typedef enum {
+    L3_ADD,
+    L3_CANCEL,
+    L3_REDUCE,                             // partial cancel
+    L3_EXECUTE
+} l3_event_type_t;
+
+typedef struct {
+    l3_event_type_t type;
+    uint64_t id;
+    uint64_t price;                        // adds only
+    uint32_t quantity;
+    int is_bid;                            // adds only
+} l3_event_t;
+
+// Keeps about L3_LIVE_TARGET orders resting, priced like generate_book_ops
+// (7 in 8 within 10 ticks of base_price). Cancels, reduces and executes pick
+// a random live order; reduces and executes take part of it or all of it.
+void generate_l3_events(l3_event_t* events, int count, uint64_t base_price) {
+    typedef struct { uint64_t id; uint32_t quantity; } live_order_t;
+    live_order_t* live = malloc(count * sizeof(live_order_t));
+    int live_count = 0;
+    uint64_t next_id = 1;
+    srand(42);
+    
+    for (int i = 0; i < count; i++) {
+        l3_event_t* e = &events[i];
+        int add_percent = live_count < L3_LIVE_TARGET ? 60 : 40;
+        
+        if (live_count == 0 || rand() % 100 < add_percent) {
+            uint64_t distance = (rand() % 8) ? rand() % 10 : rand() % 500;
+            e->type = L3_ADD;
+            e->id = next_id++;
+            e->is_bid = rand() % 2;
+            e->price = e->is_bid ? base_price - 1 - distance : base_price + distance;
+            e->quantity = 100 + (rand() % 10000);
+            live[live_count++] = (live_order_t){ e->id, e->quantity };
+            continue;
+        }
+        
+        int pick = rand() % live_count;
+        int t = rand() % 100;
+        e->type = t < 55 ? L3_CANCEL : (t < 75 ? L3_REDUCE : L3_EXECUTE);
+        e->id = live[pick].id;
+        e->price = 0;
+        e->is_bid = 0;
+        e->quantity = e->type == L3_CANCEL ? live[pick].quantity
+                                           : 1 + rand() % live[pick].quantity;
+        
+        live[pick].quantity -= e->quantity;
+        if (live[pick].quantity == 0) live[pick] = live[--live_count];
+    }
+    
+    free(live);
+}
+
+// Order flow for the matching engine around a fixed mid: 70% limit orders
+// spread over ~20 ticks (about 1 in 7 priced through the touch), 15% IOC
+// and 15% market orders taking liquidity at the touch. Takers are twice
+// the size of limit orders to keep the touch moving; nothing cancels, so the
+// queues at the deeper levels keep growing.
+void generate_match_orders(match_order_t* orders, int count, uint64_t mid) {
+    srand(42);
+    
+    for (int i = 0; i < count; i++) {
+        match_order_t* o = &orders[i];
+        int r = rand() % 100;
+        int64_t distance;
+        
+        o->id = i + 1;
+        o->is_buy = rand() % 2;
+        if (r < 70) {
+            o->type = MATCH_LIMIT;
+            o->quantity = 100 + (rand() % 10000);
+            distance = rand() % 20 - 3;
+        } else if (r < 85) {
+            o->type = MATCH_IOC;
+            o->quantity = 100 + (rand() % 20000);
+            distance = -(rand() % 4);
+        } else {
+            o->type = MATCH_MARKET;
+            o->quantity = 100 + (rand() % 20000);
+            distance = 0;
+        }
+        // Negative distances cross: bids at or above mid, asks below it
+        o->price = o->is_buy ? mid - 1 - distance : mid + distance;
+    }
+}
+
+// The direct book indexes bids at PRICE_OFFSET - price and asks at price
+static int ops_fit_direct_book(const book_op_t* ops, int count) {
+    for (int i = 0; i < count; i++) {
+        if (ops[i].price == 0 || ops[i].price >= (ops[i].is_bid ? PRICE_OFFSET : PRICE_RANGE)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static inline void fill_order(order_t* order, const book_op_t* op) {
+    order->id = op->id;
+    order->price = op->price;
+    order->quantity = op->quantity;
+    order->timestamp = 0;
+    order->next = NULL;
+}
+
+// Inserted orders come from the orders pool (sizeof(order_t)) and stay there
+void simple_apply_ops(simple_book_t* book, const book_op_t* ops, int count, slab_pool_t* orders) {
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            order_t* order = slab_alloc(orders);
+            if (!order) break;
+            fill_order(order, &ops[i]);
+            simple_insert_order(book, order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            simple_update_level(book, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            simple_delete_level(book, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+}
+
+void array_apply_ops(array_book_t* book, const book_op_t* ops, int count) {
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            order_t order;
+            fill_order(&order, &ops[i]);
+            array_insert_order(book, &order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            array_update_level(book, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            array_delete_level(book, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+}
+
+void direct_apply_ops(direct_book_t* book, const book_op_t* ops, int count, slab_pool_t* orders) {
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            order_t* order = slab_alloc(orders);
+            if (!order) break;
+            fill_order(order, &ops[i]);
+            direct_insert_order(book, order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            direct_update_level(book, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            direct_delete_level(book, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+}
+
+void window_apply_ops(window_book_t* book, const book_op_t* ops, int count, slab_pool_t* orders) {
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            order_t* order = slab_alloc(orders);
+            if (!order) break;
+            fill_order(order, &ops[i]);
+            window_insert_order(book, order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            window_update_level(book, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            window_delete_level(book, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+}
+
+void skip_apply_ops(skip_book_t* book, const book_op_t* ops, int count, slab_pool_t* orders) {
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            order_t* order = slab_alloc(orders);
+            if (!order) break;
+            fill_order(order, &ops[i]);
+            skip_insert_order(book, order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            skip_update_level(book, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            skip_delete_level(book, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+}
+
+// Pins once per LOCKFREE_PIN_BATCH ops to amortize the fence
+void lockfree_apply_ops(lockfree_book_t* book, lockfree_thread_t* t, const book_op_t* ops, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i % LOCKFREE_PIN_BATCH == 0) {
+            if (i) lockfree_unpin(t);
+            lockfree_pin(book, t);
+        }
+        
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            lockfree_order_t* order = slab_cache_alloc(&t->orders);
+            if (!order) break;
+            order->id = ops[i].id;
+            order->price = ops[i].price;
+            order->quantity = ops[i].quantity;
+            order->timestamp = 0;
+            lockfree_insert_order(book, t, order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            lockfree_update_level(book, t, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            lockfree_delete_level(book, t, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+    if (count) lockfree_unpin(t);
+}
+
+void btree_apply_ops(btree_book_t* book, const book_op_t* ops, int count, slab_pool_t* orders) {
+    for (int i = 0; i < count; i++) {
+        switch (ops[i].type) {
+        case OP_INSERT: {
+            order_t* order = slab_alloc(orders);
+            if (!order) break;
+            fill_order(order, &ops[i]);
+            btree_insert_order(book, order, ops[i].is_bid);
+            break;
+        }
+        case OP_MODIFY:
+            btree_update_level(book, ops[i].price, ops[i].quantity, ops[i].is_bid);
+            break;
+        case OP_DELETE:
+            btree_delete_level(book, ops[i].price, ops[i].is_bid);
+            break;
+        }
+    }
+}
+
+void l3_apply_events(l3_book_t* book, const l3_event_t* events, int count) {
+    for (int i = 0; i < count; i++) {
+        switch (events[i].type) {
+        case L3_ADD:
+            l3_add_order(book, events[i].id, events[i].price, events[i].quantity, events[i].is_bid);
+            break;
+        case L3_CANCEL:
+            l3_cancel_order(book, events[i].id);
+            break;
+        case L3_REDUCE:
+            l3_reduce_order(book, events[i].id, events[i].quantity);
+            break;
+        case L3_EXECUTE:
+            l3_execute_order(book, events[i].id, events[i].quantity);
+            break;
+        }
+    }
+}
+
+// Added orders come from the orders pool; returns the executed volume
+uint64_t simple_apply_l3_events(simple_book_t* book, const l3_event_t* events, int count,
+                                slab_pool_t* orders) {
+    uint64_t executed = 0;
+    
+    for (int i = 0; i < count; i++) {
+        switch (events[i].type) {
+        case L3_ADD: {
+            order_t* order = slab_alloc(orders);
+            if (!order) break;
+            *order = (order_t){ .id = events[i].id, .price = events[i].price,
+                                .quantity = events[i].quantity };
+            simple_insert_order(book, order, events[i].is_bid);
+            break;
+        }
+        case L3_CANCEL:
+            simple_reduce_order(book, events[i].id, UINT32_MAX);
+            break;
+        case L3_REDUCE:
+            simple_reduce_order(book, events[i].id, events[i].quantity);
+            break;
+        case L3_EXECUTE:
+            executed += simple_reduce_order(book, events[i].id, events[i].quantity);
+            break;
+        }
+    }
+    return executed;
+}
+
+// =============================================================================
+// BENCHMARK FUNCTIONS FOR EACH DATA STRUCTURE
+// =============================================================================
+
+// Simple linked list benchmark
+double benchmark_simple_book(book_op_t* ops, int count) {
+    simple_book_t book;
+    simple_book_init(&book);
+    slab_pool_reserve(&book.levels, count);
+    
+    // Fault the slabs in up front so only the book is timed
+    slab_pool_t orders;
+    slab_pool_init(&orders, sizeof(order_t));
+    slab_pool_reserve(&orders, count);
+    
+    uint64_t start = get_time_ns();
+    simple_apply_ops(&book, ops, count, &orders);
+    uint64_t end = get_time_ns();
+    
+    // Cleanup
+    simple_book_free(&book);
+    slab_pool_destroy(&orders);
+    
+    return (end - start) / 1000000.0; // Convert to milliseconds
+}
+
+// Array-based benchmark
+double benchmark_array_book(book_op_t* ops, int count) {
+    array_book_t* book = malloc(sizeof(array_book_t));
+    array_book_init(book);
+    slab_pool_reserve(&book->chunks, count / ARRAY_CHUNK_ORDERS);
+    
+    uint64_t start = get_time_ns();
+    array_apply_ops(book, ops, count);
+    uint64_t end = get_time_ns();
+    
+    array_book_free(book);
+    free(book);
+    return (end - start) / 1000000.0;
+}
+
+// Allocate the large arrays, and the occupancy bitmaps if asked
+int direct_book_init(direct_book_t* book, int with_bitmaps) {
+    memset(book, 0, sizeof(*book));
+    book->bid_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
+    book->ask_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
+    if (!book->bid_levels || !book->ask_levels) return 0;
+    
+    if (with_bitmaps) {
+        return price_bitmap_init(&book->bid_bitmap, PRICE_RANGE) &&
+               price_bitmap_init(&book->ask_bitmap, PRICE_RANGE);
+    }
+    return 1;
+}
+
+void direct_book_free(direct_book_t* book) {
+    free(book->bid_levels);
+    free(book->ask_levels);
+    price_bitmap_free(&book->bid_bitmap);
+    price_bitmap_free(&book->ask_bitmap);
+}
+
+// Direct mapping benchmark
+double benchmark_direct_book(book_op_t* ops, int count, int with_bitmaps) {
+    direct_book_t book;
+    
+    if (!direct_book_init(&book, with_bitmaps)) {
+        direct_book_free(&book);
+        return -1; // Memory allocation failed
+    }
+    
+    slab_pool_t orders;
+    slab_pool_init(&orders, sizeof(order_t));
+    slab_pool_reserve(&orders, count);
+    
+    uint64_t start = get_time_ns();
+    direct_apply_ops(&book, ops, count, &orders);
+    uint64_t end = get_time_ns();
+    
+    // Cleanup
+    direct_book_free(&book);
+    slab_pool_destroy(&orders);
+    
+    return (end - start) / 1000000.0;
+}
+
+// Sliding-window benchmark
+double benchmark_window_book(book_op_t* ops, int count) {
+    window_book_t* book = malloc(sizeof(window_book_t));
+    if (!book || !window_book_init(book)) {
+        if (book) window_book_free(book);
+        free(book);
+        return -1;
+    }
+    
+    slab_pool_t orders;
+    slab_pool_init(&orders, sizeof(order_t));
+    slab_pool_reserve(&orders, count);
+    
+    uint64_t start = get_time_ns();
+    window_apply_ops(book, ops, count, &orders);
+    uint64_t end = get_time_ns();
+    
+    window_book_free(book);
+    free(book);
+    slab_pool_destroy(&orders);
+    
+    return (end - start) / 1000000.0;
+}
+
+// Skip list benchmark
+double benchmark_skip_book(book_op_t* ops, int count) {
+    skip_book_t book;
+    if (!skip_book_init(&book)) {
+        skip_book_free(&book);
+        return -1;
+    }
+    // ~1.33 forward pointers per node
+    slab_pool_reserve(&book.chunks, count * skip_node_size(2) / SKIP_SLAB_SIZE + 1);
+    slab_pool_t orders;
+    slab_pool_init(&orders, sizeof(order_t));
+    slab_pool_reserve(&orders, count);
+    
+    uint64_t start = get_time_ns();
+    skip_apply_ops(&book, ops, count, &orders);
+    uint64_t end = get_time_ns();
+    
+    skip_book_free(&book);
+    slab_pool_destroy(&orders);
+    
+    return (end - start) / 1000000.0;
+}
+
+// B+tree benchmark
+double benchmark_btree_book(book_op_t* ops, int count) {
+    btree_book_t book;
+    btree_book_init(&book);
+    slab_pool_reserve(&book.nodes, count / 2);
+    slab_pool_t orders;
+    slab_pool_init(&orders, sizeof(order_t));
+    slab_pool_reserve(&orders, count);
+    
+    uint64_t start = get_time_ns();
+    btree_apply_ops(&book, ops, count, &orders);
+    uint64_t end = get_time_ns();
+    
+    btree_book_free(&book);
+    slab_pool_destroy(&orders);
+    
+    return (end - start) / 1000000.0;
+}
+
+// SIMD benchmark
+double benchmark_simd_operations(uint32_t* quantities, int count) {
+    // Warm up caches
+    volatile uint64_t warmup = simd_sum_quantities(quantities, count);
+    (void)warmup; // Suppress unused warning
+    
+    uint64_t start = get_time_ns();
+    
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 1000; i++) { // Repeat for measurable time
+        sum += simd_sum_quantities(quantities, count);
+    }
+    
+    uint64_t end = get_time_ns();
+    return (end - start) / 1000000.0;
+}
+
+// Generic SIMD benchmark for comparison
+double benchmark_generic_operations(uint32_t* quantities, int count) {
+    // Warm up caches
+    volatile uint64_t warmup = simd_sum_quantities_generic(quantities, count);
+    (void)warmup; // Suppress unused warning
+    
+    uint64_t start = get_time_ns();
+    
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 1000; i++) { // Repeat for measurable time
+        sum += simd_sum_quantities_generic(quantities, count);
+    }
+    
+    uint64_t end = get_time_ns();
     return (end - start) / 1000000.0;
 }
 
-// SIMD benchmark
-double benchmark_simd_operations(uint32_t* quantities, int count) {
-    // Warm up caches
-    volatile uint64_t warmup = simd_sum_quantities(quantities, count);
-    (void)warmup; // Suppress unused warning
+// Read performance benchmark (market data queries)
+void benchmark_read_performance() {
+    printf("=== READ PERFORMANCE BENCHMARK ===\n");
+    
+    const int LEVELS = 100;
+    
+    // Create array-based book for testing (levels only, no orders)
+    array_book_t book;
+    array_book_init(&book);
+    
+    // Populate with sample data (stored worst-to-best, best level last)
+    for (int i = 0; i < LEVELS; i++) {
+        book.bid_prices[LEVELS - 1 - i] = 50000 - i;
+        book.bids[LEVELS - 1 - i].total_quantity = 1000 + i * 100;
+        book.ask_prices[LEVELS - 1 - i] = 50001 + i;
+        book.asks[LEVELS - 1 - i].total_quantity = 1000 + i * 100;
+    }
+    book.bid_count = LEVELS;
+    book.ask_count = LEVELS;
+    
+    // Benchmark top-of-book access (most common operation)
+    uint64_t start = get_time_ns();
+    volatile uint64_t best_bid_price = 0, best_ask_price = 0;
+    for (int i = 0; i < 1000000; i++) {
+        best_bid_price = ARRAY_BEST_BID_PRICE(&book);
+        best_ask_price = ARRAY_BEST_ASK_PRICE(&book);
+    }
+    uint64_t end = get_time_ns();
+    
+    // Use the variables to prevent optimization
+    if (best_bid_price == 0 || best_ask_price == 0) {
+        printf("Warning: benchmark may have been optimized away\n");
+    }
+    
+    printf("Top-of-book access: %.2f ns per operation\n", 
+           (end - start) / 1000000.0);
+    
+    // Benchmark market depth aggregation (sum top N levels)
+    const int DEPTH = 10;
+    start = get_time_ns();
+    volatile uint64_t total_bid_qty = 0, total_ask_qty = 0;
+    
+    for (int i = 0; i < 100000; i++) {
+        uint64_t bid_sum = 0, ask_sum = 0;
+        for (int j = 1; j <= DEPTH && j <= book.bid_count; j++) {
+            bid_sum += book.bids[book.bid_count - j].total_quantity;
+            ask_sum += book.asks[book.ask_count - j].total_quantity;
+        }
+        total_bid_qty = bid_sum;
+        total_ask_qty = ask_sum;
+    }
+    end = get_time_ns();
+    
+    // Use the variables to prevent optimization
+    if (total_bid_qty == 0 || total_ask_qty == 0) {
+        printf("Warning: depth benchmark may have been optimized away\n");
+    }
+    
+    printf("Market depth (top-%d): %.2f ns per operation\n", 
+           DEPTH, (end - start) / 100000.0);
+    
+    array_book_free(&book);
+}
+
+// Memory usage analysis
+void analyze_memory_usage() {
+    printf("\n=== MEMORY USAGE ANALYSIS ===\n");
+    
+    slab_pool_t probe;
+    slab_pool_init(&probe, sizeof(order_t));
+    slab_pool_reserve(&probe, 1);
+    printf("Slabs: %d KB, %s pages requested, %s pages granted\n", SLAB_SIZE / 1024,
+           slab_pages_names[slab_pages_wanted], slab_pages_names[slab_pool_pages(&probe)]);
+    slab_pool_destroy(&probe);
+    
+    const int ORDERS = 10000;
+    const int LEVELS = 500;
+    
+    printf("For %d orders across ~%d price levels:\n\n", ORDERS, LEVELS);
+    
+    size_t simple_memory = LEVELS * sizeof(price_level_t) + ORDERS * sizeof(order_t);
+    printf("Simple Linked List: %zu KB\n", simple_memory / 1024);
+    
+    size_t array_memory = sizeof(array_book_t) +
+                          (ORDERS / ARRAY_CHUNK_ORDERS + LEVELS) * sizeof(array_order_chunk_t);
+    printf("Array-based: %zu KB (%zu KB of levels + order chunks)\n", array_memory / 1024,
+           sizeof(array_book_t) / 1024);
+    
+    size_t direct_memory = 2 * PRICE_RANGE * sizeof(direct_price_level_t) + 
+                          ORDERS * sizeof(order_t);
+    printf("Direct Mapping: %zu MB (huge!)\n", direct_memory / (1024 * 1024));
+    size_t bitmap_memory = 2 * (PRICE_RANGE / 64 + PRICE_RANGE / 4096 + 2) * sizeof(uint64_t);
+    printf("  + occupancy bitmaps: %zu KB\n", bitmap_memory / 1024);
+    
+    size_t window_memory = sizeof(window_book_t) +
+                           2 * (WINDOW_TICKS / 64 + WINDOW_TICKS / 4096 + 2) * sizeof(uint64_t);
+    printf("Sliding Window: %zu KB (%d ticks, any price) + overflow levels\n",
+           window_memory / 1024, WINDOW_TICKS);
+    
+    // ~5 levels per leaf when full, ~3 after splits, plus ~1/5 inner nodes
+    size_t btree_memory = (LEVELS / 3 + LEVELS / 15) * BTREE_NODE_SIZE + ORDERS * sizeof(order_t);
+    printf("B+tree: %zu KB (%d-byte nodes, estimated)\n", btree_memory / 1024, BTREE_NODE_SIZE);
+    
+    // 4/3 forward pointers per node on average with p = 1/4
+    size_t skip_memory = LEVELS * (sizeof(skip_node_t) + 4 * sizeof(skip_node_t*) / 3) +
+                         ORDERS * sizeof(order_t);
+    printf("Skip List: %zu KB (estimated)\n", skip_memory / 1024);
+    
+    // One index slot (control byte + pointer) per order at ~3/4 load
+    size_t l3_memory = sizeof(l3_book_t) + ORDERS * (sizeof(l3_order_t) + 4 * (1 + sizeof(void*)) / 3);
+    printf("L3 by order: %zu KB (%d ticks of levels + order pool + id index)\n",
+           l3_memory / 1024, L3_PRICE_RANGE);
+}
+
+// =============================================================================
+// CORRECTNESS TESTING AND VALIDATION
+// =============================================================================
+
+typedef struct test_result {
+    int bid_levels;
+    int ask_levels;
+    uint64_t best_bid_price;
+    uint64_t best_ask_price;
+    uint64_t total_bid_quantity;
+    uint64_t total_ask_quantity;
+    uint64_t bid_price_checksum;  // Sum of all bid prices
+    uint64_t ask_price_checksum;  // Sum of all ask prices
+} test_result_t;
+
+// Extract results from simple book
+test_result_t extract_simple_book_results(simple_book_t* book) {
+    test_result_t result = {0};
+    
+    // Count bid levels and calculate metrics
+    price_level_t* current = book->bids;
+    while (current) {
+        result.bid_levels++;
+        if (result.bid_levels == 1) {
+            result.best_bid_price = current->price;
+        }
+        result.total_bid_quantity += current->total_quantity;
+        result.bid_price_checksum += current->price;
+        current = current->next;
+    }
+    
+    // Count ask levels and calculate metrics
+    current = book->asks;
+    while (current) {
+        result.ask_levels++;
+        if (result.ask_levels == 1) {
+            result.best_ask_price = current->price;
+        }
+        result.total_ask_quantity += current->total_quantity;
+        result.ask_price_checksum += current->price;
+        current = current->next;
+    }
+    
+    return result;
+}
+
+// Extract results from array book
+test_result_t extract_array_book_results(array_book_t* book) {
+    test_result_t result = {0};
+    
+    result.bid_levels = book->bid_count;
+    result.ask_levels = book->ask_count;
+    
+    if (book->bid_count > 0) {
+        result.best_bid_price = ARRAY_BEST_BID_PRICE(book);
+    }
+    if (book->ask_count > 0) {
+        result.best_ask_price = ARRAY_BEST_ASK_PRICE(book);
+    }
+    
+    for (int i = 0; i < book->bid_count; i++) {
+        result.total_bid_quantity += book->bids[i].total_quantity;
+        result.bid_price_checksum += book->bid_prices[i];
+    }
+    
+    for (int i = 0; i < book->ask_count; i++) {
+        result.total_ask_quantity += book->asks[i].total_quantity;
+        result.ask_price_checksum += book->ask_prices[i];
+    }
+    
+    return result;
+}
+
+// Extract results from direct book
+test_result_t extract_direct_book_results(direct_book_t* book) {
+    test_result_t result = {0};
+    
+    // Find best bid (highest price with orders)
+    for (uint64_t price = book->bid_top; price > 0; price--) {
+        if (price >= PRICE_OFFSET) break;
+        direct_price_level_t* level = &book->bid_levels[PRICE_OFFSET - price];
+        if (level->total_quantity > 0) {
+            if (result.bid_levels == 0) {
+                result.best_bid_price = price;
+            }
+            result.bid_levels++;
+            result.total_bid_quantity += level->total_quantity;
+            result.bid_price_checksum += price;
+        }
+    }
+    
+    // Find best ask (lowest price with orders)
+    for (uint64_t price = book->ask_top; price < PRICE_RANGE; price++) {
+        direct_price_level_t* level = &book->ask_levels[price];
+        if (level->total_quantity > 0) {
+            if (result.ask_levels == 0) {
+                result.best_ask_price = price;
+            }
+            result.ask_levels++;
+            result.total_ask_quantity += level->total_quantity;
+            result.ask_price_checksum += price;
+        }
+    }
+    
+    return result;
+}
+
+// Extract results from sliding-window book (slots and both overflows)
+test_result_t extract_window_book_results(window_book_t* book) {
+    test_result_t result = {0};
+    
+    for (int side = 0; side < 2; side++) {
+        int is_bid = side == 0;
+        direct_price_level_t* slots = is_bid ? book->bid_slots : book->ask_slots;
+        window_overflow_t* ov = is_bid ? &book->bid_overflow : &book->ask_overflow;
+        int* levels = is_bid ? &result.bid_levels : &result.ask_levels;
+        uint64_t* quantity = is_bid ? &result.total_bid_quantity : &result.total_ask_quantity;
+        uint64_t* checksum = is_bid ? &result.bid_price_checksum : &result.ask_price_checksum;
+        
+        for (uint64_t price = book->low; price < book->low + WINDOW_TICKS; price++) {
+            direct_price_level_t* level = &slots[price & WINDOW_MASK];
+            if (level->total_quantity > 0) {
+                (*levels)++;
+                *quantity += level->total_quantity;
+                *checksum += price;
+            }
+        }
+        for (int i = 0; i < ov->count; i++) {
+            (*levels)++;
+            *quantity += ov->levels[i].level.total_quantity;
+            *checksum += ov->levels[i].price;
+        }
+    }
+    
+    result.best_bid_price = window_best(book, 1);
+    result.best_ask_price = window_best(book, 0);
+    return result;
+}
+
+// Extract results from skip list book (level 0 is the full sorted list)
+test_result_t extract_skip_book_results(skip_book_t* book) {
+    test_result_t result = {0};
+    
+    for (skip_node_t* node = book->bids.header->forward[0]; node; node = node->forward[0]) {
+        if (result.bid_levels == 0) {
+            result.best_bid_price = node->price;
+        }
+        result.bid_levels++;
+        result.total_bid_quantity += node->total_quantity;
+        result.bid_price_checksum += node->price;
+    }
+    
+    for (skip_node_t* node = book->asks.header->forward[0]; node; node = node->forward[0]) {
+        if (result.ask_levels == 0) {
+            result.best_ask_price = node->price;
+        }
+        result.ask_levels++;
+        result.total_ask_quantity += node->total_quantity;
+        result.ask_price_checksum += node->price;
+    }
+    
+    return result;
+}
+
+// Extract results from lock-free book (quiescent: no thread is using it)
+test_result_t extract_lockfree_book_results(lockfree_book_t* book) {
+    test_result_t result = {0};
+    
+    for (int side = 0; side < 2; side++) {
+        int is_bid = side == 0;
+        int* levels = is_bid ? &result.bid_levels : &result.ask_levels;
+        uint64_t* best = is_bid ? &result.best_bid_price : &result.best_ask_price;
+        uint64_t* quantity = is_bid ? &result.total_bid_quantity : &result.total_ask_quantity;
+        uint64_t* checksum = is_bid ? &result.bid_price_checksum : &result.ask_price_checksum;
+        
+        uintptr_t link = atomic_load(is_bid ? &book->bids : &book->asks);
+        for (lockfree_level_t* level = lockfree_ptr(link); level; level = lockfree_ptr(link)) {
+            link = atomic_load(&level->next);
+            if (link & LOCKFREE_MARK) continue;
+            
+            if (*levels == 0) *best = level->price;
+            (*levels)++;
+            *quantity += atomic_load(&level->total_quantity);
+            *checksum += level->price;
+        }
+    }
+    
+    return result;
+}
+
+static size_t lockfree_chain_length(lockfree_order_t* order) {
+    size_t length = 0;
+    for (; order; order = atomic_load(&order->next)) length++;
+    return length;
+}
+
+// Orders still queued on a live level or waiting in the thread's limbo bags
+// (quiescent, single thread)
+size_t lockfree_held_orders(lockfree_book_t* book, lockfree_thread_t* t) {
+    size_t held = 0;
+    for (int side = 0; side < 2; side++) {
+        uintptr_t link = atomic_load(side ? &book->bids : &book->asks);
+        for (lockfree_level_t* level = lockfree_ptr(link); level; level = lockfree_ptr(link)) {
+            link = atomic_load(&level->next);
+            held += lockfree_chain_length(atomic_load(&level->orders));
+        }
+    }
+    for (int bag = 0; bag < 3; bag++) {
+        for (lockfree_level_t* level = t->limbo[bag]; level; level = level->reclaim_next) {
+            held += lockfree_chain_length(atomic_load(&level->orders));
+        }
+        held += lockfree_chain_length(t->order_limbo[bag]);
+    }
+    return held;
+}
+
+// Extract results from B+tree book: bids walk the leaf chain from the best
+// (highest) price down, asks from the best (lowest) price up
+test_result_t extract_btree_book_results(btree_book_t* book) {
+    test_result_t result = {0};
+    
+    for (btree_leaf_t* leaf = book->bids.last; leaf; leaf = leaf->prev) {
+        for (int i = leaf->count - 1; i >= 0; i--) {
+            if (result.bid_levels == 0) {
+                result.best_bid_price = leaf->keys[i];
+            }
+            result.bid_levels++;
+            result.total_bid_quantity += leaf->quantities[i];
+            result.bid_price_checksum += leaf->keys[i];
+        }
+    }
+    
+    for (btree_leaf_t* leaf = book->asks.first; leaf; leaf = leaf->next) {
+        for (int i = 0; i < (int)leaf->count; i++) {
+            if (result.ask_levels == 0) {
+                result.best_ask_price = leaf->keys[i];
+            }
+            result.ask_levels++;
+            result.total_ask_quantity += leaf->quantities[i];
+            result.ask_price_checksum += leaf->keys[i];
+        }
+    }
+    
+    return result;
+}
+
+// Extract results from the L3 book: bitmap walk from the best price of
+// each side outwards
+test_result_t extract_l3_book_results(l3_book_t* book) {
+    test_result_t result = {0};
+    
+    for (int64_t tick = price_bitmap_prev(&book->bid_bitmap, L3_PRICE_RANGE - 1); tick >= 0;
+         tick = tick ? price_bitmap_prev(&book->bid_bitmap, tick - 1) : -1) {
+        uint64_t price = book->base_price + tick;
+        if (result.bid_levels++ == 0) result.best_bid_price = price;
+        result.total_bid_quantity += book->bid_levels[tick].total_quantity;
+        result.bid_price_checksum += price;
+    }
+    
+    for (int64_t tick = price_bitmap_next(&book->ask_bitmap, 0); tick >= 0;
+         tick = tick + 1 < L3_PRICE_RANGE ? price_bitmap_next(&book->ask_bitmap, tick + 1) : -1) {
+        uint64_t price = book->base_price + tick;
+        if (result.ask_levels++ == 0) result.best_ask_price = price;
+        result.total_ask_quantity += book->ask_levels[tick].total_quantity;
+        result.ask_price_checksum += price;
+    }
+    
+    return result;
+}
+
+// The level totals must match the sum of their queues, in FIFO order both ways
+static int l3_check_queues(const l3_book_t* book) {
+    for (int side = 0; side < 2; side++) {
+        const l3_level_t* levels = side ? book->ask_levels : book->bid_levels;
+        for (int tick = 0; tick < L3_PRICE_RANGE; tick++) {
+            uint64_t total = 0;
+            uint32_t count = 0;
+            const l3_order_t* prev = NULL;
+            for (const l3_order_t* o = levels[tick].head; o; prev = o, o = o->next) {
+                if (o->prev != prev || o->level != &levels[tick] ||
+                    l3_index_find(&book->index, o->id) < 0) {
+                    return 0;
+                }
+                total += o->quantity;
+                count++;
+            }
+            if (prev != levels[tick].tail || total != levels[tick].total_quantity ||
+                count != levels[tick].order_count) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Compare two test results
+int compare_results(test_result_t* a, test_result_t* b, const char* name_a, const char* name_b) {
+    int passed = 1;
+    
+    if (a->bid_levels != b->bid_levels) {
+        printf("❌ FAIL: %s vs %s - Bid levels: %d vs %d\n", 
+               name_a, name_b, a->bid_levels, b->bid_levels);
+        passed = 0;
+    }
+    
+    if (a->ask_levels != b->ask_levels) {
+        printf("❌ FAIL: %s vs %s - Ask levels: %d vs %d\n", 
+               name_a, name_b, a->ask_levels, b->ask_levels);
+        passed = 0;
+    }
+    
+    if (a->best_bid_price != b->best_bid_price) {
+        printf("❌ FAIL: %s vs %s - Best bid: %lu vs %lu\n", 
+               name_a, name_b, a->best_bid_price, b->best_bid_price);
+        passed = 0;
+    }
+    
+    if (a->best_ask_price != b->best_ask_price) {
+        printf("❌ FAIL: %s vs %s - Best ask: %lu vs %lu\n", 
+               name_a, name_b, a->best_ask_price, b->best_ask_price);
+        passed = 0;
+    }
+    
+    if (a->total_bid_quantity != b->total_bid_quantity) {
+        printf("❌ FAIL: %s vs %s - Total bid qty: %lu vs %lu\n", 
+               name_a, name_b, a->total_bid_quantity, b->total_bid_quantity);
+        passed = 0;
+    }
+    
+    if (a->total_ask_quantity != b->total_ask_quantity) {
+        printf("❌ FAIL: %s vs %s - Total ask qty: %lu vs %lu\n", 
+               name_a, name_b, a->total_ask_quantity, b->total_ask_quantity);
+        passed = 0;
+    }
+    
+    if (a->bid_price_checksum != b->bid_price_checksum) {
+        printf("❌ FAIL: %s vs %s - Bid price checksum: %lu vs %lu\n", 
+               name_a, name_b, a->bid_price_checksum, b->bid_price_checksum);
+        passed = 0;
+    }
+    
+    if (a->ask_price_checksum != b->ask_price_checksum) {
+        printf("❌ FAIL: %s vs %s - Ask price checksum: %lu vs %lu\n", 
+               name_a, name_b, a->ask_price_checksum, b->ask_price_checksum);
+        passed = 0;
+    }
+    
+    return passed;
+}
+
+// Test SIMD correctness
+int test_simd_correctness() {
+    printf("\n=== SIMD CORRECTNESS TEST ===\n");
     
-    uint64_t start = get_time_ns();
+    const int TEST_SIZES[] = {1, 4, 7, 16, 100, 1000, 10007}; // Various sizes including edge cases
+    const int NUM_SIZES = sizeof(TEST_SIZES) / sizeof(TEST_SIZES[0]);
+    int all_passed = 1;
     
-    volatile uint64_t sum = 0;
-    for (int i = 0; i < 1000; i++) { // Repeat for measurable time
-        sum += simd_sum_quantities(quantities, count);
+    for (int t = 0; t < NUM_SIZES; t++) {
+        int size = TEST_SIZES[t];
+        uint32_t* data = aligned_alloc(16, size * sizeof(uint32_t));
+        
+        // Fill with test pattern
+        for (int i = 0; i < size; i++) {
+            data[i] = (i * 7 + 13) % 1000; // Deterministic pattern
+        }
+        
+        uint64_t simd_result = simd_sum_quantities(data, size);
+        uint64_t generic_result = simd_sum_quantities_generic(data, size);
+        
+        if (simd_result != generic_result) {
+            printf("❌ SIMD FAIL (size %d): SIMD=%lu, Generic=%lu\n", 
+                   size, simd_result, generic_result);
+            all_passed = 0;
+        } else {
+            printf("✅ SIMD PASS (size %d): Both=%lu\n", size, simd_result);
+        }
+        
+        free(data);
     }
     
-    uint64_t end = get_time_ns();
-    return (end - start) / 1000000.0;
+    return all_passed;
 }
 
-// Generic SIMD benchmark for comparison
-double benchmark_generic_operations(uint32_t* quantities, int count) {
-    // Warm up caches
-    volatile uint64_t warmup = simd_sum_quantities_generic(quantities, count);
-    (void)warmup; // Suppress unused warning
+// Every compiled bound kernel against a forward scalar count, both bounds in
+// both directions, on columns with duplicates and every tail length; then
+// the touch/binary split of find_price_level against plain binary search
+int test_simd_search_correctness() {
+    printf("\n=== SIMD SEARCH CORRECTNESS TEST ===\n");
+    
+    // Every kernel this CPU can run, not just the one dispatched
+    int (*kernels[4])(const uint64_t*, int, uint64_t, int, int);
+    int num_kernels = 0;
+    kernels[num_kernels++] = simd_bound_generic;
+#ifdef SIMD_X86
+    if (cpu_features()->avx2) kernels[num_kernels++] = simd_bound_x86;
+    if (cpu_features()->avx512f) kernels[num_kernels++] = simd_bound_x86_avx512;
+#elif defined(SIMD_ARM)
+    if (cpu_features()->neon) kernels[num_kernels++] = simd_bound_arm;
+#endif
+    uint64_t prices[80];
+    int checks = 0, passed = 1;
+    
+    for (int count = 0; count <= 80 && passed; count++) {
+        for (int ascending = 0; ascending <= 1; ascending++) {
+            // Steps of 0-2 around the sign bit, so equal runs and unsigned order are covered
+            uint64_t price = 0x7FFFFFFFFFFFFFF0ULL;
+            for (int i = 0; i < count; i++) {
+                price += (i * 7) % 3;
+                prices[ascending ? i : count - 1 - i] = price;
+            }
+            
+            for (uint64_t target = 0x7FFFFFFFFFFFFFEEULL; target < price + 3; target++) {
+                for (int upper = 0; upper <= 1; upper++) {
+                    int expected = 0;
+                    while (expected < count && bound_before(prices[expected], target, ascending, upper)) {
+                        expected++;
+                    }
+                    for (int k = 0; k < num_kernels; k++, checks++) {
+                        int got = kernels[k](prices, count, target, ascending, upper);
+                        if (got != expected) {
+                            printf("❌ FAIL: kernel %d, %d prices %s, %s bound of %lu: %d, expected %d\n",
+                                   k, count, ascending ? "ascending" : "descending",
+                                   upper ? "upper" : "lower", target, got, expected);
+                            passed = 0;
+                        }
+                    }
+                }
+            }
+        }
+    }
     
-    uint64_t start = get_time_ns();
+    // Unique prices as in the book, deep enough for the binary search fallback
+    uint64_t* book_prices = malloc(200 * sizeof(uint64_t));
+    for (int is_bid = 0; is_bid <= 1 && passed; is_bid++) {
+        for (int i = 0; i < 200; i++) {
+            book_prices[i] = is_bid ? 1000 + 2 * i : 1400 - 2 * i;
+        }
+        for (int count = 0; count <= 200 && passed; count += 7) {
+            for (uint64_t price = 995; price <= 1405; price++, checks++) {
+                int expected = binary_find_price_level(book_prices, count, price, is_bid);
+                if (find_price_level(book_prices, count, price, is_bid) != expected) {
+                    printf("❌ FAIL: find_price_level(%lu) over %d %s levels\n",
+                           price, count, is_bid ? "bid" : "ask");
+                    passed = 0;
+                }
+            }
+        }
+    }
+    free(book_prices);
     
-    volatile uint64_t sum = 0;
-    for (int i = 0; i < 1000; i++) { // Repeat for measurable time
-        sum += simd_sum_quantities_generic(quantities, count);
+    if (passed) {
+        printf("✅ SIMD SEARCH PASS: %d kernels, %d checks\n", num_kernels, checks);
     }
+    return passed;
+}
+
+// Insert/modify/delete mix applied to every book must give the same result
+// (the direct books only when the prices fit their range, the array book
+// only while it stays under MAX_PRICE_LEVELS)
+int test_ops_correctness(const char* name, void (*generate)(book_op_t*, int, uint64_t),
+                         uint64_t base_price) {
+    const int OP_COUNT = 20000;
     
-    uint64_t end = get_time_ns();
-    return (end - start) / 1000000.0;
+    book_op_t* ops = malloc(OP_COUNT * sizeof(book_op_t));
+    generate(ops, OP_COUNT, base_price);
+    int direct_fits = ops_fit_direct_book(ops, OP_COUNT);
+    
+    // Orders for every book
+    slab_pool_t orders;
+    slab_pool_init(&orders, sizeof(order_t));
+    
+    simple_book_t simple_book;
+    simple_book_init(&simple_book);
+    simple_apply_ops(&simple_book, ops, OP_COUNT, &orders);
+    
+    array_book_t* array_book = malloc(sizeof(array_book_t));
+    array_book_init(array_book);
+    array_apply_ops(array_book, ops, OP_COUNT);
+    
+    window_book_t* window_book = malloc(sizeof(window_book_t));
+    window_book_init(window_book);
+    window_apply_ops(window_book, ops, OP_COUNT, &orders);
+    
+    test_result_t simple_result = extract_simple_book_results(&simple_book);
+    test_result_t array_result = extract_array_book_results(array_book);
+    test_result_t window_result = extract_window_book_results(window_book);
+    
+    btree_book_t btree_book;
+    btree_book_init(&btree_book);
+    btree_apply_ops(&btree_book, ops, OP_COUNT, &orders);
+    test_result_t btree_result = extract_btree_book_results(&btree_book);
+    
+    skip_book_t skip_book;
+    skip_book_init(&skip_book);
+    skip_apply_ops(&skip_book, ops, OP_COUNT, &orders);
+    test_result_t skip_result = extract_skip_book_results(&skip_book);
+    
+    lockfree_book_t* lockfree_book = aligned_alloc(64, (sizeof(lockfree_book_t) + 63) & ~(size_t)63);
+    lockfree_book_init(lockfree_book, OP_COUNT);
+    lockfree_thread_t* lockfree_thread = lockfree_thread_register(lockfree_book);
+    lockfree_apply_ops(lockfree_book, lockfree_thread, ops, OP_COUNT);
+    test_result_t lockfree_result = extract_lockfree_book_results(lockfree_book);
+    size_t lockfree_orders_held = lockfree_held_orders(lockfree_book, lockfree_thread);
+    slab_cache_flush(&lockfree_thread->orders);
+    
+    int passed = compare_results(&simple_result, &window_result, "Simple", "Window") &&
+                 compare_results(&simple_result, &lockfree_result, "Simple", "Lock-free") &&
+                 compare_results(&simple_result, &btree_result, "Simple", "B+tree") &&
+                 compare_results(&simple_result, &skip_result, "Simple", "Skip list");
+    
+    // Orders of deleted levels and of levels an L2 update replaced must come
+    // back, not just the levels
+    if (slab_pool_in_use(&lockfree_book->order_pool) != lockfree_orders_held) {
+        printf("❌ FAIL: Lock-free book leaked %zu orders\n",
+               slab_pool_in_use(&lockfree_book->order_pool) - lockfree_orders_held);
+        passed = 0;
+    }
+    
+    // The O(1) best-price reads must agree with the full walk
+    if (btree_best(&btree_book, 1) != simple_result.best_bid_price ||
+        btree_best(&btree_book, 0) != simple_result.best_ask_price) {
+        printf("❌ FAIL: B+tree best %lu / %lu\n", btree_best(&btree_book, 1), btree_best(&btree_book, 0));
+        passed = 0;
+    }
+    
+    if (simple_result.bid_levels < MAX_PRICE_LEVELS && simple_result.ask_levels < MAX_PRICE_LEVELS) {
+        passed &= compare_results(&simple_result, &array_result, "Simple", "Array");
+    }
+    
+    if (direct_fits) {
+        direct_book_t direct_book, bitmap_book;
+        direct_book_init(&direct_book, 0);
+        direct_book_init(&bitmap_book, 1);
+        direct_apply_ops(&direct_book, ops, OP_COUNT, &orders);
+        direct_apply_ops(&bitmap_book, ops, OP_COUNT, &orders);
+        
+        test_result_t direct_result = extract_direct_book_results(&direct_book);
+        test_result_t bitmap_result = extract_direct_book_results(&bitmap_book);
+        
+        passed &= compare_results(&simple_result, &direct_result, "Simple", "Direct") &&
+                  compare_results(&simple_result, &bitmap_result, "Simple", "Direct+bitmap");
+        
+        // The tracked top must be the real best price, not just a bound
+        if (bitmap_book.bid_top != simple_result.best_bid_price ||
+            bitmap_book.ask_top != simple_result.best_ask_price) {
+            printf("❌ FAIL: Direct+bitmap top %lu / %lu vs best %lu / %lu\n",
+                   bitmap_book.bid_top, bitmap_book.ask_top,
+                   simple_result.best_bid_price, simple_result.best_ask_price);
+            passed = 0;
+        }
+        
+        direct_book_free(&direct_book);
+        direct_book_free(&bitmap_book);
+    }
+    
+    if (passed) {
+        printf("✅ %s PASS (%d ops): %d bid / %d ask levels, best %lu / %lu, %lu re-centers\n",
+               name, OP_COUNT, simple_result.bid_levels, simple_result.ask_levels,
+               simple_result.best_bid_price, simple_result.best_ask_price, window_book->recenters);
+    }
+    
+    simple_book_free(&simple_book);
+    array_book_free(array_book);
+    free(array_book);
+    window_book_free(window_book);
+    free(window_book);
+    btree_book_free(&btree_book);
+    skip_book_free(&skip_book);
+    lockfree_book_free(lockfree_book);
+    free(lockfree_book);
+    slab_pool_destroy(&orders);
+    free(ops);
+    
+    return passed;
 }
 
-// Read performance benchmark (market data queries)
-void benchmark_read_performance() {
-    printf("=== READ PERFORMANCE BENCHMARK ===\n");
+int test_mixed_ops_correctness() {
+    printf("\n=== MIXED INSERT/MODIFY/DELETE CORRECTNESS TEST ===\n");
+    
+    int mixed = test_ops_correctness("MIXED OPS", generate_book_ops, 50000);
+    int delete_heavy = test_ops_correctness("DELETE-HEAVY OPS", generate_delete_heavy_ops, 50000);
+    int deep = test_ops_correctness("DEEP BOOK OPS", generate_deep_ops, 50000);
+    int drifting = test_ops_correctness("DRIFTING BTC OPS", generate_drifting_ops, BTC_TICK_PRICE);
+    return mixed && delete_heavy && deep && drifting;
+}
+
+int test_l3_correctness() {
+    printf("\n=== L3 MARKET-BY-ORDER CORRECTNESS TEST ===\n");
     
-    const int LEVELS = 100;
+    const int EVENT_COUNT = 20000;
+    const uint64_t BASE_PRICE = 50000;
     
-    // Create array-based book for testing
-    array_book_t book = {0};
+    l3_event_t* events = malloc(EVENT_COUNT * sizeof(l3_event_t));
+    generate_l3_events(events, EVENT_COUNT, BASE_PRICE);
     
-    // Populate with sample data
-    for (int i = 0; i < LEVELS; i++) {
-        book.bids[i].price = 50000 - i; // Descending prices
-        book.bids[i].total_quantity = 1000 + i * 100;
-        book.asks[i].price = 50001 + i; // Ascending prices  
-        book.asks[i].total_quantity = 1000 + i * 100;
+    simple_book_t simple_book;
+    simple_book_init(&simple_book);
+    slab_pool_t simple_orders;
+    slab_pool_init(&simple_orders, sizeof(order_t));
+    uint64_t simple_executed = simple_apply_l3_events(&simple_book, events, EVENT_COUNT, &simple_orders);
+    
+    // Start from a one-group index, so the test also covers rehashing
+    l3_book_t* book = malloc(sizeof(l3_book_t));
+    l3_book_init(book, BASE_PRICE - L3_PRICE_RANGE / 2, EVENT_COUNT);
+    l3_index_free(&book->index);
+    l3_index_init(&book->index, L3_GROUP);
+    l3_apply_events(book, events, EVENT_COUNT);
+    
+    test_result_t simple_result = extract_simple_book_results(&simple_book);
+    test_result_t l3_result = extract_l3_book_results(book);
+    
+    int passed = compare_results(&simple_result, &l3_result, "Simple", "L3");
+    if (book->executed_quantity != simple_executed) {
+        printf("❌ FAIL: L3 executed %lu vs %lu\n", book->executed_quantity, simple_executed);
+        passed = 0;
+    }
+    if (!l3_check_queues(book)) {
+        printf("❌ FAIL: L3 level queues inconsistent\n");
+        passed = 0;
     }
-    book.bid_count = LEVELS;
-    book.ask_count = LEVELS;
     
-    // Benchmark top-of-book access (most common operation)
-    uint64_t start = get_time_ns();
-    volatile uint64_t best_bid_price = 0, best_ask_price = 0;
-    for (int i = 0; i < 1000000; i++) {
-        best_bid_price = book.bids[0].price;
-        best_ask_price = book.asks[0].price;
+    if (passed) {
+        printf("✅ L3 EVENTS PASS (%d events): %zu resting orders, %d bid / %d ask levels, %lu executed\n",
+               EVENT_COUNT, book->index.live, l3_result.bid_levels, l3_result.ask_levels,
+               book->executed_quantity);
+    }
+    
+    simple_book_free(&simple_book);
+    slab_pool_destroy(&simple_orders);
+    l3_book_free(book);
+    free(book);
+    free(events);
+    return passed;
+}
+
+static uint64_t array_side_quantity(const array_book_t* book) {
+    uint64_t total = 0;
+    for (int i = 0; i < book->bid_count; i++) total += book->bids[i].total_quantity;
+    for (int i = 0; i < book->ask_count; i++) total += book->asks[i].total_quantity;
+    return total;
+}
+
+// Checks every order against the book before and after matching: fills
+// respect the limit and never improve as the sweep goes deeper, the book
+// stays uncrossed, resting quantity is conserved, and a rested remainder
+// sits at the back of its level's queue. Runs once with a roomy fill buffer
+// and once with a single-fill one, where every order is resubmitted after
+// each fill and the book must stay uncrossed in between. The book starts
+// with L2 levels (array_update_level, no orders behind them) around the mid.
+int test_matching_correctness() {
+    printf("\n=== MATCHING ENGINE CORRECTNESS TEST ===\n");
+    
+    const int ORDER_COUNT = 20000;
+    const uint64_t MID = 50000;
+    const int FILL_CAPACITIES[] = {4096, 1};
+    
+    match_order_t* orders = malloc(ORDER_COUNT * sizeof(match_order_t));
+    generate_match_orders(orders, ORDER_COUNT, MID);
+    int passed = 1;
+    
+    for (int c = 0; c < 2 && passed; c++) {
+        array_book_t* book = malloc(sizeof(array_book_t));
+        array_book_init(book);
+        for (int k = 0; k < 5; k++) {
+            array_update_level(book, MID - 1 - k, 5000, 1);
+            array_update_level(book, MID + k, 5000, 0);
+        }
+        fill_buffer_t out = { malloc(FILL_CAPACITIES[c] * sizeof(fill_t)), FILL_CAPACITIES[c], 0 };
+        uint64_t fill_count = 0, filled_quantity = 0, resubmits = 0;
+        
+        for (int i = 0; i < ORDER_COUNT && passed; i++) {
+            const match_order_t* o = &orders[i];
+            match_order_t rest = *o;
+            uint64_t before = array_side_quantity(book);
+            uint64_t fill_sum = 0, last_price = 0;
+            uint32_t filled = 0;
+            match_status_t status;
+            
+            do {
+                uint32_t part;
+                out.count = 0;
+                status = match_order(book, &rest, &out, &part);
+                
+                for (int f = 0; f < out.count; f++) {
+                    const fill_t* fill = &out.fills[f];
+                    int beyond_limit = o->type != MATCH_MARKET &&
+                                       (o->is_buy ? fill->price > o->price : fill->price < o->price);
+                    int improved = last_price && (o->is_buy ? fill->price < last_price
+                                                            : fill->price > last_price);
+                    if (fill->taker_id != o->id || beyond_limit || improved) {
+                        printf("❌ FAIL: order %lu fill at %lu\n", o->id, fill->price);
+                        passed = 0;
+                    }
+                    fill_sum += fill->quantity;
+                    last_price = fill->price;
+                }
+                if (book->bid_count && book->ask_count &&
+                    ARRAY_BEST_BID_PRICE(book) >= ARRAY_BEST_ASK_PRICE(book)) {
+                    printf("❌ FAIL: book crossed after order %lu (fill capacity %d)\n",
+                           o->id, out.capacity);
+                    passed = 0;
+                }
+                
+                fill_count += out.count;
+                filled += part;
+                rest.quantity -= part;
+                resubmits += status == MATCH_FILLS_FULL;
+            } while (status == MATCH_FILLS_FULL && passed);
+            
+            uint32_t remaining = o->quantity - filled;
+            uint64_t rested = 0;
+            if (remaining && o->type == MATCH_LIMIT) {
+                array_price_level_t* levels = o->is_buy ? book->bids : book->asks;
+                int count = o->is_buy ? book->bid_count : book->ask_count;
+                int pos = find_price_level(o->is_buy ? book->bid_prices : book->ask_prices,
+                                           count, o->price, o->is_buy);
+                if (pos >= 0 && levels[pos].last->orders[levels[pos].last->tail - 1].id == o->id) {
+                    rested = remaining;
+                } else if (pos >= 0 || count < MAX_PRICE_LEVELS) {
+                    printf("❌ FAIL: order %lu remainder did not rest\n", o->id);
+                    passed = 0;
+                }
+            }
+            
+            if (fill_sum != filled || array_side_quantity(book) != before - filled + rested) {
+                printf("❌ FAIL: order %lu quantity not conserved\n", o->id);
+                passed = 0;
+            }
+            filled_quantity += filled;
+        }
+        
+        if (passed) {
+            printf("✅ MATCHING PASS (%d orders, fill capacity %d): %lu fills, %lu filled, "
+                   "%lu resubmits, %d bid / %d ask levels resting\n",
+                   ORDER_COUNT, out.capacity, fill_count, filled_quantity, resubmits,
+                   book->bid_count, book->ask_count);
+        }
+        
+        free(out.fills);
+        array_book_free(book);
+        free(book);
+    }
+    
+    if (passed) {
+        // A limit buy through an L2 level with an order queued in front of
+        // it and one without: both fill, and the remainder rests at the limit
+        // instead of leaving the book crossed
+        array_book_t* book = malloc(sizeof(array_book_t));
+        array_book_init(book);
+        fill_t fills[4];
+        fill_buffer_t out = { fills, 4, 0 };
+        order_t maker = { .id = 7, .price = MID, .quantity = 100 };
+        array_insert_order(book, &maker, 0);
+        array_update_level(book, MID, 300, 0);
+        array_update_level(book, MID + 1, 400, 0);
+        array_update_level(book, MID + 3, 500, 0);
+        
+        match_order_t taker = { MATCH_LIMIT, 99, MID + 2, 1000, 1 };
+        uint32_t filled;
+        int ok = match_order(book, &taker, &out, &filled) == MATCH_COMPLETE &&
+                 filled == 700 && out.count == 3 &&
+                 fills[0].maker_id == 7 && fills[0].quantity == 100 &&
+                 fills[1].maker_id == 0 && fills[1].price == MID && fills[1].quantity == 200 &&
+                 fills[2].maker_id == 0 && fills[2].price == MID + 1 && fills[2].quantity == 400 &&
+                 book->ask_count == 1 && ARRAY_BEST_ASK_PRICE(book) == MID + 3 &&
+                 book->bid_count == 1 && ARRAY_BEST_BID_PRICE(book) == MID + 2 &&
+                 book->bids[0].total_quantity == 300;
+        if (ok) {
+            printf("✅ MATCHING PASS: L2 levels without orders fill with maker_id 0\n");
+        } else {
+            printf("❌ FAIL: L2 levels without orders (filled %u in %d fills)\n", filled, out.count);
+            passed = 0;
+        }
+        array_book_free(book);
+        free(book);
+    }
+    
+    free(orders);
+    return passed;
+}
+
+// Comprehensive correctness test
+int run_correctness_tests() {
+    printf("\n=== COMPREHENSIVE CORRECTNESS TESTS ===\n");
+    
+    const int TEST_ORDER_COUNT = 5000;
+    const uint64_t BASE_PRICE = 50000;
+    
+    // Generate deterministic test data
+    benchmark_order_t* orders = malloc(TEST_ORDER_COUNT * sizeof(benchmark_order_t));
+    generate_orders(orders, TEST_ORDER_COUNT, BASE_PRICE);
+    
+    // Build simple book
+    printf("Building simple linked list book...\n");
+    simple_book_t simple_book;
+    simple_book_init(&simple_book);
+    order_t* simple_orders = malloc(TEST_ORDER_COUNT * sizeof(order_t));
+    
+    for (int i = 0; i < TEST_ORDER_COUNT; i++) {
+        simple_orders[i].id = orders[i].id;
+        simple_orders[i].price = orders[i].price;
+        simple_orders[i].quantity = orders[i].quantity;
+        simple_orders[i].next = NULL;
+        simple_insert_order(&simple_book, &simple_orders[i], orders[i].is_bid);
+    }
+    
+    // Build array book
+    printf("Building array-based book...\n");
+    array_book_t array_book;
+    array_book_init(&array_book);
+    for (int i = 0; i < TEST_ORDER_COUNT; i++) {
+        order_t order = {
+            .id = orders[i].id,
+            .price = orders[i].price,
+            .quantity = orders[i].quantity
+        };
+        array_insert_order(&array_book, &order, orders[i].is_bid);
+    }
+    
+    // Build direct book
+    printf("Building direct mapping book...\n");
+    direct_book_t direct_book = {0};
+    direct_book.bid_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
+    direct_book.ask_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
+    order_t* direct_orders = malloc(TEST_ORDER_COUNT * sizeof(order_t));
+    
+    int valid_orders = 0;
+    for (int i = 0; i < TEST_ORDER_COUNT; i++) {
+        direct_orders[i].id = orders[i].id;
+        direct_orders[i].price = orders[i].price;
+        direct_orders[i].quantity = orders[i].quantity;
+        
+        // Only add orders within valid price range
+        if ((orders[i].is_bid && orders[i].price < PRICE_OFFSET) ||
+            (!orders[i].is_bid && orders[i].price < PRICE_RANGE)) {
+            direct_insert_order(&direct_book, &direct_orders[i], orders[i].is_bid);
+            valid_orders++;
+        }
+    }
+    
+    printf("Added %d valid orders to direct book\n", valid_orders);
+    
+    // Extract results
+    test_result_t simple_result = extract_simple_book_results(&simple_book);
+    test_result_t array_result = extract_array_book_results(&array_book);
+    test_result_t direct_result = extract_direct_book_results(&direct_book);
+    
+    // Print summary
+    printf("\nRESULT SUMMARY:\n");
+    printf("%-15s %-10s %-10s %-12s %-12s %-15s %-15s\n", 
+           "Implementation", "BidLvls", "AskLvls", "BestBid", "BestAsk", "TotalBidQty", "TotalAskQty");
+    printf("%-15s %-10d %-10d %-12lu %-12lu %-15lu %-15lu\n", 
+           "Simple", simple_result.bid_levels, simple_result.ask_levels,
+           simple_result.best_bid_price, simple_result.best_ask_price,
+           simple_result.total_bid_quantity, simple_result.total_ask_quantity);
+    printf("%-15s %-10d %-10d %-12lu %-12lu %-15lu %-15lu\n", 
+           "Array", array_result.bid_levels, array_result.ask_levels,
+           array_result.best_bid_price, array_result.best_ask_price,
+           array_result.total_bid_quantity, array_result.total_ask_quantity);
+    printf("%-15s %-10d %-10d %-12lu %-12lu %-15lu %-15lu\n", 
+           "Direct", direct_result.bid_levels, direct_result.ask_levels,
+           direct_result.best_bid_price, direct_result.best_ask_price,
+           direct_result.total_bid_quantity, direct_result.total_ask_quantity);
+    
+    // Compare results
+    printf("\nCORRECTNESS COMPARISON:\n");
+    int test1 = compare_results(&simple_result, &array_result, "Simple", "Array");
+    int test2 = compare_results(&simple_result, &direct_result, "Simple", "Direct");
+    int test3 = test_simd_correctness();
+    int test4 = test_mixed_ops_correctness();
+    int test5 = test_l3_correctness();
+    int test6 = test_matching_correctness();
+    int test7 = test_simd_search_correctness();
+    
+    int all_passed = test1 && test2 && test3 && test4 && test5 && test6 && test7;
+    
+    if (all_passed) {
+        printf("\n🎉 ALL CORRECTNESS TESTS PASSED! 🎉\n");
+        printf("All implementations produce identical results.\n");
+    } else {
+        printf("\n💥 CORRECTNESS TESTS FAILED! 💥\n");
+        printf("Some implementations have bugs - performance results may be invalid.\n");
     }
-    uint64_t end = get_time_ns();
     
-    // Use the variables to prevent optimization
-    if (best_bid_price == 0 || best_ask_price == 0) {
-        printf("Warning: benchmark may have been optimized away\n");
-    }
+    // Cleanup
+    simple_book_free(&simple_book);
     
-    printf("Top-of-book access: %.2f ns per operation\n", 
-           (end - start) / 1000000.0);
+    free(orders);
+    free(simple_orders);
+    free(direct_book.bid_levels);
+    free(direct_book.ask_levels);
+    free(direct_orders);
+    array_book_free(&array_book);
     
-    // Benchmark market depth aggregation (sum top N levels)
-    const int DEPTH = 10;
-    start = get_time_ns();
-    volatile uint64_t total_bid_qty = 0, total_ask_qty = 0;
+    return all_passed;
+}
+// Insert/modify/delete throughput of every book on one workload
+void run_ops_benchmark(const char* workload, void (*generate)(book_op_t*, int, uint64_t),
+                       uint64_t base_price) {
+    const int ORDER_COUNTS[] = {1000, 5000, 10000, 25000};
+    const int NUM_TESTS = sizeof(ORDER_COUNTS) / sizeof(ORDER_COUNTS[0]);
     
-    for (int i = 0; i < 100000; i++) {
-        uint64_t bid_sum = 0, ask_sum = 0;
-        for (int j = 0; j < DEPTH && j < book.bid_count; j++) {
-            bid_sum += book.bids[j].total_quantity;
-            ask_sum += book.asks[j].total_quantity;
-        }
-        total_bid_qty = bid_sum;
-        total_ask_qty = ask_sum;
-    }
-    end = get_time_ns();
+    printf("Workload: %s\n\n", workload);
+    printf("%-15s", "Ops");
+    printf("%-15s", "Simple(ms)");
+    printf("%-15s", "Array(ms)");
+    printf("%-15s", "Skip(ms)");
+    printf("%-15s", "Direct(ms)");
+    printf("%-15s", "Direct+bm(ms)");
+    printf("%-15s", "Window(ms)");
+    printf("%-15s", "B+tree(ms)");
+    printf("%-15s", "Speedup");
+    printf("\n");
+    printf("============================================================================================================================\n");
     
-    // Use the variables to prevent optimization
-    if (total_bid_qty == 0 || total_ask_qty == 0) {
-        printf("Warning: depth benchmark may have been optimized away\n");
+    for (int t = 0; t < NUM_TESTS; t++) {
+        int count = ORDER_COUNTS[t];
+        book_op_t* ops = malloc(count * sizeof(book_op_t));
+        generate(ops, count, base_price);
+        
+        // Run benchmarks (the direct book can't hold real prices)
+        int direct_fits = ops_fit_direct_book(ops, count);
+        double simple_time = benchmark_simple_book(ops, count);
+        double array_time = benchmark_array_book(ops, count);
+        double skip_time = benchmark_skip_book(ops, count);
+        double direct_time = direct_fits ? benchmark_direct_book(ops, count, 0) : -1;
+        double bitmap_time = direct_fits ? benchmark_direct_book(ops, count, 1) : -1;
+        double window_time = benchmark_window_book(ops, count);
+        double btree_time = benchmark_btree_book(ops, count);
+        
+        // Against the fastest direct-mapped book that can run the workload
+        double fastest = direct_fits && bitmap_time < window_time ? bitmap_time : window_time;
+        double speedup = simple_time / fastest;
+        
+        printf("%-15d", count);
+        printf("%-15.2f", simple_time);
+        printf("%-15.2f", array_time);
+        printf("%-15.2f", skip_time);
+        if (direct_fits) {
+            printf("%-15.2f", direct_time);
+            printf("%-15.2f", bitmap_time);
+        } else {
+            printf("%-15s%-15s", "n/a", "n/a");
+        }
+        printf("%-15.2f", window_time);
+        printf("%-15.2f", btree_time);
+        printf("%-15.1fx", speedup);
+        printf("\n");
+        
+        free(ops);
     }
-    
-    printf("Market depth (top-%d): %.2f ns per operation\n", 
-           DEPTH, (end - start) / 100000.0);
+    printf("\n");
 }
 
-// Memory usage analysis
-void analyze_memory_usage() {
-    printf("\n=== MEMORY USAGE ANALYSIS ===\n");
+void run_l3_benchmark() {
+    const int EVENT_COUNTS[] = {10000, 50000, 200000};
+    const int NUM_TESTS = sizeof(EVENT_COUNTS) / sizeof(EVENT_COUNTS[0]);
+    const uint64_t BASE_PRICE = 50000;
     
-    const int ORDERS = 10000;
-    const int LEVELS = 500;
+    printf("=== L3 MARKET-BY-ORDER BENCHMARK ===\n");
+    printf("Workload: adds keep ~%d orders resting, other events 55%% cancel / 20%% reduce / 25%% execute by id\n\n",
+           L3_LIVE_TARGET);
+    printf("%-15s%-15s%-15s%-15s%-15s%-15s\n",
+           "Events", "Simple(ms)", "L3(ms)", "L3(ns/event)", "Index load", "Speedup");
+    printf("==========================================================================================\n");
     
-    printf("For %d orders across ~%d price levels:\n\n", ORDERS, LEVELS);
+    for (int t = 0; t < NUM_TESTS; t++) {
+        int count = EVENT_COUNTS[t];
+        l3_event_t* events = malloc(count * sizeof(l3_event_t));
+        generate_l3_events(events, count, BASE_PRICE);
+        
+        // The id-scanning baseline is quadratic: skip it on the long run
+        double simple_time = -1;
+        if (count <= 50000) {
+            simple_book_t simple_book;
+            simple_book_init(&simple_book);
+            slab_pool_reserve(&simple_book.levels, count);
+            slab_pool_t simple_orders;
+            slab_pool_init(&simple_orders, sizeof(order_t));
+            slab_pool_reserve(&simple_orders, count);
+            uint64_t start = get_time_ns();
+            simple_apply_l3_events(&simple_book, events, count, &simple_orders);
+            simple_time = (get_time_ns() - start) / 1000000.0;
+            simple_book_free(&simple_book);
+            slab_pool_destroy(&simple_orders);
+        }
+        
+        l3_book_t* book = malloc(sizeof(l3_book_t));
+        l3_book_init(book, BASE_PRICE - L3_PRICE_RANGE / 2, 2 * L3_LIVE_TARGET);
+        uint64_t start = get_time_ns();
+        l3_apply_events(book, events, count);
+        uint64_t elapsed = get_time_ns() - start;
+        double l3_time = elapsed / 1000000.0;
+        
+        printf("%-15d", count);
+        if (simple_time >= 0) printf("%-15.2f", simple_time); else printf("%-15s", "n/a");
+        printf("%-15.2f%-15.1f", l3_time, (double)elapsed / count);
+        printf("%-15.2f", (double)book->index.used / book->index.capacity);
+        if (simple_time >= 0) printf("%-15.1fx", simple_time / l3_time); else printf("%-15s", "n/a");
+        printf("\n");
+        
+        l3_book_free(book);
+        free(book);
+        free(events);
+    }
+    printf("\n");
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Throughput over the whole stream, then a second pass timing each order on
+// its own (the latencies include one clock_gettime, ~20 ns)
+void run_matching_benchmark() {
+    const int ORDER_COUNTS[] = {100000, 1000000};
+    const int NUM_TESTS = sizeof(ORDER_COUNTS) / sizeof(ORDER_COUNTS[0]);
+    const uint64_t MID = 50000;
+    const int FILL_CAPACITY = 4096;
     
-    size_t simple_memory = LEVELS * sizeof(price_level_t) + ORDERS * sizeof(order_t);
-    printf("Simple Linked List: %zu KB\n", simple_memory / 1024);
+    printf("=== MATCHING ENGINE BENCHMARK (ARRAY BOOK) ===\n");
+    printf("Order flow: 70%% limit / 15%% IOC / 15%% market around a fixed mid\n\n");
+    printf("%-12s%-12s%-14s%-14s%-10s%-10s%-10s%-10s%-10s\n",
+           "Orders", "Time(ms)", "Orders/s", "Fills/s", "p50(ns)", "p90(ns)", "p99(ns)",
+           "p99.9(ns)", "max(ns)");
+    printf("==================================================================================================\n");
     
-    size_t array_memory = sizeof(array_book_t);
-    printf("Array-based: %zu KB (fixed)\n", array_memory / 1024);
+    fill_buffer_t out = { malloc(FILL_CAPACITY * sizeof(fill_t)), FILL_CAPACITY, 0 };
     
-    size_t direct_memory = 2 * PRICE_RANGE * sizeof(direct_price_level_t) + 
-                          ORDERS * sizeof(order_t);
-    printf("Direct Mapping: %zu MB (huge!)\n", direct_memory / (1024 * 1024));
+    for (int t = 0; t < NUM_TESTS; t++) {
+        int count = ORDER_COUNTS[t];
+        match_order_t* orders = malloc(count * sizeof(match_order_t));
+        uint32_t* latencies = malloc(count * sizeof(uint32_t));
+        generate_match_orders(orders, count, MID);
+        
+        // Resting orders keep piling up at the deeper levels
+        array_book_t* book = malloc(sizeof(array_book_t));
+        array_book_init(book);
+        slab_pool_reserve(&book->chunks, count / ARRAY_CHUNK_ORDERS);
+        uint64_t fills = 0;
+        uint64_t start = get_time_ns();
+        for (int i = 0; i < count; i++) {
+            fills += match_order_drained(book, &orders[i], &out);
+        }
+        uint64_t elapsed = get_time_ns() - start;
+        
+        array_book_free(book);
+        array_book_init(book);
+        slab_pool_reserve(&book->chunks, count / ARRAY_CHUNK_ORDERS);
+        for (int i = 0; i < count; i++) {
+            uint64_t order_start = get_time_ns();
+            match_order_drained(book, &orders[i], &out);
+            latencies[i] = (uint32_t)(get_time_ns() - order_start);
+        }
+        qsort(latencies, count, sizeof(uint32_t), compare_u32);
+        
+        printf("%-12d%-12.2f%-14.0f%-14.0f%-10u%-10u%-10u%-10u%-10u\n",
+               count, elapsed / 1000000.0, count * 1e9 / elapsed, fills * 1e9 / elapsed,
+               latencies[count / 2], latencies[(int)(count * 0.9)], latencies[(int)(count * 0.99)],
+               latencies[(int)(count * 0.999)], latencies[count - 1]);
+        
+        array_book_free(book);
+        free(book);
+        free(latencies);
+        free(orders);
+    }
+    printf("\n");
     
-    size_t skip_memory = LEVELS * sizeof(skip_node_t) + ORDERS * sizeof(order_t);
-    printf("Skip List: %zu KB (estimated)\n", skip_memory / 1024);
+    free(out.fills);
 }
 
 // =============================================================================
-// CORRECTNESS TESTING AND VALIDATION
+// PRICE SEARCH BENCHMARK (level records vs dense index vs Eytzinger)
 // =============================================================================
 
-typedef struct test_result {
-    int bid_levels;
-    int ask_levels;
-    uint64_t best_bid_price;
-    uint64_t best_ask_price;
-    uint64_t total_bid_quantity;
-    uint64_t total_ask_quantity;
-    uint64_t bid_price_checksum;  // Sum of all bid prices
-    uint64_t ask_price_checksum;  // Sum of all ask prices
-} test_result_t;
+#define SEARCH_LOOKUPS 1000000
+#define SEARCH_WORKING_SET (32 << 20)   // bytes of level records over all sides
+#define SEARCH_BASE_PRICE 50000
 
-// Extract results from simple book
-test_result_t extract_simple_book_results(simple_book_t* book) {
-    test_result_t result = {0};
+// The array book's layout before the hot/cold split: price inline with the
+// rest of the level, one 32-byte record per binary-search probe
+typedef struct {
+    uint64_t price;
+    array_price_level_t level;
+} search_record_t;
+
+// The previous find_price_level, on ascending records
+static int record_find(const search_record_t* records, int count, uint64_t price) {
+    int left = 0, right = count - 1;
     
-    // Count bid levels and calculate metrics
-    price_level_t* current = book->bids;
-    while (current) {
-        result.bid_levels++;
-        if (result.bid_levels == 1) {
-            result.best_bid_price = current->price;
+    while (left <= right) {
+        int mid = (left + right) / 2;
+        uint64_t mid_price = records[mid].price;
+        
+        if (mid_price == price) return mid;
+        
+        if (mid_price < price) {
+            left = mid + 1;
+        } else {
+            right = mid - 1;
         }
-        result.total_bid_quantity += current->total_quantity;
-        result.bid_price_checksum += current->price;
-        current = current->next;
     }
-    
-    // Count ask levels and calculate metrics
-    current = book->asks;
-    while (current) {
-        result.ask_levels++;
-        if (result.ask_levels == 1) {
-            result.best_ask_price = current->price;
-        }
-        result.total_ask_quantity += current->total_quantity;
-        result.ask_price_checksum += current->price;
-        current = current->next;
+    return -(left + 1);
+}
+
+// Eytzinger layout: the sorted prices in BFS order of the implicit search
+// tree (children of slot k at 2k and 2k+1, slot 0 unused), filled by an
+// in-order walk. The first few tree levels share a handful of cache lines.
+static int eytzinger_build(uint64_t* eyt, const uint64_t* sorted, int i, int k, int n) {
+    if (k <= n) {
+        i = eytzinger_build(eyt, sorted, i, 2 * k, n);
+        eyt[k] = sorted[i++];
+        i = eytzinger_build(eyt, sorted, i, 2 * k + 1, n);
     }
-    
-    return result;
+    return i;
 }
 
-// Extract results from array book
-test_result_t extract_array_book_results(array_book_t* book) {
-    test_result_t result = {0};
+// Slot of the first price >= price, 0 if there is none. Branchless descent;
+// the 16 descendants four levels down fill one 128-byte block, prefetched
+// while the next levels are compared.
+static inline int eytzinger_lower_bound(const uint64_t* eyt, int n, uint64_t price) {
+    int k = 1;
+    while (k <= n) {
+        __builtin_prefetch(eyt + 16 * k);
+        k = 2 * k + (eyt[k] < price);
+    }
+    return k >> __builtin_ffs(~k);
+}
+
+static void print_search_row(int levels, int sides, const char* layout, uint64_t elapsed,
+                             int64_t l1d_misses, int64_t llc_misses) {
+    char l1d[16] = "n/a", llc[16] = "n/a";
+    if (l1d_misses >= 0) snprintf(l1d, sizeof(l1d), "%.2f", (double)l1d_misses / SEARCH_LOOKUPS);
+    if (llc_misses >= 0) snprintf(llc, sizeof(llc), "%.2f", (double)llc_misses / SEARCH_LOOKUPS);
+    printf("%-8d%-8d%-20s%-12.1f%-14s%-14s\n", levels, sides, layout,
+           (double)elapsed / SEARCH_LOOKUPS, l1d, llc);
+}
+
+// Random lookups (half of them hits) across many sides, as a process
+// holding one book per symbol would do, so the probes come from memory
+// rather than a warm L1. Every side has the same prices; the sides only
+// spread the working set. 5000 levels is beyond MAX_PRICE_LEVELS, so the
+// layouts are built standalone rather than through array_book_t.
+int run_price_search_benchmark() {
+    const int LEVEL_COUNTS[] = {100, 1000, 5000};
+    const int NUM_TESTS = sizeof(LEVEL_COUNTS) / sizeof(LEVEL_COUNTS[0]);
+    int passed = 1;
     
-    result.bid_levels = book->bid_count;
-    result.ask_levels = book->ask_count;
+    int l1d_fd = perf_counter_open(PERF_L1D_READ_MISSES);
+    int llc_fd = perf_counter_open(PERF_LLC_MISSES);
     
-    if (book->bid_count > 0) {
-        result.best_bid_price = book->bids[0].price;
-    }
-    if (book->ask_count > 0) {
-        result.best_ask_price = book->asks[0].price;
+    printf("=== PRICE SEARCH BENCHMARK (%d random lookups, %d MB of records) ===\n",
+           SEARCH_LOOKUPS, SEARCH_WORKING_SET >> 20);
+    if (l1d_fd < 0 || llc_fd < 0) {
+        printf("(perf events unavailable, cache misses not reported)\n");
     }
+    printf("%-8s%-8s%-20s%-12s%-14s%-14s\n",
+           "Levels", "Sides", "Layout", "ns/lookup", "L1D miss/op", "LLC miss/op");
+    printf("==========================================================================\n");
     
-    for (int i = 0; i < book->bid_count; i++) {
-        result.total_bid_quantity += book->bids[i].total_quantity;
-        result.bid_price_checksum += book->bids[i].price;
-    }
+    int* query_sides = malloc(SEARCH_LOOKUPS * sizeof(int));
+    uint64_t* query_prices = malloc(SEARCH_LOOKUPS * sizeof(uint64_t));
     
-    for (int i = 0; i < book->ask_count; i++) {
-        result.total_ask_quantity += book->asks[i].total_quantity;
-        result.ask_price_checksum += book->asks[i].price;
+    for (int t = 0; t < NUM_TESTS && passed; t++) {
+        int levels = LEVEL_COUNTS[t];
+        int sides = SEARCH_WORKING_SET / (levels * (int)sizeof(search_record_t));
+        int eyt_stride = (levels + 1 + 7) & ~7;    // each side's tree starts on a cache line
+        
+        search_record_t* records = malloc((size_t)sides * levels * sizeof(search_record_t));
+        uint64_t* prices = malloc((size_t)sides * levels * sizeof(uint64_t));
+        uint64_t* eyt = aligned_alloc(64, (size_t)sides * eyt_stride * sizeof(uint64_t));
+        
+        for (int s = 0; s < sides; s++) {
+            for (int i = 0; i < levels; i++) {
+                uint64_t price = SEARCH_BASE_PRICE + 2 * i;
+                records[(size_t)s * levels + i] = (search_record_t){ .price = price };
+                prices[(size_t)s * levels + i] = price;
+            }
+            eytzinger_build(eyt + (size_t)s * eyt_stride, prices + (size_t)s * levels, 0, 1, levels);
+        }
+        for (int q = 0; q < SEARCH_LOOKUPS; q++) {
+            query_sides[q] = rand() % sides;
+            query_prices[q] = SEARCH_BASE_PRICE + rand() % (2 * levels);
+        }
+        
+        // All three layouts must agree before any of them is timed
+        for (int q = 0; q < SEARCH_LOOKUPS && passed; q++) {
+            size_t s = query_sides[q];
+            uint64_t price = query_prices[q];
+            int by_record = record_find(records + s * levels, levels, price);
+            int by_index = binary_find_price_level(prices + s * levels, levels, price, 1);
+            int slot = eytzinger_lower_bound(eyt + s * eyt_stride, levels, price);
+            int eyt_found = slot && eyt[s * eyt_stride + slot] == price;
+            if (by_record != by_index || eyt_found != (by_index >= 0)) {
+                printf("❌ FAIL: %d levels, lookup of %lu disagrees (%d, %d, slot %d)\n",
+                       levels, price, by_record, by_index, slot);
+                passed = 0;
+            }
+        }
+        
+        for (int layout = 0; layout < 3 && passed; layout++) {
+            uint64_t checksum = 0;
+            perf_counter_start(l1d_fd);
+            perf_counter_start(llc_fd);
+            uint64_t start = get_time_ns();
+            
+            if (layout == 0) {
+                for (int q = 0; q < SEARCH_LOOKUPS; q++) {
+                    checksum += record_find(records + (size_t)query_sides[q] * levels, levels,
+                                            query_prices[q]);
+                }
+            } else if (layout == 1) {
+                for (int q = 0; q < SEARCH_LOOKUPS; q++) {
+                    checksum += binary_find_price_level(prices + (size_t)query_sides[q] * levels,
+                                                        levels, query_prices[q], 1);
+                }
+            } else {
+                for (int q = 0; q < SEARCH_LOOKUPS; q++) {
+                    checksum += eytzinger_lower_bound(eyt + (size_t)query_sides[q] * eyt_stride,
+                                                      levels, query_prices[q]);
+                }
+            }
+            
+            uint64_t elapsed = get_time_ns() - start;
+            int64_t l1d_misses = perf_counter_stop(l1d_fd);
+            int64_t llc_misses = perf_counter_stop(llc_fd);
+            if (checksum == 0) printf("Warning: search may have been optimized away\n");
+            
+            const char* names[] = {"records (32 B)", "dense branchless", "Eytzinger"};
+            print_search_row(levels, sides, names[layout], elapsed, l1d_misses, llc_misses);
+        }
+        
+        free(records);
+        free(prices);
+        free(eyt);
     }
+    printf("\n");
     
-    return result;
+    if (l1d_fd >= 0) close(l1d_fd);
+    if (llc_fd >= 0) close(llc_fd);
+    free(query_sides);
+    free(query_prices);
+    return !passed;
 }
 
-// Extract results from direct book
-test_result_t extract_direct_book_results(direct_book_t* book) {
-    test_result_t result = {0};
+#define TOUCH_SEARCH_LOOKUPS 2000000
+
+// One warm bid column, looked up either near the touch (90% of prices within
+// 8 levels of the best bid, the rest anywhere) or uniformly over the book
+void run_touch_search_benchmark() {
+    const int LEVEL_COUNTS[] = {100, 1000, 5000};
+    const int NUM_TESTS = sizeof(LEVEL_COUNTS) / sizeof(LEVEL_COUNTS[0]);
+    const char* DISTRIBUTIONS[] = {"near touch", "uniform"};
+    const char* METHODS[] = {"binary", "vector scan", "hybrid"};
     
-    // Find best bid (highest price with orders)
-    for (uint64_t price = book->bid_top; price > 0; price--) {
-        if (price >= PRICE_OFFSET) break;
-        direct_price_level_t* level = &book->bid_levels[PRICE_OFFSET - price];
-        if (level->order_count > 0) {
-            if (result.bid_levels == 0) {
-                result.best_bid_price = price;
-            }
-            result.bid_levels++;
-            result.total_bid_quantity += level->total_quantity;
-            result.bid_price_checksum += price;
-        }
-    }
+    printf("=== PRICE SEARCH NEAR THE TOUCH (%d lookups, one side in cache) ===\n",
+           TOUCH_SEARCH_LOOKUPS);
+    printf("%-8s%-12s%-14s%-14s%-14s\n", "Levels", "Lookups", "binary(ns)", "vector(ns)", "hybrid(ns)");
+    printf("==============================================================\n");
     
-    // Find best ask (lowest price with orders)
-    for (uint64_t price = book->ask_top; price < PRICE_RANGE; price++) {
-        direct_price_level_t* level = &book->ask_levels[price];
-        if (level->order_count > 0) {
-            if (result.ask_levels == 0) {
-                result.best_ask_price = price;
+    uint64_t* queries = malloc(TOUCH_SEARCH_LOOKUPS * sizeof(uint64_t));
+    
+    for (int t = 0; t < NUM_TESTS; t++) {
+        int levels = LEVEL_COUNTS[t];
+        uint64_t* prices = malloc(levels * sizeof(uint64_t));
+        for (int i = 0; i < levels; i++) {
+            prices[i] = SEARCH_BASE_PRICE + 2 * i;     // best bid last
+        }
+        
+        for (int d = 0; d < 2; d++) {
+            for (int q = 0; q < TOUCH_SEARCH_LOOKUPS; q++) {
+                int depth = d == 0 && rand() % 10 ? rand() % 16 : rand() % (2 * levels);
+                queries[q] = SEARCH_BASE_PRICE + 2 * levels - 1 - depth;
             }
-            result.ask_levels++;
-            result.total_ask_quantity += level->total_quantity;
-            result.ask_price_checksum += price;
+            
+            double ns[3];
+            for (int m = 0; m < 3; m++) {
+                uint64_t checksum = 0;
+                uint64_t start = get_time_ns();
+                for (int q = 0; q < TOUCH_SEARCH_LOOKUPS; q++) {
+                    if (m == 0) {
+                        checksum += binary_find_price_level(prices, levels, queries[q], 1);
+                    } else if (m == 1) {
+                        checksum += simd_lower_bound(prices, levels, queries[q], 1);
+                    } else {
+                        checksum += find_price_level(prices, levels, queries[q], 1);
+                    }
+                }
+                ns[m] = (double)(get_time_ns() - start) / TOUCH_SEARCH_LOOKUPS;
+                if (checksum == 0) printf("Warning: %s search may have been optimized away\n", METHODS[m]);
+            }
+            printf("%-8d%-12s%-14.2f%-14.2f%-14.2f\n", levels, DISTRIBUTIONS[d], ns[0], ns[1], ns[2]);
         }
+        free(prices);
     }
-    
-    return result;
+    printf("\n");
+    free(queries);
 }
 
-// Compare two test results
-int compare_results(test_result_t* a, test_result_t* b, const char* name_a, const char* name_b) {
-    int passed = 1;
-    
-    if (a->bid_levels != b->bid_levels) {
-        printf("❌ FAIL: %s vs %s - Bid levels: %d vs %d\n", 
-               name_a, name_b, a->bid_levels, b->bid_levels);
-        passed = 0;
+// =============================================================================
+// LOCK-FREE SCALING BENCHMARK (WRITERS AND READERS ACROSS CORES)
+// =============================================================================
+// Writers split one op stream by price (price % writers), so their ops
+// commute and the final book must match the sequential simple book, yet they
+// all still contend on the same list near the touch. Readers poll the top
+// of book until the writers finish. The baseline is one writer applying the
+// whole stream to the simple book: the same sorted list without atomics.
+#define LOCKFREE_BENCH_OPS 200000
+
+typedef struct {
+    lockfree_book_t* book;
+    lockfree_thread_t* thread;
+    book_op_t* ops;
+    int count;
+    int cpu;
+    _Atomic int* start;
+    _Atomic int* done;
+    uint64_t reads;
+    uint64_t checksum;          // keeps the reads from being optimized out
+} lockfree_worker_t;
+
+static void lockfree_pin_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+    (void)cpu;
+#endif
+}
+
+static void* lockfree_writer(void* arg) {
+    lockfree_worker_t* w = arg;
+    lockfree_pin_cpu(w->cpu);
+    while (!atomic_load(w->start)) {}
+    
+    lockfree_apply_ops(w->book, w->thread, w->ops, w->count);
+    slab_cache_flush(&w->thread->levels);
+    slab_cache_flush(&w->thread->orders);
+    return NULL;
+}
+
+static void* lockfree_reader(void* arg) {
+    lockfree_worker_t* w = arg;
+    lockfree_pin_cpu(w->cpu);
+    while (!atomic_load(w->start)) {}
+    
+    uint64_t checksum = 0;
+    while (!atomic_load_explicit(w->done, memory_order_relaxed)) {
+        lockfree_pin(w->book, w->thread);
+        lockfree_level_t* bid = lockfree_best(w->book, 1);
+        lockfree_level_t* ask = lockfree_best(w->book, 0);
+        if (bid) checksum += bid->price + atomic_load_explicit(&bid->total_quantity, memory_order_relaxed);
+        if (ask) checksum += ask->price + atomic_load_explicit(&ask->total_quantity, memory_order_relaxed);
+        lockfree_unpin(w->thread);
+        w->reads++;
     }
-    
-    if (a->ask_levels != b->ask_levels) {
-        printf("❌ FAIL: %s vs %s - Ask levels: %d vs %d\n", 
-               name_a, name_b, a->ask_levels, b->ask_levels);
-        passed = 0;
+    w->checksum = checksum;
+    return NULL;
+}
+
+// Returns elapsed ms for the writers, -1 if the final book is wrong
+static double run_lockfree_config(const book_op_t* ops, int count, int writers, int readers,
+                                  long cpu_count, test_result_t* expected, double* reads_per_sec) {
+    lockfree_book_t* book = aligned_alloc(64, (sizeof(lockfree_book_t) + 63) & ~(size_t)63);
+    lockfree_book_init(book, count);
+    lockfree_worker_t workers[LOCKFREE_MAX_THREADS] = {0};
+    pthread_t ids[LOCKFREE_MAX_THREADS];
+    _Atomic int start = 0, done = 0;
+    
+    // Partition the stream by price, keeping each writer's order
+    for (int w = 0; w < writers; w++) {
+        workers[w].ops = malloc(count * sizeof(book_op_t));
     }
-    
-    if (a->best_bid_price != b->best_bid_price) {
-        printf("❌ FAIL: %s vs %s - Best bid: %lu vs %lu\n", 
-               name_a, name_b, a->best_bid_price, b->best_bid_price);
-        passed = 0;
+    for (int i = 0; i < count; i++) {
+        lockfree_worker_t* w = &workers[ops[i].price % writers];
+        w->ops[w->count++] = ops[i];
     }
     
-    if (a->best_ask_price != b->best_ask_price) {
-        printf("❌ FAIL: %s vs %s - Best ask: %lu vs %lu\n", 
-               name_a, name_b, a->best_ask_price, b->best_ask_price);
-        passed = 0;
+    for (int i = 0; i < writers + readers; i++) {
+        workers[i].book = book;
+        workers[i].thread = lockfree_thread_register(book);
+        workers[i].cpu = cpu_count > 0 ? i % cpu_count : 0;
+        workers[i].start = &start;
+        workers[i].done = &done;
+        pthread_create(&ids[i], NULL, i < writers ? lockfree_writer : lockfree_reader, &workers[i]);
     }
-    
-    if (a->total_bid_quantity != b->total_bid_quantity) {
-        printf("❌ FAIL: %s vs %s - Total bid qty: %lu vs %lu\n", 
-               name_a, name_b, a->total_bid_quantity, b->total_bid_quantity);
-        passed = 0;
+    
+    uint64_t begin = get_time_ns();
+    atomic_store(&start, 1);
+    for (int i = 0; i < writers; i++) {
+        pthread_join(ids[i], NULL);
     }
+    uint64_t end = get_time_ns();
+    atomic_store(&done, 1);
     
-    if (a->total_ask_quantity != b->total_ask_quantity) {
-        printf("❌ FAIL: %s vs %s - Total ask qty: %lu vs %lu\n", 
-               name_a, name_b, a->total_ask_quantity, b->total_ask_quantity);
-        passed = 0;
+    uint64_t reads = 0;
+    for (int i = writers; i < writers + readers; i++) {
+        pthread_join(ids[i], NULL);
+        reads += workers[i].reads;
     }
+    *reads_per_sec = reads / ((end - begin) / 1e9);
     
-    if (a->bid_price_checksum != b->bid_price_checksum) {
-        printf("❌ FAIL: %s vs %s - Bid price checksum: %lu vs %lu\n", 
-               name_a, name_b, a->bid_price_checksum, b->bid_price_checksum);
-        passed = 0;
+    test_result_t result = extract_lockfree_book_results(book);
+    int passed = compare_results(expected, &result, "Simple", "Lock-free (threaded)");
+    
+    for (int w = 0; w < writers; w++) {
+        free(workers[w].ops);
     }
+    lockfree_book_free(book);
+    free(book);
     
-    if (a->ask_price_checksum != b->ask_price_checksum) {
-        printf("❌ FAIL: %s vs %s - Ask price checksum: %lu vs %lu\n", 
-               name_a, name_b, a->ask_price_checksum, b->ask_price_checksum);
-        passed = 0;
+    return passed ? (end - begin) / 1000000.0 : -1;
+}
+
+// Sweep writers (no readers), then readers next to a single writer
+int run_lockfree_scaling_benchmark(int max_threads) {
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads <= 0) max_threads = cpu_count > 0 ? cpu_count : 1;
+    if (max_threads > LOCKFREE_MAX_THREADS) max_threads = LOCKFREE_MAX_THREADS;
+    
+    printf("\n=== LOCK-FREE SCALING (%d ops, %ld cpus, up to %d threads) ===\n",
+           LOCKFREE_BENCH_OPS, cpu_count, max_threads);
+    
+    book_op_t* ops = malloc(LOCKFREE_BENCH_OPS * sizeof(book_op_t));
+    generate_book_ops(ops, LOCKFREE_BENCH_OPS, 50000);
+    
+    // Single-writer baseline, also the expected final book
+    simple_book_t simple_book;
+    simple_book_init(&simple_book);
+    slab_pool_reserve(&simple_book.levels, LOCKFREE_BENCH_OPS);
+    slab_pool_t simple_orders;
+    slab_pool_init(&simple_orders, sizeof(order_t));
+    slab_pool_reserve(&simple_orders, LOCKFREE_BENCH_OPS);
+    uint64_t begin = get_time_ns();
+    simple_apply_ops(&simple_book, ops, LOCKFREE_BENCH_OPS, &simple_orders);
+    double single_ms = (get_time_ns() - begin) / 1000000.0;
+    test_result_t expected = extract_simple_book_results(&simple_book);
+    
+    printf("Single writer, simple book: %.2f ms (%.1f Mops/s)\n\n",
+           single_ms, LOCKFREE_BENCH_OPS / single_ms / 1000.0);
+    printf("%-10s%-10s%-15s%-15s%-15s%-15s\n", "Writers", "Readers", "Time(ms)", "Mops/s",
+           "Mreads/s", "vs single");
+    printf("================================================================================\n");
+    
+    int failed = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int n = 1; n <= max_threads; n *= 2) {
+            int writers = pass == 0 ? n : 1;
+            int readers = pass == 0 ? 0 : n;
+            if (pass == 1 && writers + readers > max_threads && n > 1) break;
+            
+            double reads_per_sec;
+            double ms = run_lockfree_config(ops, LOCKFREE_BENCH_OPS, writers, readers, cpu_count,
+                                            &expected, &reads_per_sec);
+            if (ms < 0) {
+                failed = 1;
+                continue;
+            }
+            printf("%-10d%-10d%-15.2f%-15.1f%-15.1f%-15.2fx\n", writers, readers, ms,
+                   LOCKFREE_BENCH_OPS / ms / 1000.0, reads_per_sec / 1e6, single_ms / ms);
+        }
     }
     
-    return passed;
+    simple_book_free(&simple_book);
+    slab_pool_destroy(&simple_orders);
+    free(ops);
+    return failed;
 }
 
-// Test SIMD correctness
-int test_simd_correctness() {
-    printf("\n=== SIMD CORRECTNESS TEST ===\n");
+#define BOOK_SCAN_LEVELS_TOUCHED 20000000
+
+// The book_scan.h kernels over one bid side in SOA columns, C reference
+// against the assembly bound for this CPU. Every call walks the whole side:
+// depth of all levels, a price lookup anywhere in the book, VWAP for half
+// the side's amount.
+int run_book_scan_benchmark() {
+    const int DEPTHS[] = {10, 100, 1000, 5000};
+    const int NUM_DEPTHS = sizeof(DEPTHS) / sizeof(DEPTHS[0]);
+    const int MAX_DEPTH = 5000;
+    const char* native = book_scan_kernel();
+    
+    printf("\n=== BOOK SCAN KERNELS (C reference vs %s assembly) ===\n", native);
+    if (strcmp(native, "c") == 0) {
+        printf("No assembly kernels for this CPU, both columns run the C reference\n");
+    }
     
-    const int TEST_SIZES[] = {1, 4, 7, 16, 100, 1000, 10007}; // Various sizes including edge cases
-    const int NUM_SIZES = sizeof(TEST_SIZES) / sizeof(TEST_SIZES[0]);
-    int all_passed = 1;
+    int64_t* prices = malloc(MAX_DEPTH * sizeof(int64_t));
+    int64_t* amounts = malloc(MAX_DEPTH * sizeof(int64_t));
+    for (int i = 0; i < MAX_DEPTH; i++) {
+        prices[i] = (50000LL * 100 - i) * 1000000LL;      // 50000.00 down by 0.01
+        amounts[i] = (1 + rand() % 1000) * 1000000LL;     // 0.01 to 10.00
+    }
     
-    for (int t = 0; t < NUM_SIZES; t++) {
-        int size = TEST_SIZES[t];
-        uint32_t* data = aligned_alloc(16, size * sizeof(uint32_t));
+    printf("%-8s%-8s%-15s%-15s%-10s\n", "Levels", "Kernel", "C (ns/call)",
+           "asm (ns/call)", "Speedup");
+    printf("========================================================\n");
+    
+    int failed = 0;
+    volatile int64_t sink = 0;
+    for (int d = 0; d < NUM_DEPTHS; d++) {
+        int count = DEPTHS[d];
+        int iterations = BOOK_SCAN_LEVELS_TOUCHED / count;
+        int64_t half = book_scan_depth_c(amounts, count, count) / 2;
+        int lookup_mask = 1023;
+        int* lookups = malloc((lookup_mask + 1) * sizeof(int));
+        for (int i = 0; i <= lookup_mask; i++) {
+            lookups[i] = rand() % count;
+        }
         
-        // Fill with test pattern
-        for (int i = 0; i < size; i++) {
-            data[i] = (i * 7 + 13) % 1000; // Deterministic pattern
+        // Both versions must agree before they are timed
+        double c_notional, asm_notional;
+        int64_t c_filled = book_scan_vwap_c(prices, amounts, count, half, &c_notional);
+        int64_t asm_filled = book_scan_vwap(prices, amounts, count, half, &asm_notional);
+        if (book_scan_depth(amounts, count, count) != book_scan_depth_c(amounts, count, count) ||
+            book_scan_find(prices, count, prices[lookups[0]]) != lookups[0] ||
+            asm_filled != c_filled ||
+            fabs(asm_notional - c_notional) > 1e-12 * c_notional) {
+            printf("❌ %s kernels disagree with the C reference at %d levels\n", native, count);
+            failed = 1;
+            free(lookups);
+            continue;
         }
         
-        uint64_t simd_result = simd_sum_quantities(data, size);
-        uint64_t generic_result = simd_sum_quantities_generic(data, size);
+        uint64_t start = get_time_ns();
+        for (int i = 0; i < iterations; i++) sink += book_scan_depth_c(amounts, count, count);
+        uint64_t c_depth = get_time_ns() - start;
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) sink += book_scan_depth(amounts, count, count);
+        uint64_t asm_depth = get_time_ns() - start;
         
-        if (simd_result != generic_result) {
-            printf("❌ SIMD FAIL (size %d): SIMD=%lu, Generic=%lu\n", 
-                   size, simd_result, generic_result);
-            all_passed = 0;
-        } else {
-            printf("✅ SIMD PASS (size %d): Both=%lu\n", size, simd_result);
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            sink += book_scan_find_c(prices, count, prices[lookups[i & lookup_mask]]);
+        }
+        uint64_t c_find = get_time_ns() - start;
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            sink += book_scan_find(prices, count, prices[lookups[i & lookup_mask]]);
         }
+        uint64_t asm_find = get_time_ns() - start;
         
-        free(data);
+        double notional;
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            sink += book_scan_vwap_c(prices, amounts, count, half, &notional);
+        }
+        uint64_t c_vwap = get_time_ns() - start;
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            sink += book_scan_vwap(prices, amounts, count, half, &notional);
+        }
+        uint64_t asm_vwap = get_time_ns() - start;
+        
+        const char* names[] = {"depth", "find", "vwap"};
+        uint64_t c_ns[] = {c_depth, c_find, c_vwap};
+        uint64_t asm_ns[] = {asm_depth, asm_find, asm_vwap};
+        for (int k = 0; k < 3; k++) {
+            printf("%-8d%-8s%-15.1f%-15.1f%-10.2fx\n", count, names[k],
+                   (double)c_ns[k] / iterations, (double)asm_ns[k] / iterations,
+                   (double)c_ns[k] / asm_ns[k]);
+        }
+        free(lookups);
     }
+    (void)sink;
     
-    return all_passed;
+    free(prices);
+    free(amounts);
+    return failed;
 }
 
-// Comprehensive correctness test
-int run_correctness_tests() {
-    printf("\n=== COMPREHENSIVE CORRECTNESS TESTS ===\n");
-    
-    const int TEST_ORDER_COUNT = 5000;
-    const uint64_t BASE_PRICE = 50000;
-    
-    // Generate deterministic test data
-    benchmark_order_t* orders = malloc(TEST_ORDER_COUNT * sizeof(benchmark_order_t));
-    generate_orders(orders, TEST_ORDER_COUNT, BASE_PRICE);
-    
-    // Build simple book
-    printf("Building simple linked list book...\n");
-    simple_book_t simple_book = {0};
-    order_t* simple_orders = malloc(TEST_ORDER_COUNT * sizeof(order_t));
-    
-    for (int i = 0; i < TEST_ORDER_COUNT; i++) {
-        simple_orders[i].id = orders[i].id;
-        simple_orders[i].price = orders[i].price;
-        simple_orders[i].quantity = orders[i].quantity;
-        simple_orders[i].next = NULL;
-        simple_insert_order(&simple_book, &simple_orders[i], orders[i].is_bid);
+#define BOOK_QUERY_TARGETS 1024
+
+// Cost-to-fill over a full SOA book, scalar reference against the prefix-sum
+// kernel bound for this CPU. Queries alternate buy and sell, each for a
+// random fraction of the side's quantity or notional, so the walk stops
+// anywhere in the book.
+int run_book_query_benchmark() {
+    const int DEPTHS[] = {10, 100, 5000};
+    const int NUM_DEPTHS = sizeof(DEPTHS) / sizeof(DEPTHS[0]);
+    const int MAX_DEPTH = 5000;
+    
+    printf("\n=== COST TO FILL (scalar vs %s prefix sums, buy and sell) ===\n", book_query_kernel());
+    
+    OrderBookSOA book = {0};
+    book.bids.prices = aligned_alloc(SOA_ALIGNMENT, MAX_DEPTH * sizeof(int64_t));
+    book.bids.amounts = aligned_alloc(SOA_ALIGNMENT, MAX_DEPTH * sizeof(int64_t));
+    book.asks.prices = aligned_alloc(SOA_ALIGNMENT, MAX_DEPTH * sizeof(int64_t));
+    book.asks.amounts = aligned_alloc(SOA_ALIGNMENT, MAX_DEPTH * sizeof(int64_t));
+    for (int i = 0; i < MAX_DEPTH; i++) {
+        book.bids.prices[i] = (50000LL * 100 - i) * 1000000LL;       // 50000.00 down by 0.01
+        book.asks.prices[i] = (50000LL * 100 + 1 + i) * 1000000LL;   // 50000.01 up by 0.01
+        book.bids.amounts[i] = (1 + rand() % 1000) * 1000000LL;      // 0.01 to 10.00
+        book.asks.amounts[i] = (1 + rand() % 1000) * 1000000LL;
     }
-    
-    // Build array book
-    printf("Building array-based book...\n");
-    array_book_t array_book = {0};
-    for (int i = 0; i < TEST_ORDER_COUNT; i++) {
-        order_t order = {
-            .id = orders[i].id,
-            .price = orders[i].price,
-            .quantity = orders[i].quantity
-        };
-        array_insert_order(&array_book, &order, orders[i].is_bid);
+    double fractions[BOOK_QUERY_TARGETS];
+    for (int i = 0; i < BOOK_QUERY_TARGETS; i++) {
+        fractions[i] = (rand() % 1000) / 1000.0;
     }
     
-    // Build direct book
-    printf("Building direct mapping book...\n");
-    direct_book_t direct_book = {0};
-    direct_book.bid_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
-    direct_book.ask_levels = calloc(PRICE_RANGE, sizeof(direct_price_level_t));
-    order_t* direct_orders = malloc(TEST_ORDER_COUNT * sizeof(order_t));
+    printf("%-8s%-10s%-12s%-15s%-15s%-10s\n", "Levels", "Target", "Avg levels",
+           "Scalar (ns)", "Vector (ns)", "Speedup");
+    printf("======================================================================\n");
     
-    int valid_orders = 0;
-    for (int i = 0; i < TEST_ORDER_COUNT; i++) {
-        direct_orders[i].id = orders[i].id;
-        direct_orders[i].price = orders[i].price;
-        direct_orders[i].quantity = orders[i].quantity;
+    int failed = 0;
+    volatile int64_t sink = 0;
+    for (int d = 0; d < NUM_DEPTHS; d++) {
+        int depth = DEPTHS[d];
+        int iterations = BOOK_SCAN_LEVELS_TOUCHED / depth;
+        book.bids.count = book.asks.count = book.bids.capacity = book.asks.capacity = depth;
         
-        // Only add orders within valid price range
-        if ((orders[i].is_bid && orders[i].price < PRICE_OFFSET) ||
-            (!orders[i].is_bid && orders[i].price < PRICE_RANGE)) {
-            direct_insert_order(&direct_book, &direct_orders[i], orders[i].is_bid);
-            valid_orders++;
+        int64_t quantities[BOOK_QUERY_TARGETS];
+        double notionals[BOOK_QUERY_TARGETS];
+        long total_levels = 0;
+        for (int i = 0; i < BOOK_QUERY_TARGETS; i++) {
+            const SideSOA* side = (i & 1) ? &book.asks : &book.bids;
+            BookFill all, expected, fill;
+            book_query_quantity_scalar(side, INT64_MAX / 2, &all);
+            quantities[i] = (int64_t)(all.filled * fractions[i]);
+            notionals[i] = all.notional * fractions[i];
+            
+            // The kernels must agree with the reference before they are timed
+            book_query_quantity_scalar(side, quantities[i], &expected);
+            book_query_quantity(side, quantities[i], &fill);
+            if (fill.filled != expected.filled || fill.levels != expected.levels ||
+                fabs(fill.notional - expected.notional) > 1e-12 * expected.notional) {
+                failed = 1;
+            }
+            total_levels += expected.levels;
         }
+        if (failed) {
+            printf("❌ %s cost to fill disagrees with the scalar reference at %d levels\n",
+                   book_query_kernel(), depth);
+            break;
+        }
+        
+        BookFill fill;
+        uint64_t start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            int q = i & (BOOK_QUERY_TARGETS - 1);
+            book_query_quantity_scalar((q & 1) ? &book.asks : &book.bids, quantities[q], &fill);
+            sink += fill.levels;
+        }
+        uint64_t scalar_quantity = get_time_ns() - start;
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            int q = i & (BOOK_QUERY_TARGETS - 1);
+            book_cost_to_fill(&book, q & 1, quantities[q], &fill);
+            sink += fill.levels;
+        }
+        uint64_t vector_quantity = get_time_ns() - start;
+        
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            int q = i & (BOOK_QUERY_TARGETS - 1);
+            book_query_notional_scalar((q & 1) ? &book.asks : &book.bids, notionals[q], &fill);
+            sink += fill.levels;
+        }
+        uint64_t scalar_notional = get_time_ns() - start;
+        start = get_time_ns();
+        for (int i = 0; i < iterations; i++) {
+            int q = i & (BOOK_QUERY_TARGETS - 1);
+            book_fill_notional(&book, q & 1, notionals[q], &fill);
+            sink += fill.levels;
+        }
+        uint64_t vector_notional = get_time_ns() - start;
+        
+        double avg_levels = (double)total_levels / BOOK_QUERY_TARGETS;
+        printf("%-8d%-10s%-12.1f%-15.1f%-15.1f%-10.2fx\n", depth, "quantity", avg_levels,
+               (double)scalar_quantity / iterations, (double)vector_quantity / iterations,
+               (double)scalar_quantity / vector_quantity);
+        printf("%-8d%-10s%-12.1f%-15.1f%-15.1f%-10.2fx\n", depth, "notional", avg_levels,
+               (double)scalar_notional / iterations, (double)vector_notional / iterations,
+               (double)scalar_notional / vector_notional);
     }
+    (void)sink;
     
-    printf("Added %d valid orders to direct book\n", valid_orders);
-    
-    // Extract results
-    test_result_t simple_result = extract_simple_book_results(&simple_book);
-    test_result_t array_result = extract_array_book_results(&array_book);
-    test_result_t direct_result = extract_direct_book_results(&direct_book);
-    
-    // Print summary
-    printf("\nRESULT SUMMARY:\n");
-    printf("%-15s %-10s %-10s %-12s %-12s %-15s %-15s\n", 
-           "Implementation", "BidLvls", "AskLvls", "BestBid", "BestAsk", "TotalBidQty", "TotalAskQty");
-    printf("%-15s %-10d %-10d %-12lu %-12lu %-15lu %-15lu\n", 
-           "Simple", simple_result.bid_levels, simple_result.ask_levels,
-           simple_result.best_bid_price, simple_result.best_ask_price,
-           simple_result.total_bid_quantity, simple_result.total_ask_quantity);
-    printf("%-15s %-10d %-10d %-12lu %-12lu %-15lu %-15lu\n", 
-           "Array", array_result.bid_levels, array_result.ask_levels,
-           array_result.best_bid_price, array_result.best_ask_price,
-           array_result.total_bid_quantity, array_result.total_ask_quantity);
-    printf("%-15s %-10d %-10d %-12lu %-12lu %-15lu %-15lu\n", 
-           "Direct", direct_result.bid_levels, direct_result.ask_levels,
-           direct_result.best_bid_price, direct_result.best_ask_price,
-           direct_result.total_bid_quantity, direct_result.total_ask_quantity);
-    
-    // Compare results
-    printf("\nCORRECTNESS COMPARISON:\n");
-    int test1 = compare_results(&simple_result, &array_result, "Simple", "Array");
-    int test2 = compare_results(&simple_result, &direct_result, "Simple", "Direct");
-    int test3 = test_simd_correctness();
-    
-    int all_passed = test1 && test2 && test3;
-    
-    if (all_passed) {
-        printf("\n🎉 ALL CORRECTNESS TESTS PASSED! 🎉\n");
-        printf("All implementations produce identical results.\n");
-    } else {
-        printf("\n💥 CORRECTNESS TESTS FAILED! 💥\n");
-        printf("Some implementations have bugs - performance results may be invalid.\n");
-    }
-    
-    // Cleanup
-    price_level_t* current = simple_book.bids;
-    while (current) {
-        price_level_t* next = current->next;
-        free(current);
-        current = next;
-    }
-    current = simple_book.asks;
-    while (current) {
-        price_level_t* next = current->next;
-        free(current);
-        current = next;
-    }
-    
-    free(orders);
-    free(simple_orders);
-    free(direct_book.bid_levels);
-    free(direct_book.ask_levels);
-    free(direct_orders);
-    
-    return all_passed;
+    free(book.bids.prices);
+    free(book.bids.amounts);
+    free(book.asks.prices);
+    free(book.asks.amounts);
+    return failed;
 }
-// Main benchmark runner
-void run_comprehensive_benchmark() {
+
+// Main benchmark runner. Returns 0, or 1 if the correctness tests or any
+// benchmark's own check of its kernels against the reference failed.
+int run_comprehensive_benchmark() {
     // First run correctness tests
     printf("=== STARTING COMPREHENSIVE BENCHMARK ===\n");
     printf("Step 1: Verifying correctness of all implementations...\n");
@@ -1089,44 +5205,31 @@ void run_comprehensive_benchmark() {
     if (!run_correctness_tests()) {
         printf("\n🚨 ABORTING BENCHMARK - CORRECTNESS TESTS FAILED! 🚨\n");
         printf("Fix implementation bugs before running performance tests.\n");
-        return;
+        return 1;
     }
     
     printf("\n=== PERFORMANCE BENCHMARK (CORRECTNESS VERIFIED) ===\n\n");
     
-    const int ORDER_COUNTS[] = {1000, 5000, 10000, 25000};
-    const int NUM_TESTS = sizeof(ORDER_COUNTS) / sizeof(ORDER_COUNTS[0]);
-    const uint64_t BASE_PRICE = 50000;
-    
-    printf("%-15s", "Orders");
-    printf("%-15s", "Simple(ms)");
-    printf("%-15s", "Array(ms)");
-    printf("%-15s", "Direct(ms)");
-    printf("%-15s", "Speedup");
-    printf("\n");
-    printf("================================================================\n");
-    
-    for (int t = 0; t < NUM_TESTS; t++) {
-        int count = ORDER_COUNTS[t];
-        benchmark_order_t* orders = malloc(count * sizeof(benchmark_order_t));
-        generate_orders(orders, count, BASE_PRICE);
-        
-        // Run benchmarks
-        double simple_time = benchmark_simple_book(orders, count);
-        double array_time = benchmark_array_book(orders, count);
-        double direct_time = benchmark_direct_book(orders, count);
-        
-        double speedup = simple_time / direct_time;
-        
-        printf("%-15d", count);
-        printf("%-15.2f", simple_time);
-        printf("%-15.2f", array_time);
-        printf("%-15.2f", direct_time);
-        printf("%-15.1fx", speedup);
-        printf("\n");
-        
-        free(orders);
-    }
+    run_ops_benchmark("20% insert / 60% modify / 20% delete, concentrated near the touch",
+                      generate_book_ops, 50000);
+    run_ops_benchmark("delete-heavy: 45% insert / 55% delete of the best level, sparse book",
+                      generate_delete_heavy_ops, 50000);
+    run_ops_benchmark("deep: same mix spread uniformly over 5000 levels per side",
+                      generate_deep_ops, 50000);
+    run_ops_benchmark("drifting: BTCUSDT tick prices (~11.8M), touch trending ~1/4 tick per op",
+                      generate_drifting_ops, BTC_TICK_PRICE);
+    
+    run_l3_benchmark();
+    run_matching_benchmark();
+    run_touch_search_benchmark();
+    
+    // These check their kernels against a reference before timing them
+    const char* failed[4];
+    int failures = 0;
+    if (run_price_search_benchmark()) failed[failures++] = "price search";
+    if (run_book_scan_benchmark()) failed[failures++] = "book scan";
+    if (run_book_query_benchmark()) failed[failures++] = "book query";
+    if (run_lockfree_scaling_benchmark(0)) failed[failures++] = "lock-free scaling";
     
     // SIMD benchmark
     printf("\n=== SIMD PERFORMANCE ===\n");
@@ -1150,22 +5253,207 @@ void run_comprehensive_benchmark() {
     printf("Generic aggregation: %.2f ms\n", generic_time);
     printf("SIMD speedup: %.1fx\n", generic_time / simd_time);
     
-#ifdef SIMD_ARM
-    printf("Using ARM NEON SIMD instructions\n");
-#elif defined(SIMD_X86)
-    printf("Using x86 AVX2 SIMD instructions\n");
-#else
-    printf("No SIMD support detected\n");
-#endif
+    print_simd_dispatch();
     
     free(quantities);
     
     benchmark_read_performance();
     analyze_memory_usage();
+    
+    if (failures) {
+        printf("\n🚨 BENCHMARK VERIFICATION FAILED: ");
+        for (int i = 0; i < failures; i++) {
+            printf("%s%s", i ? ", " : "", failed[i]);
+        }
+        printf(" - their timings are not valid 🚨\n");
+        return 1;
+    }
+    return 0;
+}
+
+// =============================================================================
+// PRICE/QUANTITY DECODER BENCHMARK (fixed-point SWAR vs atof)
+// =============================================================================
+
+#define DEFAULT_DEPTH_FILE "data/BTCUSDT.depth_20250810.json"
+
+typedef struct {
+    const char* start;
+    const char* end;
+} number_span_t;
+
+// The previous parse_entry() path: copy into a stack buffer and call atof
+static double atof_parse_double(const char* start, const char* end) {
+    char temp[100];
+    int len = end - start;
+    if (len >= 100) len = 99;
+    memcpy(temp, start, len);
+    temp[len] = '\0';
+
+    return atof(temp);
+}
+
+// Collect every quoted numeric string (prices and amounts) in the document
+static int collect_number_spans(const char* json, number_span_t** spans_out) {
+    int capacity = 1024, count = 0;
+    number_span_t* spans = malloc(capacity * sizeof(number_span_t));
+
+    for (const char* ptr = strchr(json, '"'); ptr; ptr = strchr(ptr + 1, '"')) {
+        const char* start = ptr + 1;
+        const char* end = strchr(start, '"');
+        if (!end) break;
+
+        if (*start >= '0' && *start <= '9') {
+            if (count == capacity) {
+                capacity *= 2;
+                spans = realloc(spans, capacity * sizeof(number_span_t));
+            }
+            spans[count].start = start;
+            spans[count].end = end;
+            count++;
+        }
+        ptr = end;
+    }
+
+    *spans_out = spans;
+    return count;
+}
+
+int run_decoder_benchmark(const char* filename) {
+    printf("=== PRICE/QUANTITY DECODER BENCHMARK ===\n");
+
+    char* json = load_json_file(filename);
+    if (!json) {
+        printf("Failed to load %s\n", filename);
+        return 1;
+    }
+
+    number_span_t* spans;
+    int count = collect_number_spans(json, &spans);
+    printf("File: %s (%d numeric fields per message)\n", filename, count);
+
+    // Correctness: the fixed-point path must give exactly the atof double
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        int64_t value, scalar_value;
+        double expected = atof_parse_double(spans[i].start, spans[i].end);
+        if (!parse_fixed_point(spans[i].start, spans[i].end, &value) ||
+            !parse_fixed_point_scalar(spans[i].start, spans[i].end, &scalar_value) ||
+            value != scalar_value ||
+            fixed_point_to_double(value) != expected) {
+            if (mismatches++ < 10) {
+                printf("❌ Mismatch on \"%.*s\"\n",
+                       (int)(spans[i].end - spans[i].start), spans[i].start);
+            }
+        }
+    }
+    if (mismatches) {
+        printf("❌ %d decoder mismatches, skipping timings\n", mismatches);
+        free(spans);
+        free_json_data(json);
+        return 1;
+    }
+    printf("✅ Fixed-point decoder matches atof on all %d fields\n\n", count);
+
+    const int ITERATIONS = 200;
+    volatile double double_sink = 0;
+    volatile int64_t fixed_sink = 0;
+
+    uint64_t start = get_time_ns();
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        double sum = 0;
+        for (int i = 0; i < count; i++) {
+            sum += atof_parse_double(spans[i].start, spans[i].end);
+        }
+        double_sink = sum;
+    }
+    uint64_t atof_ns = get_time_ns() - start;
+
+    start = get_time_ns();
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        int64_t sum = 0;
+        for (int i = 0; i < count; i++) {
+            int64_t value;
+            parse_fixed_point_scalar(spans[i].start, spans[i].end, &value);
+            sum += value;
+        }
+        fixed_sink = sum;
+    }
+    uint64_t scalar_ns = get_time_ns() - start;
+
+    start = get_time_ns();
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        int64_t sum = 0;
+        for (int i = 0; i < count; i++) {
+            int64_t value;
+            parse_fixed_point(spans[i].start, spans[i].end, &value);
+            sum += value;
+        }
+        fixed_sink = sum;
+    }
+    uint64_t swar_ns = get_time_ns() - start;
+    (void)double_sink;
+    (void)fixed_sink;
+
+    double total = (double)count * ITERATIONS;
+    printf("%-25s %-15s %-15s\n", "Decoder", "ns/field", "us/message");
+    printf("%-25s %-15.2f %-15.2f\n", "copy + atof", atof_ns / total,
+           atof_ns / 1000.0 / ITERATIONS);
+    printf("%-25s %-15.2f %-15.2f\n", "fixed-point scalar", scalar_ns / total,
+           scalar_ns / 1000.0 / ITERATIONS);
+    printf("%-25s %-15.2f %-15.2f\n", "fixed-point SWAR", swar_ns / total,
+           swar_ns / 1000.0 / ITERATIONS);
+    printf("SWAR speedup vs atof: %.1fx\n", (double)atof_ns / swar_ns);
+
+    free(spans);
+    free_json_data(json);
+    return 0;
 }
 
 // Example usage and testing
-int main() {
+int main(int argc, char** argv) {
+    // --pages=normal|thp|hugetlb picks the slab backing, ahead of any subcommand
+    if (argc > 1 && strncmp(argv[1], "--pages=", 8) == 0) {
+        const char* mode = argv[1] + 8;
+        int found = 0;
+        for (int p = SLAB_PAGES_NORMAL; p <= SLAB_PAGES_HUGETLB; p++) {
+            if (strcmp(mode, slab_pages_names[p]) == 0) {
+                slab_pages_wanted = p;
+                found = 1;
+            }
+        }
+        if (!found) {
+            printf("Unknown page mode %s (normal, thp or hugetlb)\n", mode);
+            return 1;
+        }
+        argv++;
+        argc--;
+    }
+    
+    print_simd_dispatch();
+#ifndef __OPTIMIZE__
+    printf("⚠️  Built without optimization: timings are not representative "
+           "(make build-benchmark builds with -O2)\n");
+#endif
+    
+    if (argc > 1 && strcmp(argv[1], "decode") == 0) {
+        return run_decoder_benchmark(argc > 2 ? argv[2] : DEFAULT_DEPTH_FILE);
+    }
+    if (argc > 1 && strcmp(argv[1], "search") == 0) {
+        run_touch_search_benchmark();
+        return run_price_search_benchmark();
+    }
+    if (argc > 1 && strcmp(argv[1], "scan") == 0) {
+        return run_book_scan_benchmark();
+    }
+    if (argc > 1 && strcmp(argv[1], "query") == 0) {
+        return run_book_query_benchmark();
+    }
+    if (argc > 1 && strcmp(argv[1], "lockfree") == 0) {
+        return run_lockfree_scaling_benchmark(argc > 2 ? atoi(argv[2]) : 0);
+    }
+
+
     print_performance_characteristics();
     
     printf("MODERN HARDWARE CONSIDERATIONS:\n\n");
@@ -1190,7 +5478,7 @@ int main() {
     printf("- Consider NUMA topology for large systems\n\n");
     
     // Run the comprehensive benchmark
-    run_comprehensive_benchmark();
+    int failed = run_comprehensive_benchmark();
     
     printf("\n=== PERFORMANCE PROFILING COMMANDS ===\n");
     printf("To get deeper insights, run these commands:\n\n");
@@ -1249,5 +5537,5 @@ int main() {
     printf("   readelf -A benchmark\n");
     printf("   # Check binary attributes and target architecture\n\n");
     
-    return 0;
+    return failed;
 }
\ No newline at end of file
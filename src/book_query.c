@@ -0,0 +1,268 @@
+// book_query.c
+#include "../include/book_query.h"
+#include "../include/cpu_features.h"
+#include "../include/fixed_point.h"
+
+#if defined(__x86_64__)
+    #include <immintrin.h>
+    #define BOOK_QUERY_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define BOOK_QUERY_NEON
+#endif
+
+// Notionals are summed in ticks * lots, scaled to quote currency at the end
+#define NOTIONAL_SCALE ((double)FIXED_POINT_SCALE * (double)FIXED_POINT_SCALE)
+
+static void fill_result(BookFill* fill, const SideSOA* side, int levels, int64_t filled,
+                        double notional) {
+    fill->filled = filled;
+    fill->notional = notional / NOTIONAL_SCALE;
+    fill->vwap = filled > 0 ? notional / (double)filled / FIXED_POINT_SCALE : 0.0;
+    fill->worst_price = levels > 0 ? side->prices[levels - 1] : 0;
+    fill->levels = levels;
+}
+
+// Scalar walk from level i, with filled lots and notional taken before it.
+// The whole reference, and the end of every vector kernel.
+static int fill_quantity_from(const SideSOA* side, int i, int64_t filled, double notional,
+                              int64_t quantity, BookFill* fill) {
+    for (; i < side->count && filled < quantity; i++) {
+        int64_t take = side->amounts[i] < quantity - filled ? side->amounts[i] : quantity - filled;
+        notional += (double)side->prices[i] * (double)take;
+        filled += take;
+    }
+    fill_result(fill, side, i, filled, notional);
+    return filled >= quantity;
+}
+
+static int fill_notional_from(const SideSOA* side, int i, int64_t filled, double spent,
+                              double target, BookFill* fill) {
+    for (; i < side->count; i++) {
+        double level = (double)side->prices[i] * (double)side->amounts[i];
+        if (spent + level >= target) break;
+        spent += level;
+        filled += side->amounts[i];
+    }
+    if (i == side->count) {
+        fill_result(fill, side, i, filled, spent);
+        return 0;
+    }
+
+    // Level i reaches the target: as many whole lots of it as fit
+    int64_t take = (int64_t)((target - spent) / (double)side->prices[i]);
+    if (take > side->amounts[i]) take = side->amounts[i];
+    if (take > 0) {
+        spent += (double)side->prices[i] * (double)take;
+        filled += take;
+        i++;
+    }
+    fill_result(fill, side, i, filled, spent);
+    return 1;
+}
+
+int book_query_quantity_scalar(const SideSOA* side, int64_t quantity, BookFill* fill) {
+    return fill_quantity_from(side, 0, 0, 0.0, quantity, fill);
+}
+
+int book_query_notional_scalar(const SideSOA* side, double notional, BookFill* fill) {
+    return fill_notional_from(side, 0, 0, 0.0, notional * NOTIONAL_SCALE, fill);
+}
+
+#if defined(BOOK_QUERY_X86)
+
+// Inclusive prefix sum of the 4 lanes: add the vector shifted up one lane,
+// then two lanes
+__attribute__((target("avx2")))
+static inline __m256i prefix_sum_epi64(__m256i x) {
+    __m256i zero = _mm256_setzero_si256();
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(
+        _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(
+        _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+    return x;
+}
+
+__attribute__((target("avx2")))
+static inline __m256d prefix_sum_pd(__m256d x) {
+    __m256d zero = _mm256_setzero_pd();
+    x = _mm256_add_pd(x, _mm256_blend_pd(
+        _mm256_permute4x64_pd(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x1));
+    x = _mm256_add_pd(x, _mm256_blend_pd(
+        _mm256_permute4x64_pd(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x3));
+    return x;
+}
+
+// No int64 -> double before AVX-512: x < 2^52 goes in the mantissa of 2^52,
+// and (2^52 + x) - 2^52 = x exactly
+__attribute__((target("avx2")))
+static inline __m256d int64_to_pd(__m256i x) {
+    __m256d magic = _mm256_set1_pd(4503599627370496.0);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(x, _mm256_castpd_si256(magic))),
+                         magic);
+}
+
+// The running total stays broadcast in a register (carry): the only chain
+// from one block to the next is an add and a lane permute
+__attribute__((target("avx2")))
+static int fill_quantity_avx2(const SideSOA* side, int64_t quantity, BookFill* fill) {
+    __m256i target = _mm256_set1_epi64x(quantity);
+    __m256i carry = _mm256_setzero_si256();
+    __m256d notional = _mm256_setzero_pd();
+    int i = 0;
+
+    for (; i + 4 <= side->count; i += 4) {
+        __m256i amount = _mm256_loadu_si256((const __m256i*)(side->amounts + i));
+        __m256i cumulative = _mm256_add_epi64(prefix_sum_epi64(amount), carry);
+        // Stop at the block where the cumulative amount reaches the target
+        __m256i short_of = _mm256_cmpgt_epi64(target, cumulative);
+        if (_mm256_movemask_pd(_mm256_castsi256_pd(short_of)) != 0xF) break;
+
+        __m256i price = _mm256_loadu_si256((const __m256i*)(side->prices + i));
+        notional = _mm256_add_pd(notional, _mm256_mul_pd(int64_to_pd(price), int64_to_pd(amount)));
+        carry = _mm256_permute4x64_epi64(cumulative, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(notional), _mm256_extractf128_pd(notional, 1));
+    sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+    double spent = _mm_cvtsd_f64(sum);
+    int64_t filled = _mm_cvtsi128_si64(_mm256_castsi256_si128(carry));
+    // The scalar end is SSE code: GCC tail-calls it without clearing the
+    // upper halves, and every SSE instruction then pays for them
+    _mm256_zeroupper();
+    return fill_quantity_from(side, i, filled, spent, quantity, fill);
+}
+
+__attribute__((target("avx2")))
+static int fill_notional_avx2(const SideSOA* side, double notional, BookFill* fill) {
+    double target = notional * NOTIONAL_SCALE;
+    __m256d target4 = _mm256_set1_pd(target);
+    __m256d carry = _mm256_setzero_pd();
+    __m256i filled4 = _mm256_setzero_si256();
+    int i = 0;
+
+    for (; i + 4 <= side->count; i += 4) {
+        __m256i amount = _mm256_loadu_si256((const __m256i*)(side->amounts + i));
+        __m256i price = _mm256_loadu_si256((const __m256i*)(side->prices + i));
+        __m256d level = _mm256_mul_pd(int64_to_pd(price), int64_to_pd(amount));
+        __m256d cumulative = _mm256_add_pd(prefix_sum_pd(level), carry);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(cumulative, target4, _CMP_LT_OQ)) != 0xF) break;
+
+        filled4 = _mm256_add_epi64(filled4, amount);
+        carry = _mm256_permute4x64_pd(cumulative, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    __m128i filled2 = _mm_add_epi64(_mm256_castsi256_si128(filled4),
+                                    _mm256_extracti128_si256(filled4, 1));
+    int64_t filled = _mm_cvtsi128_si64(filled2) + _mm_extract_epi64(filled2, 1);
+    double spent = _mm256_cvtsd_f64(carry);
+    _mm256_zeroupper();
+    return fill_notional_from(side, i, filled, spent, target, fill);
+}
+
+#elif defined(BOOK_QUERY_NEON)
+
+// Inclusive prefix sum of 4 levels held in two registers
+static inline void prefix_sum_s64(int64x2_t* lo, int64x2_t* hi) {
+    int64x2_t zero = vdupq_n_s64(0);
+    *lo = vaddq_s64(*lo, vextq_s64(zero, *lo, 1));
+    *hi = vaddq_s64(*hi, vextq_s64(zero, *hi, 1));
+    *hi = vaddq_s64(*hi, vdupq_laneq_s64(*lo, 1));
+}
+
+static inline void prefix_sum_f64(float64x2_t* lo, float64x2_t* hi) {
+    float64x2_t zero = vdupq_n_f64(0.0);
+    *lo = vaddq_f64(*lo, vextq_f64(zero, *lo, 1));
+    *hi = vaddq_f64(*hi, vextq_f64(zero, *hi, 1));
+    *hi = vaddq_f64(*hi, vdupq_laneq_f64(*lo, 1));
+}
+
+// All lanes of both comparisons set
+static inline int all_set(uint64x2_t lo, uint64x2_t hi) {
+    return vminvq_u32(vreinterpretq_u32_u64(vandq_u64(lo, hi))) == 0xFFFFFFFFu;
+}
+
+static int fill_quantity_neon(const SideSOA* side, int64_t quantity, BookFill* fill) {
+    int64x2_t target = vdupq_n_s64(quantity);
+    float64x2_t notional_lo = vdupq_n_f64(0.0), notional_hi = vdupq_n_f64(0.0);
+    int64_t filled = 0;
+    int i = 0;
+
+    for (; i + 4 <= side->count; i += 4) {
+        int64x2_t amount_lo = vld1q_s64(side->amounts + i);
+        int64x2_t amount_hi = vld1q_s64(side->amounts + i + 2);
+        int64x2_t cumulative_lo = amount_lo, cumulative_hi = amount_hi;
+        prefix_sum_s64(&cumulative_lo, &cumulative_hi);
+        cumulative_lo = vaddq_s64(cumulative_lo, vdupq_n_s64(filled));
+        cumulative_hi = vaddq_s64(cumulative_hi, vdupq_n_s64(filled));
+        // Stop at the block where the cumulative amount reaches the target
+        if (!all_set(vcltq_s64(cumulative_lo, target), vcltq_s64(cumulative_hi, target))) break;
+
+        int64x2_t price_lo = vld1q_s64(side->prices + i);
+        int64x2_t price_hi = vld1q_s64(side->prices + i + 2);
+        notional_lo = vaddq_f64(notional_lo,
+                                vmulq_f64(vcvtq_f64_s64(price_lo), vcvtq_f64_s64(amount_lo)));
+        notional_hi = vaddq_f64(notional_hi,
+                                vmulq_f64(vcvtq_f64_s64(price_hi), vcvtq_f64_s64(amount_hi)));
+        filled = vgetq_lane_s64(cumulative_hi, 1);
+    }
+
+    double notional = vaddvq_f64(vaddq_f64(notional_lo, notional_hi));
+    return fill_quantity_from(side, i, filled, notional, quantity, fill);
+}
+
+static int fill_notional_neon(const SideSOA* side, double notional, BookFill* fill) {
+    double target = notional * NOTIONAL_SCALE;
+    float64x2_t target2 = vdupq_n_f64(target);
+    int64x2_t filled2 = vdupq_n_s64(0);
+    double spent = 0.0;
+    int i = 0;
+
+    for (; i + 4 <= side->count; i += 4) {
+        int64x2_t amount_lo = vld1q_s64(side->amounts + i);
+        int64x2_t amount_hi = vld1q_s64(side->amounts + i + 2);
+        float64x2_t cumulative_lo = vmulq_f64(vcvtq_f64_s64(vld1q_s64(side->prices + i)),
+                                              vcvtq_f64_s64(amount_lo));
+        float64x2_t cumulative_hi = vmulq_f64(vcvtq_f64_s64(vld1q_s64(side->prices + i + 2)),
+                                              vcvtq_f64_s64(amount_hi));
+        prefix_sum_f64(&cumulative_lo, &cumulative_hi);
+        cumulative_lo = vaddq_f64(cumulative_lo, vdupq_n_f64(spent));
+        cumulative_hi = vaddq_f64(cumulative_hi, vdupq_n_f64(spent));
+        if (!all_set(vcltq_f64(cumulative_lo, target2), vcltq_f64(cumulative_hi, target2))) break;
+
+        filled2 = vaddq_s64(filled2, vaddq_s64(amount_lo, amount_hi));
+        spent = vgetq_lane_f64(cumulative_hi, 1);
+    }
+
+    return fill_notional_from(side, i, vaddvq_s64(filled2), spent, target, fill);
+}
+
+#endif
+
+int (*book_query_quantity)(const SideSOA* side, int64_t quantity, BookFill* fill) =
+    book_query_quantity_scalar;
+int (*book_query_notional)(const SideSOA* side, double notional, BookFill* fill) =
+    book_query_notional_scalar;
+static const char* kernel_name = "scalar";
+
+__attribute__((constructor)) static void book_query_bind(void) {
+    const CpuFeatures* cpu = cpu_features();
+
+#if defined(BOOK_QUERY_X86)
+    if (cpu->avx2) {
+        book_query_quantity = fill_quantity_avx2;
+        book_query_notional = fill_notional_avx2;
+        kernel_name = "avx2";
+    }
+#elif defined(BOOK_QUERY_NEON)
+    if (cpu->neon) {
+        book_query_quantity = fill_quantity_neon;
+        book_query_notional = fill_notional_neon;
+        kernel_name = "neon";
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+const char* book_query_kernel(void) { return kernel_name; }
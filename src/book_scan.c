@@ -0,0 +1,64 @@
+// book_scan.c
+#include "../include/book_scan.h"
+#include "../include/cpu_features.h"
+
+int64_t book_scan_depth_c(const int64_t* amounts, int count, int n) {
+    int64_t total = 0;
+    if (n > count) n = count;
+    for (int i = 0; i < n; i++) {
+        total += amounts[i];
+    }
+    return total;
+}
+
+int book_scan_find_c(const int64_t* prices, int count, int64_t price) {
+    for (int i = 0; i < count; i++) {
+        if (prices[i] == price) return i;
+    }
+    return -1;
+}
+
+int64_t book_scan_vwap_c(const int64_t* prices, const int64_t* amounts, int count,
+                         int64_t size, double* notional) {
+    int64_t filled = 0;
+    double total = 0.0;
+    for (int i = 0; i < count && filled < size; i++) {
+        int64_t take = amounts[i] < size - filled ? amounts[i] : size - filled;
+        total += (double)prices[i] * (double)take;
+        filled += take;
+    }
+    *notional = total;
+    return filled;
+}
+
+// The C references until book_scan_bind has looked at the CPU
+int64_t (*book_scan_depth)(const int64_t* amounts, int count, int n) = book_scan_depth_c;
+int (*book_scan_find)(const int64_t* prices, int count, int64_t price) = book_scan_find_c;
+int64_t (*book_scan_vwap)(const int64_t* prices, const int64_t* amounts, int count,
+                          int64_t size, double* notional) = book_scan_vwap_c;
+static const char* kernel_name = "c";
+
+// Runs before main, while the process is still single-threaded
+__attribute__((constructor)) static void book_scan_bind(void) {
+    const CpuFeatures* cpu = cpu_features();
+
+#if defined(__x86_64__)
+    if (cpu->avx2) {
+        book_scan_depth = book_scan_depth_avx2;
+        book_scan_find = book_scan_find_avx2;
+        book_scan_vwap = book_scan_vwap_avx2;
+        kernel_name = "avx2";
+    }
+#elif defined(__aarch64__)
+    if (cpu->neon) {
+        book_scan_depth = book_scan_depth_neon;
+        book_scan_find = book_scan_find_neon;
+        book_scan_vwap = book_scan_vwap_neon;
+        kernel_name = "neon";
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+const char* book_scan_kernel(void) { return kernel_name; }
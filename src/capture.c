@@ -0,0 +1,177 @@
+// capture.c
+#include "../include/capture.h"
+#include "../include/fixed_point.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+uint64_t capture_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int capture_open(CaptureWriter* writer, const char* filename, const char* symbol) {
+    writer->records = 0;
+    writer->file = fopen(filename, "ab+");
+    if (!writer->file) return -1;
+
+    fseek(writer->file, 0, SEEK_END);
+    if (ftell(writer->file) == 0) {
+        CaptureFileHeader header = {0};
+        memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.decimals = FIXED_POINT_DECIMALS;
+        strncpy(header.symbol, symbol, sizeof(header.symbol) - 1);
+
+        if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+            fclose(writer->file);
+            return -1;
+        }
+        return 0;
+    }
+
+    // Existing file: only append to a capture of the same format
+    CaptureFileHeader header;
+    fseek(writer->file, 0, SEEK_SET);
+    if (fread(&header, sizeof(header), 1, writer->file) != 1 ||
+        memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.decimals != FIXED_POINT_DECIMALS) {
+        fclose(writer->file);
+        return -1;
+    }
+    fseek(writer->file, 0, SEEK_END);
+    return 0;
+}
+
+static int write_record(CaptureWriter* writer, CaptureRecordType type, uint64_t recv_time_ns,
+                        uint64_t event_time, uint64_t first_update_id, uint64_t last_update_id,
+                        const DepthLevel* bids, int bid_count,
+                        const DepthLevel* asks, int ask_count) {
+    CaptureRecordHeader header = {0};
+    header.size = sizeof(header) + (bid_count + ask_count) * sizeof(DepthLevel);
+    header.type = type;
+    header.recv_time_ns = recv_time_ns;
+    header.event_time = event_time;
+    header.first_update_id = first_update_id;
+    header.last_update_id = last_update_id;
+    header.bid_count = bid_count;
+    header.ask_count = ask_count;
+
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1 ||
+        fwrite(bids, sizeof(DepthLevel), bid_count, writer->file) != (size_t)bid_count ||
+        fwrite(asks, sizeof(DepthLevel), ask_count, writer->file) != (size_t)ask_count) {
+        return -1;
+    }
+    writer->records++;
+    return 0;
+}
+
+int capture_write_update(CaptureWriter* writer, uint64_t recv_time_ns, const DepthUpdate* update) {
+    return write_record(writer, CAPTURE_DIFF, recv_time_ns, update->event_time,
+                        update->first_update_id, update->last_update_id,
+                        update->bids, update->bid_count, update->asks, update->ask_count);
+}
+
+int capture_write_snapshot(CaptureWriter* writer, uint64_t recv_time_ns, const OrderBook* ob) {
+    // Books can be deeper than MAX_ORDERBOOK_ENTRIES, and snapshots are rare
+    DepthLevel* bids = malloc((ob->bid_count + ob->ask_count + 1) * sizeof(DepthLevel));
+    DepthLevel* asks = bids + ob->bid_count;
+    if (!bids) return -1;
+
+    // Book prices came from fixed-point, so rounding back is exact
+    for (int i = 0; i < ob->bid_count; i++) {
+        bids[i].price = llround(ob->bids[i].price * FIXED_POINT_SCALE);
+        bids[i].amount = llround(ob->bids[i].amount * FIXED_POINT_SCALE);
+    }
+    for (int i = 0; i < ob->ask_count; i++) {
+        asks[i].price = llround(ob->asks[i].price * FIXED_POINT_SCALE);
+        asks[i].amount = llround(ob->asks[i].amount * FIXED_POINT_SCALE);
+    }
+
+    int result = write_record(writer, CAPTURE_SNAPSHOT, recv_time_ns, 0,
+                              ob->last_update_id, ob->last_update_id,
+                              bids, ob->bid_count, asks, ob->ask_count);
+    free(bids);
+    return result;
+}
+
+int capture_close(CaptureWriter* writer) {
+    if (!writer->file) return 0;
+    int result = fclose(writer->file);
+    writer->file = NULL;
+    return result == 0 ? 0 : -1;
+}
+
+int capture_map(CaptureReader* reader, const char* filename) {
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(CaptureFileHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    // Replay walks the file front to back exactly once
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    reader->data = data;
+    reader->size = st.st_size;
+    reader->header = data;
+    reader->offset = sizeof(CaptureFileHeader);
+
+    if (memcmp(reader->header->magic, CAPTURE_MAGIC, sizeof(reader->header->magic)) != 0 ||
+        reader->header->decimals != FIXED_POINT_DECIMALS) {
+        capture_unmap(reader);
+        return -1;
+    }
+    return 0;
+}
+
+int capture_next(CaptureReader* reader, CaptureRecord* record) {
+    size_t remaining = reader->size - reader->offset;
+    if (remaining < sizeof(CaptureRecordHeader)) return 0;
+
+    const CaptureRecordHeader* header = (const CaptureRecordHeader*)(reader->data + reader->offset);
+    // Diffs come from a DepthUpdate; snapshots of deeper books are only
+    // bounded by the 32-bit record size, checked below
+    if (header->type == CAPTURE_DIFF &&
+        (header->bid_count > MAX_ORDERBOOK_ENTRIES || header->ask_count > MAX_ORDERBOOK_ENTRIES)) {
+        return 0;
+    }
+    // Widened before adding, so huge counts cannot wrap to a small size
+    size_t levels_size = ((size_t)header->bid_count + header->ask_count) * sizeof(DepthLevel);
+    if (header->size != sizeof(CaptureRecordHeader) + levels_size || header->size > remaining) {
+        return 0;  // Truncated or corrupt tail
+    }
+
+    record->header = header;
+    record->bids = (const DepthLevel*)(header + 1);
+    record->asks = record->bids + header->bid_count;
+    reader->offset += header->size;
+    return 1;
+}
+
+void capture_rewind(CaptureReader* reader) {
+    reader->offset = sizeof(CaptureFileHeader);
+}
+
+void capture_unmap(CaptureReader* reader) {
+    if (reader->data) {
+        munmap((void*)reader->data, reader->size);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
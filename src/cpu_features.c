@@ -0,0 +1,79 @@
+// cpu_features.c
+#include "../include/cpu_features.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #define CPU_X86
+#elif defined(__aarch64__) && defined(__linux__)
+    #include <sys/auxv.h>
+    #include <asm/hwcap.h>
+#endif
+
+static CpuFeatures features;
+static int probed;
+
+#ifdef CPU_X86
+// XCR0: which register state the OS saves on a context switch
+static uint64_t read_xcr0(void) {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+#endif
+
+static void cpu_features_probe(void) {
+#ifdef CPU_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        features.sse2 = (edx >> 26) & 1;
+
+        uint64_t xcr0 = (ecx >> 27) & 1 ? read_xcr0() : 0;  // OSXSAVE
+        int ymm_saved = (xcr0 & 0x06) == 0x06;               // SSE + AVX state
+        int zmm_saved = (xcr0 & 0xE6) == 0xE6;               // + opmask, ZMM state
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            features.avx2 = ymm_saved && ((ebx >> 5) & 1);
+            features.avx512f = zmm_saved && ((ebx >> 16) & 1);
+        }
+    }
+#elif defined(__aarch64__) && defined(__linux__)
+    features.neon = (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    features.neon = 1;  // Advanced SIMD is part of the AArch64 baseline
+#endif
+
+    const char* cap = getenv("ORDERBOOK_SIMD");
+    if (cap) {
+        if (strcmp(cap, "avx2") == 0) {
+            features.avx512f = 0;
+        } else if (strcmp(cap, "sse2") == 0) {
+            features.avx512f = features.avx2 = 0;
+        } else if (strcmp(cap, "scalar") == 0) {
+            memset(&features, 0, sizeof(features));
+        }
+    }
+    probed = 1;
+}
+
+// Probed before main, while the process is still single-threaded; other
+// load-time binders call cpu_features() and may get here first
+__attribute__((constructor)) static void cpu_features_init(void) {
+    if (!probed) cpu_features_probe();
+}
+
+const CpuFeatures* cpu_features(void) {
+    if (!probed) cpu_features_probe();
+    return &features;
+}
+
+const char* cpu_features_name(void) {
+    const CpuFeatures* f = cpu_features();
+    if (f->avx512f) return "avx512";
+    if (f->avx2) return "avx2";
+    if (f->sse2) return "sse2";
+    if (f->neon) return "neon";
+    return "scalar";
+}
@@ -0,0 +1,168 @@
+// depth_stream.c
+#include "../include/depth_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void depth_stream_init(DepthStream* ds) {
+    memset(ds, 0, sizeof(*ds));
+    ds->state = DEPTH_STREAM_BUFFERING;
+}
+
+static void clear_pending(DepthStream* ds) {
+    for (int i = 0; i < ds->pending_count; i++) {
+        free(ds->pending[i].levels);
+    }
+    ds->pending_count = 0;
+}
+
+void depth_stream_free(DepthStream* ds) {
+    clear_pending(ds);
+    free(ds->pending);
+    ds->pending = NULL;
+}
+
+static int buffer_levels(DepthStream* ds, uint64_t first_update_id, uint64_t last_update_id,
+                         const DepthLevel* bids, int bid_count,
+                         const DepthLevel* asks, int ask_count) {
+    if (ds->pending_count == DEPTH_STREAM_MAX_PENDING) {
+        free(ds->pending[0].levels);
+        memmove(ds->pending, &ds->pending[1], (ds->pending_count - 1) * sizeof(DepthPendingUpdate));
+        ds->pending_count--;
+        ds->dropped++;
+    }
+    if (ds->pending_count == ds->pending_capacity) {
+        int capacity = ds->pending_capacity ? ds->pending_capacity * 2 : 64;
+        DepthPendingUpdate* pending = realloc(ds->pending, capacity * sizeof(DepthPendingUpdate));
+        if (!pending) return 0;
+        ds->pending = pending;
+        ds->pending_capacity = capacity;
+    }
+
+    // Bids followed by asks in one allocation
+    DepthLevel* levels = malloc((bid_count + ask_count + 1) * sizeof(DepthLevel));
+    if (!levels) return 0;
+    memcpy(levels, bids, bid_count * sizeof(DepthLevel));
+    memcpy(levels + bid_count, asks, ask_count * sizeof(DepthLevel));
+
+    DepthPendingUpdate* entry = &ds->pending[ds->pending_count++];
+    entry->first_update_id = first_update_id;
+    entry->last_update_id = last_update_id;
+    entry->levels = levels;
+    entry->bid_count = bid_count;
+    entry->ask_count = ask_count;
+    return 1;
+}
+
+// Sequence check and in-place apply
+static DepthStreamResult apply_levels(DepthStream* ds, uint64_t first_update_id, uint64_t last_update_id,
+                                      const DepthLevel* bids, int bid_count,
+                                      const DepthLevel* asks, int ask_count) {
+    if (last_update_id <= ds->last_update_id) {
+        ds->stale++;
+        return DEPTH_STALE;
+    }
+
+    int in_sequence = ds->awaiting_first_event
+        ? first_update_id <= ds->last_update_id + 1
+        : first_update_id == ds->last_update_id + 1;
+
+    if (!in_sequence) {
+        ds->gaps++;
+        ds->state = DEPTH_STREAM_RESYNC;
+        // Readers must not keep trading on the levels from before the gap
+        if (ds->top) top_of_book_publish_out_of_sync(ds->top, ds->last_update_id);
+        return DEPTH_GAP;
+    }
+
+    for (int i = 0; i < bid_count; i++) {
+        orderbook_apply_level(ds->book, 1, bids[i].price, bids[i].amount);
+    }
+    for (int i = 0; i < ask_count; i++) {
+        orderbook_apply_level(ds->book, 0, asks[i].price, asks[i].amount);
+    }
+    ds->book->last_update_id = last_update_id;
+    ds->last_update_id = last_update_id;
+    ds->awaiting_first_event = 0;
+    ds->applied++;
+    return DEPTH_APPLIED;
+}
+
+int depth_stream_set_snapshot(DepthStream* ds, OrderBook* book) {
+    ds->book = book;
+    ds->last_update_id = book->last_update_id;
+    ds->awaiting_first_event = 1;
+    ds->state = DEPTH_STREAM_LIVE;
+
+    // Replay whatever arrived while we were waiting for the snapshot
+    for (int i = 0; i < ds->pending_count; i++) {
+        DepthPendingUpdate* entry = &ds->pending[i];
+        DepthStreamResult result = apply_levels(ds, entry->first_update_id, entry->last_update_id,
+                                                entry->levels, entry->bid_count,
+                                                entry->levels + entry->bid_count, entry->ask_count);
+
+        if (result == DEPTH_GAP) {
+            // Snapshot is older than the events we kept: keep buffering
+            // from this event on until a newer snapshot arrives
+            for (int j = 0; j < i; j++) {
+                free(ds->pending[j].levels);
+            }
+            memmove(ds->pending, &ds->pending[i],
+                    (ds->pending_count - i) * sizeof(DepthPendingUpdate));
+            ds->pending_count -= i;
+            return 0;
+        }
+    }
+
+    clear_pending(ds);
+    if (ds->top) top_of_book_publish_book(ds->top, ds->book);
+    return 1;
+}
+
+int depth_stream_load_snapshot(DepthStream* ds, OrderBook* book, const char* snapshot_json, size_t len) {
+    if (!parse_orderbook_snapshot_into(book, snapshot_json, len)) {
+        return 0;
+    }
+    return depth_stream_set_snapshot(ds, book);
+}
+
+DepthStreamResult depth_stream_on_levels(DepthStream* ds, uint64_t first_update_id, uint64_t last_update_id,
+                                         const DepthLevel* bids, int bid_count,
+                                         const DepthLevel* asks, int ask_count) {
+    if (ds->state != DEPTH_STREAM_LIVE) {
+        return buffer_levels(ds, first_update_id, last_update_id, bids, bid_count, asks, ask_count)
+            ? DEPTH_BUFFERED : DEPTH_PARSE_ERROR;
+    }
+
+    DepthStreamResult result = apply_levels(ds, first_update_id, last_update_id,
+                                            bids, bid_count, asks, ask_count);
+    if (result == DEPTH_APPLIED && ds->top) {
+        top_of_book_publish_book(ds->top, ds->book);
+    } else if (result == DEPTH_GAP) {
+        // Keep this event, it may be the first one after the next snapshot
+        buffer_levels(ds, first_update_id, last_update_id, bids, bid_count, asks, ask_count);
+    }
+    return result;
+}
+
+DepthStreamResult depth_stream_on_message(DepthStream* ds, const char* msg, size_t len) {
+    // Websocket frames are not NUL-terminated, parse them in place
+    if (!parse_depth_update_n(msg, len, &ds->update)) {
+        return DEPTH_PARSE_ERROR;
+    }
+
+    return depth_stream_on_levels(ds, ds->update.first_update_id, ds->update.last_update_id,
+                                  ds->update.bids, ds->update.bid_count,
+                                  ds->update.asks, ds->update.ask_count);
+}
+
+const char* depth_stream_result_name(DepthStreamResult result) {
+    switch (result) {
+    case DEPTH_APPLIED:     return "applied";
+    case DEPTH_BUFFERED:    return "buffered";
+    case DEPTH_STALE:       return "stale";
+    case DEPTH_GAP:         return "gap";
+    case DEPTH_PARSE_ERROR: return "parse error";
+    }
+    return "unknown";
+}
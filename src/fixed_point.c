@@ -0,0 +1,113 @@
+// fixed_point.c
+#include "../include/fixed_point.h"
+#include <string.h>
+
+// The SWAR path reads 8 characters as one little-endian word
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define FIXED_POINT_SWAR
+#endif
+
+// Max integer digits so that int_part * 1e8 + 99999999 fits in int64
+#define MAX_INTEGER_DIGITS 10
+
+int parse_fixed_point_scalar(const char* start, const char* end, int64_t* out) {
+    const char* ptr = start;
+    int64_t integer_part = 0;
+    int64_t fraction_part = 0;
+    int integer_digits = 0;
+    int fraction_digits = 0;
+
+    while (ptr < end && *ptr >= '0' && *ptr <= '9') {
+        if (++integer_digits > MAX_INTEGER_DIGITS) return 0;
+        integer_part = integer_part * 10 + (*ptr - '0');
+        ptr++;
+    }
+
+    if (ptr < end && *ptr == '.') {
+        ptr++;
+        while (ptr < end && *ptr >= '0' && *ptr <= '9') {
+            if (++fraction_digits > FIXED_POINT_DECIMALS) return 0;
+            fraction_part = fraction_part * 10 + (*ptr - '0');
+            ptr++;
+        }
+    }
+
+    if (ptr != end || integer_digits + fraction_digits == 0) return 0;
+
+    // Pad the fraction to 8 digits: "1.2" -> 20000000
+    for (int i = fraction_digits; i < FIXED_POINT_DECIMALS; i++) {
+        fraction_part *= 10;
+    }
+
+    *out = integer_part * FIXED_POINT_SCALE + fraction_part;
+    return 1;
+}
+
+#ifdef FIXED_POINT_SWAR
+
+static inline uint64_t load_u64(const char* ptr) {
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+// All 8 bytes are in '0'..'9': high nibble is 3 and adding 6 does not carry
+static inline int swar_is_eight_digits(uint64_t chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+           == 0x3333333333333333ULL;
+}
+
+// Fold 8 ASCII digits (first digit in the lowest byte) into their value:
+// pairs of digits, then pairs of pairs, then the two 4-digit halves
+static inline uint32_t swar_parse_eight_digits(uint64_t chunk) {
+    chunk = (chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    chunk = (chunk & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return (uint32_t)((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32);
+}
+
+// Index of the first '.' in the word, 8 if there is none
+static inline int swar_find_dot(uint64_t chunk) {
+    uint64_t x = chunk ^ 0x2E2E2E2E2E2E2E2EULL;
+    uint64_t found = (x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL;
+    return found ? __builtin_ctzll(found) >> 3 : 8;
+}
+
+int parse_fixed_point(const char* start, const char* end, int64_t* out) {
+    long len = end - start;
+
+    // Fast path: 1-8 integer digits, a dot and exactly 8 decimals
+    if (len >= 10 && len <= 17) {
+        uint64_t head = load_u64(start);
+        int dot = swar_find_dot(head);
+
+        // dot == 8 only means none in the first word: check the ninth byte
+        if (dot >= 1 && start[dot] == '.' && len - dot - 1 == FIXED_POINT_DECIMALS) {
+            uint64_t fraction = load_u64(start + dot + 1);
+
+            // Shift the integer digits to the top of the word and fill the
+            // bottom with '0' so "118728" becomes "00118728"
+            int shift = (8 - dot) * 8;
+            uint64_t integer = head;
+            if (shift) {
+                integer = (head << shift) | (0x3030303030303030ULL >> (64 - shift));
+            }
+
+            if (swar_is_eight_digits(integer) && swar_is_eight_digits(fraction)) {
+                *out = (int64_t)swar_parse_eight_digits(integer) * FIXED_POINT_SCALE +
+                       swar_parse_eight_digits(fraction);
+                return 1;
+            }
+        }
+    }
+
+    return parse_fixed_point_scalar(start, end, out);
+}
+
+#else
+
+int parse_fixed_point(const char* start, const char* end, int64_t* out) {
+    return parse_fixed_point_scalar(start, end, out);
+}
+
+#endif
@@ -2,6 +2,11 @@
 #include "../include/json_loader.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 char* load_json_file(const char* filename) {
     FILE* file = fopen(filename, "rb");
@@ -32,3 +37,118 @@ char* load_json_file(const char* filename) {
 void free_json_data(char* data) {
     free(data);
 }
+
+int map_json_file(const char* filename, MappedJson* mapped) {
+    mapped->data = NULL;
+    mapped->size = 0;
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;      // fault everything in now, not during parsing
+#endif
+    void* data = mmap(NULL, st.st_size, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+    
+#ifdef MADV_HUGEPAGE
+    // Only honoured where the filesystem supports huge page cache (e.g. tmpfs)
+    madvise(data, st.st_size, MADV_HUGEPAGE);
+#endif
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    
+    mapped->data = data;
+    mapped->size = st.st_size;
+    return 0;
+}
+
+void unmap_json_file(MappedJson* mapped) {
+    if (mapped->data) {
+        munmap((void*)mapped->data, mapped->size);
+    }
+    mapped->data = NULL;
+    mapped->size = 0;
+}
+
+long stream_json_lines(const char* filename, size_t chunk_size,
+                       json_line_callback callback, void* user) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    
+    size_t capacity = chunk_size;
+    char* buffer = malloc(capacity);
+    if (!buffer) {
+        close(fd);
+        return -1;
+    }
+    
+    size_t used = 0;    // bytes in buffer, a partial line carried over
+    long lines = 0;
+    int stop = 0;
+    
+    while (!stop) {
+        // A single line longer than the buffer: grow it
+        if (used == capacity) {
+            char* bigger = realloc(buffer, capacity * 2);
+            if (!bigger) {
+                lines = -1;
+                break;
+            }
+            buffer = bigger;
+            capacity *= 2;
+        }
+        
+        ssize_t n = read(fd, buffer + used, capacity - used);
+        if (n < 0) {
+            lines = -1;
+            break;
+        }
+        
+        size_t available = used + n;
+        size_t offset = 0;
+        
+        for (;;) {
+            char* newline = memchr(buffer + offset, '\n', available - offset);
+            if (!newline) break;
+            
+            size_t len = newline - (buffer + offset);
+            if (len > 0) {
+                lines++;
+                if (callback(buffer + offset, len, user)) {
+                    stop = 1;
+                    break;
+                }
+            }
+            offset += len + 1;
+        }
+        
+        if (n == 0) {
+            // End of file: last line may not have a trailing newline
+            if (!stop && available > offset) {
+                lines++;
+                callback(buffer + offset, available - offset, user);
+            }
+            break;
+        }
+        
+        // Carry the partial line to the front of the buffer
+        used = available - offset;
+        memmove(buffer, buffer + offset, used);
+    }
+    
+    free(buffer);
+    close(fd);
+    return lines;
+}
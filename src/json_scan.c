@@ -0,0 +1,146 @@
+// json_scan.c
+#include "../include/json_scan.h"
+#include "../include/cpu_features.h"
+
+// Every x86 kernel is compiled in (AVX2 through a target attribute, without
+// -mavx2) and the best one the CPU runs is bound at load time
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define JSON_SCAN_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define JSON_SCAN_NEON
+#endif
+
+// '[' ']' '{' '}' only differ in bit 5, so OR-ing 0x20 folds each bracket
+// pair into one compare: 5 compares cover the 7 structural characters
+static inline int is_structural(unsigned char c) {
+    unsigned char folded = c | 0x20;
+    return c == '"' || c == ',' || c == ':' || folded == '{' || folded == '}';
+}
+
+uint64_t json_structural_mask_scalar(const char* p, int len) {
+    uint64_t mask = 0;
+    for (int i = 0; i < len; i++) {
+        mask |= (uint64_t)is_structural((unsigned char)p[i]) << i;
+    }
+    return mask;
+}
+
+static uint64_t structural_mask_scalar(const char* p) {
+    return json_structural_mask_scalar(p, JSON_SCAN_BLOCK);
+}
+
+#if defined(JSON_SCAN_X86)
+
+__attribute__((target("avx2")))
+static inline uint32_t structural_mask_32(const char* p) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+    __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+
+    __m256i hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                                        _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')))));
+    return (uint32_t)_mm256_movemask_epi8(hits);
+}
+
+__attribute__((target("avx2")))
+static uint64_t structural_mask_avx2(const char* p) {
+    return (uint64_t)structural_mask_32(p) | ((uint64_t)structural_mask_32(p + 32) << 32);
+}
+
+#ifdef __SSE2__
+static inline uint64_t structural_mask_16(const char* p) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+    __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+
+    __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                     _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                                  _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')))));
+    return (uint16_t)_mm_movemask_epi8(hits);
+}
+
+static uint64_t structural_mask_sse2(const char* p) {
+    return structural_mask_16(p) | (structural_mask_16(p + 16) << 16) |
+           (structural_mask_16(p + 32) << 32) | (structural_mask_16(p + 48) << 48);
+}
+#endif
+
+#elif defined(JSON_SCAN_NEON)
+
+static inline uint8x16_t structural_bytes_16(const char* p) {
+    uint8x16_t chunk = vld1q_u8((const uint8_t*)p);
+    uint8x16_t folded = vorrq_u8(chunk, vdupq_n_u8(0x20));
+
+    return vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('"')),
+                             vceqq_u8(chunk, vdupq_n_u8(','))),
+                    vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(':')),
+                             vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')),
+                                      vceqq_u8(folded, vdupq_n_u8('}')))));
+}
+
+// NEON has no movemask: keep one weight bit per byte, then pairwise-add
+// the four 16-byte results down to 64 bits (same trick as simdjson)
+static uint64_t structural_mask_neon(const char* p) {
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128,
+                                         1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t bit = vld1q_u8(weights);
+
+    uint8x16_t m0 = vandq_u8(structural_bytes_16(p), bit);
+    uint8x16_t m1 = vandq_u8(structural_bytes_16(p + 16), bit);
+    uint8x16_t m2 = vandq_u8(structural_bytes_16(p + 32), bit);
+    uint8x16_t m3 = vandq_u8(structural_bytes_16(p + 48), bit);
+
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(m0, m1), vpaddq_u8(m2, m3));
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+
+#endif
+
+// The baseline kernel until json_scan_bind has looked at the CPU
+#if defined(JSON_SCAN_NEON)
+uint64_t (*json_structural_mask)(const char* p) = structural_mask_neon;
+static const char* kernel_name = "neon";
+#elif defined(__SSE2__)
+uint64_t (*json_structural_mask)(const char* p) = structural_mask_sse2;
+static const char* kernel_name = "sse2";
+#else
+uint64_t (*json_structural_mask)(const char* p) = structural_mask_scalar;
+static const char* kernel_name = "scalar";
+#endif
+
+// Runs before main, while the process is still single-threaded
+__attribute__((constructor)) static void json_scan_bind(void) {
+    const CpuFeatures* cpu = cpu_features();
+
+    json_structural_mask = structural_mask_scalar;
+    kernel_name = "scalar";
+#if defined(JSON_SCAN_X86)
+#ifdef __SSE2__
+    if (cpu->sse2) {
+        json_structural_mask = structural_mask_sse2;
+        kernel_name = "sse2";
+    }
+#endif
+    if (cpu->avx2) {
+        json_structural_mask = structural_mask_avx2;
+        kernel_name = "avx2";
+    }
+#elif defined(JSON_SCAN_NEON)
+    if (cpu->neon) {
+        json_structural_mask = structural_mask_neon;
+        kernel_name = "neon";
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+const char* json_scan_kernel(void) { return kernel_name; }
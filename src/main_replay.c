@@ -0,0 +1,343 @@
+/*  main_replay.c
+ *
+ *  Replays a binary depth capture (see include/capture.h) into the book,
+ *  through the same lastUpdateId sequencing as the live diff stream.
+ *
+ *  Run:
+ *      ./main_replay capture.bin               # as fast as possible
+ *      ./main_replay capture.bin --paced [x]   # recorded pacing, x times faster
+ *      ./main_replay --import snapshot.json capture.bin
+ *                                              # append a JSON snapshot
+ *      ./main_replay --import-ndjson events.ndjson capture.bin
+ *                                              # append raw diff events,
+ *                                              # one websocket message per line
+ *      ./main_replay capture.bin --top-readers n
+ *                                              # seqlock top-of-book benchmark:
+ *                                              # replay cost of publishing, and
+ *                                              # read latency with n reader threads
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../include/orderbook.h"
+#include "../include/depth_stream.h"
+#include "../include/capture.h"
+#include "../include/json_loader.h"
+#include "../include/top_of_book.h"
+
+static OrderBook replay_book;
+static DepthStream depth_stream;
+static TopOfBook replay_top;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline) {
+    struct timespec ts = {
+        .tv_sec = deadline / 1000000000ULL,
+        .tv_nsec = deadline % 1000000000ULL,
+    };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static int import_snapshot(const char* json_file, const char* capture_file) {
+    char* json_data = load_json_file(json_file);
+    if (!json_data) {
+        fprintf(stderr, "Failed to load %s\n", json_file);
+        return 1;
+    }
+
+    CaptureWriter writer;
+    if (capture_open(&writer, capture_file, "BTCUSDT") != 0) {
+        fprintf(stderr, "Failed to open capture %s\n", capture_file);
+        free_json_data(json_data);
+        return 1;
+    }
+
+    OrderBook* ob = parse_orderbook_snapshot(json_data);
+    int result = capture_write_snapshot(&writer, capture_now_ns(), ob);
+    capture_close(&writer);
+    free_json_data(json_data);
+
+    printf("Appended snapshot lastUpdateId=%llu (bids: %d asks: %d) to %s\n",
+           (unsigned long long)ob->last_update_id, ob->bid_count, ob->ask_count, capture_file);
+    return result != 0;
+}
+
+typedef struct {
+    CaptureWriter writer;
+    DepthUpdate update;
+    long skipped;
+} NdjsonImport;
+
+static int import_ndjson_line(const char* line, size_t len, void* user) {
+    NdjsonImport* import = user;
+
+    if (!parse_depth_update_n(line, len, &import->update)) {
+        import->skipped++;
+        return 0;
+    }
+    // Raw logs carry no receive time, use the exchange event time instead
+    capture_write_update(&import->writer, import->update.event_time * 1000000ULL, &import->update);
+    return 0;
+}
+
+static int import_ndjson(const char* ndjson_file, const char* capture_file) {
+    static NdjsonImport import;
+
+    if (capture_open(&import.writer, capture_file, "BTCUSDT") != 0) {
+        fprintf(stderr, "Failed to open capture %s\n", capture_file);
+        return 1;
+    }
+
+    long lines = stream_json_lines(ndjson_file, JSON_STREAM_CHUNK_SIZE, import_ndjson_line, &import);
+    capture_close(&import.writer);
+    if (lines < 0) {
+        fprintf(stderr, "Failed to read %s\n", ndjson_file);
+        return 1;
+    }
+
+    printf("Appended %llu diff events from %ld lines (%ld skipped) to %s\n",
+           (unsigned long long)import.writer.records, lines, import.skipped, capture_file);
+    return 0;
+}
+
+typedef struct {
+    uint64_t records;
+    uint64_t levels;
+    uint64_t snapshots;
+    double elapsed;
+} ReplayStats;
+
+// Replay the whole capture into a fresh book, publishing the top levels to
+// top after every applied event when it is set
+static void replay_capture(CaptureReader* reader, int paced, double speed, TopOfBook* top,
+                           ReplayStats* stats) {
+    depth_stream_free(&depth_stream);
+    depth_stream_init(&depth_stream);
+    depth_stream.top = top;
+    capture_rewind(reader);
+
+    CaptureRecord record;
+    uint64_t records = 0, levels = 0, snapshots = 0;
+    uint64_t first_recv_ns = 0;
+    uint64_t start = monotonic_ns();
+
+    while (capture_next(reader, &record)) {
+        const CaptureRecordHeader* h = record.header;
+
+        if (paced) {
+            if (records == 0) first_recv_ns = h->recv_time_ns;
+            // recv_time_ns is CLOCK_REALTIME: after an NTP step back (or in
+            // merged captures) a record can be older than the first one
+            uint64_t offset = h->recv_time_ns > first_recv_ns ? h->recv_time_ns - first_recv_ns : 0;
+            sleep_until_ns(start + (uint64_t)(offset / speed));
+        }
+
+        if (h->type == CAPTURE_SNAPSHOT) {
+            orderbook_load_levels(&replay_book, h->last_update_id,
+                                  record.bids, h->bid_count, record.asks, h->ask_count);
+            if (!depth_stream_set_snapshot(&depth_stream, &replay_book)) {
+                printf("Snapshot lastUpdateId=%llu is older than the buffered events\n",
+                       (unsigned long long)h->last_update_id);
+            }
+            snapshots++;
+        } else if (h->type == CAPTURE_DIFF) {
+            DepthStreamResult result = depth_stream_on_levels(&depth_stream,
+                                                              h->first_update_id, h->last_update_id,
+                                                              record.bids, h->bid_count,
+                                                              record.asks, h->ask_count);
+            if (result == DEPTH_GAP) {
+                printf("Sequence gap at U=%llu (expected %llu)\n",
+                       (unsigned long long)h->first_update_id,
+                       (unsigned long long)depth_stream.last_update_id + 1);
+            }
+        }
+
+        records++;
+        levels += h->bid_count + h->ask_count;
+    }
+
+    stats->records = records;
+    stats->levels = levels;
+    stats->snapshots = snapshots;
+    stats->elapsed = (monotonic_ns() - start) / 1e9;
+}
+
+// Top-of-book readers: copy the snapshot in a loop until the replay ends,
+// timing every 16th read
+#define TOP_SAMPLE_EVERY 16
+#define TOP_MAX_SAMPLES (1 << 20)
+#define TOP_MAX_READERS 64
+
+typedef struct {
+    _Atomic int* done;
+    uint64_t reads;
+    uint64_t attempts;
+    uint32_t* samples;          // ns per sampled read
+    int sample_count;
+    double checksum;            // keeps the copies from being optimized out
+} TopReader;
+
+static void* top_reader(void* arg) {
+    TopReader* r = arg;
+    TopOfBookSnapshot snapshot;
+
+    while (!atomic_load_explicit(r->done, memory_order_relaxed)) {
+        if (r->reads % TOP_SAMPLE_EVERY == 0 && r->sample_count < TOP_MAX_SAMPLES) {
+            uint64_t t0 = monotonic_ns();
+            r->attempts += top_of_book_read(&replay_top, &snapshot);
+            r->samples[r->sample_count++] = (uint32_t)(monotonic_ns() - t0);
+        } else {
+            r->attempts += top_of_book_read(&replay_top, &snapshot);
+        }
+        r->checksum += snapshot.bids[0].price;
+        r->reads++;
+    }
+    return NULL;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Writer overhead: replay without publishing, publishing with no readers,
+// then publishing with reader_count threads reading; read latency percentiles
+static int run_top_of_book_benchmark(CaptureReader* reader, int reader_count) {
+    if (reader_count < 1) reader_count = 1;
+    if (reader_count > TOP_MAX_READERS) reader_count = TOP_MAX_READERS;
+
+    ReplayStats plain, published, contended;
+    replay_capture(reader, 0, 1.0, NULL, &plain);
+    top_of_book_init(&replay_top);
+    replay_capture(reader, 0, 1.0, &replay_top, &published);
+
+    static TopReader readers[TOP_MAX_READERS];
+    pthread_t ids[TOP_MAX_READERS];
+    _Atomic int done = 0;
+    for (int i = 0; i < reader_count; i++) {
+        memset(&readers[i], 0, sizeof(TopReader));
+        readers[i].done = &done;
+        readers[i].samples = malloc(TOP_MAX_SAMPLES * sizeof(uint32_t));
+        pthread_create(&ids[i], NULL, top_reader, &readers[i]);
+    }
+    replay_capture(reader, 0, 1.0, &replay_top, &contended);
+    atomic_store(&done, 1);
+
+    uint64_t reads = 0, attempts = 0;
+    int sample_count = 0;
+    uint32_t* samples = malloc((size_t)reader_count * TOP_MAX_SAMPLES * sizeof(uint32_t));
+    for (int i = 0; i < reader_count; i++) {
+        pthread_join(ids[i], NULL);
+        reads += readers[i].reads;
+        attempts += readers[i].attempts;
+        memcpy(samples + sample_count, readers[i].samples, readers[i].sample_count * sizeof(uint32_t));
+        sample_count += readers[i].sample_count;
+        free(readers[i].samples);
+    }
+
+    double per_event = 1e9 / published.records;
+    printf("Top-of-book (%d levels, %zu bytes) over %llu records\n", TOP_OF_BOOK_LEVELS,
+           sizeof(TopOfBook), (unsigned long long)published.records);
+    printf("  replay, no publish:          %8.3f s (%.0f ns/record)\n", plain.elapsed,
+           plain.elapsed * per_event);
+    printf("  replay + publish, 0 readers: %8.3f s (%.0f ns/record)\n", published.elapsed,
+           published.elapsed * per_event);
+    printf("  replay + publish, %d readers: %7.3f s (%.0f ns/record)\n", reader_count,
+           contended.elapsed, contended.elapsed * per_event);
+
+    if (sample_count > 0) {
+        qsort(samples, sample_count, sizeof(uint32_t), compare_u32);
+        printf("  reads: %llu (%.1f M/s), %.4f attempts/read\n", (unsigned long long)reads,
+               reads / contended.elapsed / 1e6, (double)attempts / reads);
+        printf("  read latency ns (incl. clock): p50 %u p99 %u p99.9 %u max %u\n",
+               samples[sample_count / 2], samples[(int)(sample_count * 0.99)],
+               samples[(int)(sample_count * 0.999)], samples[sample_count - 1]);
+    }
+    free(samples);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && strcmp(argv[1], "--import") == 0) {
+        return import_snapshot(argv[2], argv[3]);
+    }
+    if (argc == 4 && strcmp(argv[1], "--import-ndjson") == 0) {
+        return import_ndjson(argv[2], argv[3]);
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s capture.bin [--paced [speed]]\n"
+                        "       %s --import snapshot.json capture.bin\n"
+                        "       %s --import-ndjson events.ndjson capture.bin\n"
+                        "       %s capture.bin --top-readers n\n",
+                argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    CaptureReader reader;
+    if (argc > 2 && strcmp(argv[2], "--top-readers") == 0) {
+        if (capture_map(&reader, argv[1]) != 0) {
+            fprintf(stderr, "Failed to map capture %s\n", argv[1]);
+            return 1;
+        }
+        int result = run_top_of_book_benchmark(&reader, argc > 3 ? atoi(argv[3]) : 1);
+        depth_stream_free(&depth_stream);
+        capture_unmap(&reader);
+        return result;
+    }
+
+    int paced = argc > 2 && strcmp(argv[2], "--paced") == 0;
+    double speed = (paced && argc > 3) ? atof(argv[3]) : 1.0;
+    if (speed <= 0) speed = 1.0;
+
+    if (capture_map(&reader, argv[1]) != 0) {
+        fprintf(stderr, "Failed to map capture %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("Replaying %s (%s, %zu bytes) %s\n", argv[1], reader.header->symbol, reader.size,
+           paced ? "at recorded pacing" : "at maximum speed");
+
+    ReplayStats stats;
+    top_of_book_init(&replay_top);
+    replay_capture(&reader, paced, speed, &replay_top, &stats);
+    double elapsed = stats.elapsed;
+    uint64_t records = stats.records, levels = stats.levels, snapshots = stats.snapshots;
+
+
+    printf("Records: %llu (snapshots: %llu) levels: %llu in %.3f s\n",
+           (unsigned long long)records, (unsigned long long)snapshots,
+           (unsigned long long)levels, elapsed);
+    if (elapsed > 0) {
+        printf("Throughput: %.0f records/s, %.0f levels/s\n", records / elapsed, levels / elapsed);
+    }
+    printf("Applied: %llu stale: %llu gaps: %llu\n",
+           (unsigned long long)depth_stream.applied, (unsigned long long)depth_stream.stale,
+           (unsigned long long)depth_stream.gaps);
+
+    if (depth_stream.book) {
+        OrderBook* ob = depth_stream.book;
+        printf("Final book u=%llu bids: %d asks: %d\n",
+               (unsigned long long)ob->last_update_id, ob->bid_count, ob->ask_count);
+        // Read back through the published top, as a strategy thread would
+        TopOfBookSnapshot top;
+        top_of_book_read(&replay_top, &top);
+        if (top.in_sync && top.bid_count && top.ask_count) {
+            printf("Best bid %.8f x %.8f | best ask %.8f x %.8f\n",
+                   top.bids[0].price, top.bids[0].amount, top.asks[0].price, top.asks[0].amount);
+        }
+    }
+
+    depth_stream_free(&depth_stream);
+    capture_unmap(&reader);
+    return 0;
+}
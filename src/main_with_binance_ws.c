@@ -23,6 +23,14 @@
 #include <time.h>
 
 #include "../include/orderbook.h"
+#include "../include/depth_stream.h"
+#include "../include/json_loader.h"
+#include "../include/capture.h"
+#include "../include/top_of_book.h"
+
+#define DEFAULT_SNAPSHOT_FILE "data/BTCUSDT.depth_20250810.json"
+// Diff events buffered before the snapshot is loaded and replayed
+#define SNAPSHOT_AFTER_MESSAGES 10
 
 void log_ms(const char *fmt, ...) {
     struct timespec ts;
@@ -50,11 +58,14 @@ void log_ms(const char *fmt, ...) {
     printf("%s", final_buffer);
 }
 
+static OrderBook snapshot_book;  /* snapshot mode: rebuilt from every message */
+static OrderBook diff_book;      /* diff mode: REST snapshot + applied deltas */
+
 int
-orderbook_update(const char* depth_json) {
+orderbook_update(const char* depth_json, size_t len) {
 //    log_ms("<<< Orderbook update %s\n ", (char *)depth_json);
-    OrderBook* ob = parse_orderbook_snapshot(depth_json);
-    if (ob) {
+    OrderBook* ob = &snapshot_book;
+    if (parse_orderbook_snapshot_into(ob, depth_json, len)) {
         print_orderbook(ob);
         free_orderbook(ob);
         return 0;
@@ -66,6 +77,67 @@ orderbook_update(const char* depth_json) {
 /* ------------------------------------------------------------------ */
 /*  Global state                                                      */
 static int msg_count = 0;
+static int diff_mode = 0;
+static const char* snapshot_file = DEFAULT_SNAPSHOT_FILE;
+static DepthStream depth_stream;
+static CaptureWriter capture;     /* optional recording of the diff stream */
+static TopOfBook top_of_book;     /* top levels for strategy threads, published per event */
+static int buffered_since_snapshot; /* messages received while not live */
+
+/* Diff-depth mode: keep one persistent book and apply U/u-sequenced deltas */
+int
+orderbook_diff_update(const char* msg, size_t len) {
+    uint64_t recv_time_ns = capture_now_ns();
+    DepthStreamResult result = depth_stream_on_message(&depth_stream, msg, len);
+
+    if (capture.file && result != DEPTH_PARSE_ERROR) {
+        capture_write_update(&capture, recv_time_ns, &depth_stream.update);
+    }
+
+    // First snapshot, or a new one after a gap (RESYNC); while a snapshot is
+    // older than the buffered events, retry every SNAPSHOT_AFTER_MESSAGES
+    if (depth_stream.state != DEPTH_STREAM_LIVE) {
+        buffered_since_snapshot++;
+    }
+    if (depth_stream.state != DEPTH_STREAM_LIVE &&
+        buffered_since_snapshot >= SNAPSHOT_AFTER_MESSAGES) {
+        buffered_since_snapshot = 0;
+        char* json_data = load_json_file(snapshot_file);
+        if (!json_data) {
+            printf("Failed to load snapshot %s\n", snapshot_file);
+            return 1;
+        }
+        OrderBook* snapshot = &diff_book;
+        int parsed = parse_orderbook_snapshot_into(snapshot, json_data, strlen(json_data));
+        free_json_data(json_data);
+        if (!parsed) {
+            printf("Failed to parse snapshot %s\n", snapshot_file);
+            return 1;
+        }
+        if (capture.file) {
+            capture_write_snapshot(&capture, capture_now_ns(), snapshot);
+        }
+        int live = depth_stream_set_snapshot(&depth_stream, snapshot);
+        log_ms("Snapshot lastUpdateId=%llu loaded, %s (applied=%llu stale=%llu)\n",
+               (unsigned long long)depth_stream.book->last_update_id,
+               live ? "stream is live" : "snapshot older than buffered events, need a newer one",
+               (unsigned long long)depth_stream.applied,
+               (unsigned long long)depth_stream.stale);
+        return live ? 0 : 1;
+    }
+
+    if (result == DEPTH_APPLIED) {
+        OrderBook* ob = depth_stream.book;
+        log_ms("u=%llu bids=%d asks=%d best bid %.8f best ask %.8f\n",
+               (unsigned long long)depth_stream.last_update_id,
+               ob->bid_count, ob->ask_count,
+               ob->bid_count ? ob->bids[0].price : 0.0,
+               ob->ask_count ? ob->asks[0].price : 0.0);
+    } else if (result != DEPTH_BUFFERED) {
+        log_ms("Diff event %s (state=%d)\n", depth_stream_result_name(result), depth_stream.state);
+    }
+    return result == DEPTH_PARSE_ERROR;
+}
 
 /* ------------------------------------------------------------------ */
 /*  Callback – called by libwebsockets for every event on the socket. */
@@ -87,9 +159,13 @@ callback_binance(struct lws *wsi,
     case LWS_CALLBACK_CLIENT_RECEIVE:
         {
             /* The payload is in 'in', length 'len' */
-            log_ms("<<< %.*s\n", (int)len, (char *)in);
             msg_count++;
-            orderbook_update((char *)in);
+            if (diff_mode) {
+                orderbook_diff_update((const char *)in, len);
+            } else {
+                log_ms("<<< %.*s\n", (int)len, (char *)in);
+                orderbook_update((const char *)in, len);
+            }
         }
         break;
 
@@ -139,15 +215,30 @@ sigint_handler(int sig)
 {
     (void)sig;
     printf("\nInterrupted – shutting down.\n");
+    capture_close(&capture);
     exit(0);
 }
 
 
 /* ------------------------------------------------------------------ */
-int main(void)
+int main(int argc, char **argv)
 {
     signal(SIGINT, sigint_handler);
 
+    /* ./main_with_ws diff [snapshot.json] [capture.bin] - incremental diff-depth
+     * mode, optionally recording every decoded event to a capture file */
+    if (argc > 1 && strcmp(argv[1], "diff") == 0) {
+        diff_mode = 1;
+        if (argc > 2) snapshot_file = argv[2];
+        if (argc > 3 && capture_open(&capture, argv[3], "BTCUSDT") != 0) {
+            fprintf(stderr, "Failed to open capture %s\n", argv[3]);
+            return 1;
+        }
+        depth_stream_init(&depth_stream);
+        top_of_book_init(&top_of_book);
+        depth_stream.top = &top_of_book;
+    }
+
     //FOr additional debugging
     // lws_set_log_level(LLL_USER | LLL_ERR | LLL_WARN | LLL_NOTICE | LLL_INFO | LLL_DEBUG, NULL);
 
@@ -174,7 +265,7 @@ int main(void)
     ccinfo.context = context;
     ccinfo.address = "stream.binance.com";
     ccinfo.port = 9443;
-    ccinfo.path = "/ws/btcusdt@depth5";
+    ccinfo.path = diff_mode ? "/ws/btcusdt@depth@100ms" : "/ws/btcusdt@depth5";
     ccinfo.host = url;
     ccinfo.origin = url;
     ccinfo.protocol = protocols[0].name;
@@ -1,23 +1,138 @@
+#define _GNU_SOURCE  // pthread_setaffinity_np
 #include "../include/orderbook.h"
 #include "../include/json_loader.h"
+#include "../include/fixed_point.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
 
+// Usage: ./main_with_json [snapshot.json] [threads]
+// With a thread count, every thread parses the snapshot into its own SOA
+// book (one book per symbol, one symbol per core) to check the parser scales.
 
-int main() {
+#define PARSES_PER_THREAD 200
+
+typedef struct {
+    const MappedJson* json;
+    int cpu;
+    Arena arena;                // thread-local storage for the book
+    OrderBookSOA book_soa;
+    double elapsed;
+    int failed;
+} ParseThread;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* parse_thread(void* arg) {
+    ParseThread* t = arg;
+
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(t->cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+
+    double start = now_seconds();
+    for (int i = 0; i < PARSES_PER_THREAD; i++) {
+        if (!parse_orderbook_snapshot_soa_into(&t->book_soa, t->json->data, t->json->size)) {
+            t->failed++;
+        }
+    }
+    t->elapsed = now_seconds() - start;
+    return NULL;
+}
+
+static int run_parallel_parse(const MappedJson* json, int thread_count) {
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    ParseThread* threads = calloc(thread_count, sizeof(ParseThread));
+    pthread_t* ids = calloc(thread_count, sizeof(pthread_t));
+    if (!threads || !ids) return 1;
+
+    for (int i = 0; i < thread_count; i++) {
+        threads[i].json = json;
+        threads[i].cpu = cpu_count > 0 ? i % cpu_count : 0;
+        arena_init(&threads[i].arena, 0);
+        orderbook_soa_init(&threads[i].book_soa, &threads[i].arena, 0);
+    }
+
+    printf("Parsing with %d threads (%ld cpus), %d parses each...\n",
+           thread_count, cpu_count, PARSES_PER_THREAD);
+    double start = now_seconds();
+    for (int i = 0; i < thread_count; i++) {
+        pthread_create(&ids[i], NULL, parse_thread, &threads[i]);
+    }
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = now_seconds() - start;
+
+    // Every thread's book must match the reference AoS parse
+    OrderBook* reference = parse_orderbook_snapshot_n(json->data, json->size);
+    int failed = 0;
+    for (int i = 0; i < thread_count; i++) {
+        ParseThread* t = &threads[i];
+        printf("  thread %2d cpu %2d: %.1f us/parse, bids: %d asks: %d, %zu KB\n", i, t->cpu,
+               t->elapsed * 1e6 / PARSES_PER_THREAD, t->book_soa.bids.count, t->book_soa.asks.count,
+               orderbook_soa_memory(&t->book_soa) / 1024);
+        failed += t->failed + compare_orderbook_snapshot(reference, &t->book_soa);
+    }
+    printf("Total: %.0f parses/s\n", thread_count * PARSES_PER_THREAD / elapsed);
+
+    for (int i = 0; i < thread_count; i++) {
+        arena_free(&threads[i].arena);
+    }
+    free(threads);
+    free(ids);
+    return failed != 0;
+}
+
+int main(int argc, char** argv) {
     //const char* json = "{\"lastUpdateId\":74247481137,\"bids\":[[\"116867.58000000\",\"3.43289000\"],[\"116867.57000000\",\"0.00040000\"],[\"116867.13000000\",\"0.00010000\"],[\"116867.12000000\",\"0.00035000\"],[\"116867.11000000\",\"0.28250000\"]],\"asks\":[[\"116867.59000000\",\"3.44566000\"],[\"116867.60000000\",\"0.07878000\"],[\"116867.64000000\",\"0.05198000\"],[\"116867.65000000\",\"0.05717000\"],[\"116867.77000000\",\"0.06536000\"]]}";
+    const char* filename = argc > 1 ? argv[1] : "data/BTCUSDT.depth_20250810.json";
 
-    char* json_data = load_json_file("data/BTCUSDT.depth_20250810.json");
-    OrderBook* book = parse_orderbook_snapshot(json_data);
-    printf("Order Book: bids: %d asks: %d\n", book->bid_count, book->ask_count);
-    printf("Order Book: 1st bid{price: %f, amount: %f}\n", book->bids[0].price, book->bids[0].amount);
-    printf("Order Book: 1st ask{price: %f, amount: %f}\n", book->asks[0].price, book->asks[0].amount);
+    MappedJson json;
+    if (map_json_file(filename, &json) != 0) {
+        printf("Failed to map %s\n", filename);
+        return 1;
+    }
 
-    printf("Copying from simple orderbook into orderbook soa...\n");
+    if (argc > 2) {
+        int result = run_parallel_parse(&json, atoi(argv[2]) > 0 ? atoi(argv[2]) : 1);
+        unmap_json_file(&json);
+        return result;
+    }
 
-    OrderBookSOA* book_soa = orderBookSOA_from_simple_orderbook(book);
+    static OrderBookSOA book;
+    if (!parse_orderbook_snapshot_soa_into(&book, json.data, json.size)) {
+        printf("Failed to parse %s\n", filename);
+        free_orderbook_soa(&book);
+        unmap_json_file(&json);
+        return 1;
+    }
+    printf("Order Book: bids: %d asks: %d\n", book.bids.count, book.asks.count);
+    if (book.bids.count > 0) {
+        printf("Order Book: 1st bid{price: %f, amount: %f}\n",
+               fixed_point_to_double(book.bids.prices[0]), fixed_point_to_double(book.bids.amounts[0]));
+    }
+    if (book.asks.count > 0) {
+        printf("Order Book: 1st ask{price: %f, amount: %f}\n",
+               fixed_point_to_double(book.asks.prices[0]), fixed_point_to_double(book.asks.amounts[0]));
+    }
 
-    printf("Copying from simple orderbook into orderbook levels...\n");
+#ifdef ORDERBOOK_VALIDATE
+    printf("Validating against the simple orderbook...\n");
+    compare_orderbook_snapshot(parse_orderbook_snapshot_n(json.data, json.size), &book);
+#endif
 
+    unmap_json_file(&json);
 
     return 0;
-}
\ No newline at end of file
+}
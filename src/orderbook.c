@@ -3,156 +3,260 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "../include/orderbook.h"
+#include "../include/fixed_point.h"
+#include "../include/json_scan.h"
 
 // Static order book instance to avoid repeated allocations
 static OrderBook g_orderbook;
 static OrderBookSOA g_orderbook_soa;
 
+// All parsing is bounded by an end pointer: the input does not need a NUL
+// terminator (mmap'd files, websocket frames)
+
 // Helper function to skip whitespace
-static const char* skip_whitespace(const char* str) {
-    while (*str == ' ' || *str == '\t' || *str == '\n' || *str == '\r') {
+static const char* skip_whitespace(const char* str, const char* end) {
+    while (str < end && (*str == ' ' || *str == '\t' || *str == '\n' || *str == '\r')) {
         str++;
     }
     return str;
 }
 
-// Helper function to parse a double from string (more efficient version)
-static double parse_double(const char* start, const char* end) {
-    // Create a temporary null-terminated string
-    char temp[100];
-    int len = end - start;
-    if (len >= 100) len = 99;
-    memcpy(temp, start, len);
-    temp[len] = '\0';
-    
-    return atof(temp);
-}
-
-// Helper function to parse a single bid/ask entry
-static int parse_entry(const char** json_ptr, OrderBookEntry* entries, int* count, int max_entries) {
-    const char* ptr = *json_ptr;
-    
-    // Skip opening bracket
-    if (*ptr != '[') {
-        return 0;
-    }
-    ptr++;
-    
-    // Parse price (first element in array)
-    ptr = skip_whitespace(ptr);
-    if (*ptr != '"') {
-        return 0;
-    }
-    ptr++;
-    
-    const char* price_start = ptr;
-    while (*ptr != '"') ptr++;
-    const char* price_end = ptr;
-    ptr++;
-    
-    // Skip comma
-    ptr = skip_whitespace(ptr);
-    if (*ptr != ',') {
-        return 0;
+// Helper function to parse a quoted string, returns the position after the closing quote
+static const char* parse_string(const char* ptr, const char* end,
+                                const char** start_out, const char** end_out) {
+    if (ptr >= end || *ptr != '"') {
+        return NULL;
     }
     ptr++;
     
-    // Parse amount (second element in array)
-    ptr = skip_whitespace(ptr);
-    if (*ptr != '"') {
-        return 0;
-    }
-    ptr++;
-    
-    const char* amount_start = ptr;
-    while (*ptr != '"') ptr++;
-    const char* amount_end = ptr;
-    ptr++;
-    
-    // Skip closing bracket
-    if (*ptr != ']') {
-        return 0;
-    }
-    ptr++;
-    
-    // Check for comma or end of array (skip comma if present)
-    ptr = skip_whitespace(ptr);
-    if (*ptr == ',') {
-        ptr++;  // Skip the comma
-        ptr = skip_whitespace(ptr);  // Skip any whitespace after comma
+    const char* close = memchr(ptr, '"', end - ptr);
+    if (!close) {
+        return NULL;
     }
+    *start_out = ptr;
+    *end_out = close;
+    return close + 1;
+}
+
+static inline int book_max_depth(int max_depth) {
+    return max_depth > 0 ? max_depth : MAX_ORDERBOOK_ENTRIES;
+}
+
+// Where parsed levels go: doubles for the AoS OrderBook, fixed-point columns
+// for the SOA book (both grown on demand), or fixed-point pairs for diffs
+typedef struct {
+    OrderBook* book;
+    OrderBookSOA* soa;
+    DepthLevel* levels;
+    int is_bid;
+    int* count;
+    int max_entries;
+} LevelSink;
+
+// Append one level, returns 0 if the side could not grow
+static int sink_store(LevelSink* sink, int64_t price, int64_t amount) {
+    int i = *sink->count;
     
-    // Store the entry
-    if (*count < max_entries) {
-        entries[*count].price = parse_double(price_start, price_end);
-        entries[*count].amount = parse_double(amount_start, amount_end);
-        (*count)++;
+    if (sink->book) {
+        OrderBook* ob = sink->book;
+        if (i == (sink->is_bid ? ob->bid_capacity : ob->ask_capacity) &&
+            !orderbook_reserve(ob, sink->is_bid, i + 1)) {
+            return 0;
+        }
+        OrderBookEntry* entries = sink->is_bid ? ob->bids : ob->asks;
+        entries[i].id = 0;
+        entries[i].price = fixed_point_to_double(price);
+        entries[i].amount = fixed_point_to_double(amount);
+    } else if (sink->soa) {
+        SideSOA* side = sink->is_bid ? &sink->soa->bids : &sink->soa->asks;
+        if (i == side->capacity && !orderbook_soa_reserve(sink->soa, sink->is_bid, i + 1)) {
+            return 0;
+        }
+        side->prices[i] = price;
+        side->amounts[i] = amount;
+    } else {
+        sink->levels[i].price = price;
+        sink->levels[i].amount = amount;
     }
-    
-    *json_ptr = ptr;
+    (*sink->count)++;
     return 1;
 }
 
-// Helper function to parse bids array
-static int parse_bids_array(const char* bids_start) {
-    int bid_count = 0;
-    const char* temp_ptr = bids_start;
+// Helper function to parse a "bids"/"asks"/"b"/"a" array of levels
+// Levels beyond max_entries are parsed (to keep going) but dropped
+//
+// Walks the structural characters of the array with the SIMD scanner, a
+// ["price","amount"] level being exactly  [ " " , " " ]  so the quotes give
+// the number boundaries directly. Decodes straight to fixed-point (no copy,
+// no atof); converting back with fixed_point_to_double gives exactly the
+// double atof would have returned.
+static const char* parse_levels_array(const char* ptr, const char* end, LevelSink* sink) {
+    static const char level_shape[] = "[\"\",\"\"]";
+    JsonScanner scanner;
     
     // Skip opening bracket of the array itself
-    if (*temp_ptr == '[') {
-        temp_ptr++;
+    if (ptr >= end || *ptr != '[') {
+        return NULL;
     }
+    json_scanner_init(&scanner, ptr + 1, end);
     
-    while (*temp_ptr != ']' && bid_count < MAX_ORDERBOOK_ENTRIES) {
-        if (!parse_entry(&temp_ptr, g_orderbook.bids, &g_orderbook.bid_count, MAX_ORDERBOOK_ENTRIES)) {
-            break;
+    for (;;) {
+        const char* c = json_scanner_next(&scanner);
+        const char* marks[sizeof(level_shape) - 1];
+        int64_t price, amount;
+        
+        if (!c || *c == ']') {
+            return c ? c + 1 : NULL;
+        }
+        if (*c == ',') {
+            continue;  // between levels
+        }
+        
+        marks[0] = c;
+        for (size_t i = 1; i < sizeof(level_shape) - 1; i++) {
+            marks[i] = json_scanner_next(&scanner);
+            if (!marks[i]) return NULL;
+        }
+        for (size_t i = 0; i < sizeof(level_shape) - 1; i++) {
+            if (*marks[i] != level_shape[i]) return NULL;
         }
         
-        // Check if we should continue (look for comma or closing bracket)
-        temp_ptr = skip_whitespace(temp_ptr);
-        if (*temp_ptr == ',') {
-            temp_ptr++;  // Skip comma
-            temp_ptr = skip_whitespace(temp_ptr);  // Skip any whitespace after comma
-        } else if (*temp_ptr == ']') {
-            break;  // End of array
+        if (!parse_fixed_point(marks[1] + 1, marks[2], &price) ||
+            !parse_fixed_point(marks[4] + 1, marks[5], &amount)) {
+            return NULL;
         }
         
-        bid_count++;
+        if (*sink->count < sink->max_entries && !sink_store(sink, price, amount)) {
+            return NULL;
+        }
     }
+}
+
+// Helper function to parse an unsigned integer value such as 74347217295
+static const char* parse_u64(const char* ptr, const char* end, uint64_t* out) {
+    const char* digits = ptr;
+    uint64_t result = 0;
     
-    return bid_count;
+    while (ptr < end && *ptr >= '0' && *ptr <= '9') {
+        result = result * 10 + (*ptr - '0');
+        ptr++;
+    }
+    *out = result;
+    return ptr != digits ? ptr : NULL;
 }
 
-// Helper function to parse asks array
-static int parse_asks_array(const char* asks_start) {
-    int ask_count = 0;
-    const char* temp_ptr = asks_start;
+// Helper function to skip a value we do not care about ("e", "s", ...)
+static const char* skip_value(const char* ptr, const char* end) {
+    const char *start, *close;
     
-    // Skip opening bracket of the array itself
-    if (*temp_ptr == '[') {
-        temp_ptr++;
+    if (ptr >= end) {
+        return NULL;
+    }
+    
+    if (*ptr == '"') {
+        // Symbols and event types never contain escaped quotes
+        return parse_string(ptr, end, &start, &close);
     }
     
-    while (*temp_ptr != ']' && ask_count < MAX_ORDERBOOK_ENTRIES) {
-        if (!parse_entry(&temp_ptr, g_orderbook.asks, &g_orderbook.ask_count, MAX_ORDERBOOK_ENTRIES)) {
-            break;
+    if (*ptr == '{' || *ptr == '[') {
+        int depth = 0;
+        while (ptr < end) {
+            if (*ptr == '"') {
+                ptr = parse_string(ptr, end, &start, &close);
+                if (!ptr) return NULL;
+                continue;
+            }
+            if (*ptr == '{' || *ptr == '[') depth++;
+            if (*ptr == '}' || *ptr == ']') {
+                if (--depth == 0) return ptr + 1;
+            }
+            ptr++;
         }
+        return NULL;
+    }
+    
+    // Number, true, false, null
+    while (ptr < end && *ptr != ',' && *ptr != '}' && *ptr != ']' &&
+           *ptr != ' ' && *ptr != '\t' && *ptr != '\n' && *ptr != '\r') {
+        ptr++;
+    }
+    return ptr;
+}
+
+// Where the single-pass parser stores what it finds
+typedef struct {
+    unsigned fields;            // DEPTH_FIELD_* seen
+    uint64_t* last_update_id;   // "lastUpdateId" (snapshot) or "u" (diff)
+    uint64_t* first_update_id;  // "U"
+    uint64_t* event_time;       // "E"
+    LevelSink bids;             // "bids" or "b"
+    LevelSink asks;             // "asks" or "a"
+} DepthTargets;
+
+#define KEY_IS(start, len, literal) \
+    ((len) == sizeof(literal) - 1 && memcmp((start), (literal), sizeof(literal) - 1) == 0)
+
+// One pass over a depth message object, keys handled in document order.
+// Returns the number of bytes consumed through the closing brace, 0 if the
+// message is malformed or truncated (levels parsed so far are kept).
+static size_t parse_depth_object(const char* json, size_t len, DepthTargets* targets) {
+    const char* end = json + len;
+    const char* ptr = skip_whitespace(json, end);
+    uint64_t ignored;
+    
+    if (ptr >= end || *ptr != '{') {
+        return 0;
+    }
+    ptr = skip_whitespace(ptr + 1, end);
+    
+    while (ptr < end && *ptr != '}') {
+        const char *key, *key_end;
+        
+        ptr = parse_string(ptr, end, &key, &key_end);
+        if (!ptr) return 0;
         
-        // Check if we should continue (look for comma or closing bracket)
-        temp_ptr = skip_whitespace(temp_ptr);
-        if (*temp_ptr == ',') {
-            temp_ptr++;  // Skip comma
-            temp_ptr = skip_whitespace(temp_ptr);  // Skip any whitespace after comma
-        } else if (*temp_ptr == ']') {
-            break;  // End of array
+        ptr = skip_whitespace(ptr, end);
+        if (ptr >= end || *ptr != ':') return 0;
+        ptr = skip_whitespace(ptr + 1, end);
+        
+        size_t key_len = key_end - key;
+        
+        if (KEY_IS(key, key_len, "bids") || KEY_IS(key, key_len, "b")) {
+            ptr = parse_levels_array(ptr, end, &targets->bids);
+            targets->fields |= DEPTH_FIELD_BIDS;
+        } else if (KEY_IS(key, key_len, "asks") || KEY_IS(key, key_len, "a")) {
+            ptr = parse_levels_array(ptr, end, &targets->asks);
+            targets->fields |= DEPTH_FIELD_ASKS;
+        } else if (KEY_IS(key, key_len, "lastUpdateId")) {
+            ptr = parse_u64(ptr, end, targets->last_update_id ? targets->last_update_id : &ignored);
+            targets->fields |= DEPTH_FIELD_LAST_UPDATE_ID;
+        } else if (KEY_IS(key, key_len, "u")) {
+            ptr = parse_u64(ptr, end, targets->last_update_id ? targets->last_update_id : &ignored);
+            targets->fields |= DEPTH_FIELD_FINAL_UPDATE_ID;
+        } else if (KEY_IS(key, key_len, "U")) {
+            ptr = parse_u64(ptr, end, targets->first_update_id ? targets->first_update_id : &ignored);
+            targets->fields |= DEPTH_FIELD_FIRST_UPDATE_ID;
+        } else if (KEY_IS(key, key_len, "E")) {
+            ptr = parse_u64(ptr, end, targets->event_time ? targets->event_time : &ignored);
+            targets->fields |= DEPTH_FIELD_EVENT_TIME;
+        } else {
+            ptr = skip_value(ptr, end);
         }
+        if (!ptr) return 0;
         
-        ask_count++;
+        ptr = skip_whitespace(ptr, end);
+        if (ptr < end && *ptr == ',') {
+            ptr = skip_whitespace(ptr + 1, end);
+        }
     }
     
-    return ask_count;
+    if (ptr >= end) {
+        return 0;
+    }
+    return (ptr + 1) - json;
 }
 
 // rebuilding the orderbook from a snapshot:
@@ -174,20 +278,24 @@ static int parse_asks_array(const char* asks_start) {
 */
 
 
-int compare_orderbook_snapshot(OrderBook* ob, OrderBookSOA* ob_soa) {
+int compare_orderbook_snapshot(const OrderBook* ob, const OrderBookSOA* ob_soa) {
     int err = 0;
+    if (ob->bid_count != ob_soa->bids.count || ob->ask_count != ob_soa->asks.count) {
+        printf("Level counts differ between OrderBook and OrderBookSOA\n");
+        return 1;
+    }
     // compare ob and orderbooksoa
     for (int i = 0; i < ob->bid_count; i++) {
-        if (ob->bids[i].price != g_orderbook_soa.bids.prices[i] ||
-            ob->bids[i].amount != g_orderbook_soa.bids.amounts[i]) {
+        if (ob->bids[i].price != fixed_point_to_double(ob_soa->bids.prices[i]) ||
+            ob->bids[i].amount != fixed_point_to_double(ob_soa->bids.amounts[i])) {
             printf("Discrepancy found in bids at index %d\n", i);
             err++ ;
         }
     }
 
     for (int i = 0; i < ob->ask_count; i++) {
-        if (ob->asks[i].price != g_orderbook_soa.asks.prices[i] ||
-            ob->asks[i].amount != g_orderbook_soa.asks.amounts[i]) {
+        if (ob->asks[i].price != fixed_point_to_double(ob_soa->asks.prices[i]) ||
+            ob->asks[i].amount != fixed_point_to_double(ob_soa->asks.amounts[i])) {
             printf("Discrepancy found in asks at index %d\n", i);
             err++ ;
         }
@@ -203,72 +311,387 @@ int compare_orderbook_snapshot(OrderBook* ob, OrderBookSOA* ob_soa) {
 
 }
 
-OrderBookPriceLevel* orderBookPriceLevel_from_simple_orderbook(OrderBook* ob) {
-    // build orderbooksoa from orderbook
+OrderBookPriceLevel* orderBookPriceLevel_from_simple_orderbook_into(OrderBookPriceLevel* book, Arena* arena,
+                                                                    const OrderBook* ob) {
+    // An L2 snapshot only has aggregated quantities: one order per level
+    book->bids = arena_alloc(arena, ob->bid_count * sizeof(PriceLevel), 64);
+    book->asks = arena_alloc(arena, ob->ask_count * sizeof(PriceLevel), 64);
+    Order* orders = arena_alloc(arena, (ob->bid_count + ob->ask_count) * sizeof(Order), 64);
+    if (!book->bids || !book->asks || !orders) {
+        return NULL;
+    }
+
     for (int i = 0; i < ob->bid_count; i++) {
-        g_orderbook_soa.bids.prices[i] = ob->bids[i].price;
-        g_orderbook_soa.bids.amounts[i] = ob->bids[i].amount;
+        PriceLevel* level = &book->bids[i];
+        level->price = ob->bids[i].price;
+        level->entries = orders++;
+        level->entries[0].id = ob->bids[i].id;
+        level->entries[0].amount = ob->bids[i].amount;
+        level->count = level->capacity = 1;
     }
+    book->bid_count = ob->bid_count;
 
+    for (int i = 0; i < ob->ask_count; i++) {
+        PriceLevel* level = &book->asks[i];
+        level->price = ob->asks[i].price;
+        level->entries = orders++;
+        level->entries[0].id = ob->asks[i].id;
+        level->entries[0].amount = ob->asks[i].amount;
+        level->count = level->capacity = 1;
+    }
+    book->ask_count = ob->ask_count;
+
+    return book;
 }
 
-OrderBookSOA* orderBookSOA_from_simple_orderbook(OrderBook* ob) {
+OrderBookPriceLevel* orderBookPriceLevel_from_simple_orderbook(OrderBook* ob) {
+    static Arena arena;
+    static OrderBookPriceLevel book;
+
+    arena_reset(&arena);
+    if (!arena.block_size) arena_init(&arena, 0);
+    return orderBookPriceLevel_from_simple_orderbook_into(&book, &arena, ob);
+}
+
+OrderBookSOA* orderBookSOA_from_simple_orderbook_into(OrderBookSOA* soa, const OrderBook* ob) {
     // build orderbooksoa from orderbook
+    // Book prices came from fixed-point, so rounding back is exact
+    // Fails as well when ob is deeper than soa->max_depth
+    if (!orderbook_soa_reserve(soa, 1, ob->bid_count) ||
+        !orderbook_soa_reserve(soa, 0, ob->ask_count) ||
+        ob->bid_count > soa->bids.capacity || ob->ask_count > soa->asks.capacity) {
+        return NULL;
+    }
+
     for (int i = 0; i < ob->bid_count; i++) {
-        g_orderbook_soa.bids.prices[i] = ob->bids[i].price;
-        g_orderbook_soa.bids.amounts[i] = ob->bids[i].amount;
+        soa->bids.prices[i] = llround(ob->bids[i].price * FIXED_POINT_SCALE);
+        soa->bids.amounts[i] = llround(ob->bids[i].amount * FIXED_POINT_SCALE);
     }
-    g_orderbook_soa.bids.count = ob->bid_count;
+    soa->bids.count = ob->bid_count;
 
     for (int i = 0; i < ob->ask_count; i++) {
-        g_orderbook_soa.asks.prices[i] = ob->asks[i].price;
-        g_orderbook_soa.asks.amounts[i] = ob->asks[i].amount;
+        soa->asks.prices[i] = llround(ob->asks[i].price * FIXED_POINT_SCALE);
+        soa->asks.amounts[i] = llround(ob->asks[i].amount * FIXED_POINT_SCALE);
     }
-    g_orderbook_soa.asks.count = ob->ask_count;
+    soa->asks.count = ob->ask_count;
+    soa->last_update_id = ob->last_update_id;
+
+#ifdef ORDERBOOK_VALIDATE
+    compare_orderbook_snapshot(ob, soa);
+#endif
 
-    compare_orderbook_snapshot(ob, &g_orderbook_soa);
+    return soa;
+}
 
-    return &g_orderbook_soa;
+OrderBookSOA* orderBookSOA_from_simple_orderbook(OrderBook* ob) {
+    return orderBookSOA_from_simple_orderbook_into(&g_orderbook_soa, ob);
 }
 
 
-OrderBook* parse_orderbook_snapshot(const char* json) {
+int parse_orderbook_snapshot_into(OrderBook* ob, const char* json, size_t len) {
     // Initialize counts to zero
-    g_orderbook.bid_count = 0;
-    g_orderbook.ask_count = 0;
+    ob->bid_count = 0;
+    ob->ask_count = 0;
+    ob->last_update_id = 0;
     
-    const char* ptr = json;
+    DepthTargets targets = {
+        .last_update_id = &ob->last_update_id,
+        .bids = { .book = ob, .is_bid = 1, .count = &ob->bid_count,
+                  .max_entries = book_max_depth(ob->max_depth) },
+        .asks = { .book = ob, .is_bid = 0, .count = &ob->ask_count,
+                  .max_entries = book_max_depth(ob->max_depth) },
+    };
+    return parse_depth_object(json, len, &targets) != 0;
+}
+
+int parse_orderbook_snapshot_soa_into(OrderBookSOA* soa, const char* json, size_t len) {
+    soa->bids.count = 0;
+    soa->asks.count = 0;
+    soa->last_update_id = 0;
     
-    // Find bids array
-    const char* bids_start = strstr(ptr, "\"bids\":[");
-    if (bids_start) {
-        // Move past "\"bids\":[" 
-        bids_start += 7; // length of "\"bids\":["
-        
-        // Skip whitespace
-        bids_start = skip_whitespace(bids_start);
-        
-        parse_bids_array(bids_start);
+    DepthTargets targets = {
+        .last_update_id = &soa->last_update_id,
+        .bids = { .soa = soa, .is_bid = 1, .count = &soa->bids.count,
+                  .max_entries = book_max_depth(soa->max_depth) },
+        .asks = { .soa = soa, .is_bid = 0, .count = &soa->asks.count,
+                  .max_entries = book_max_depth(soa->max_depth) },
+    };
+    return parse_depth_object(json, len, &targets) != 0;
+}
+
+OrderBook* parse_orderbook_snapshot_n(const char* json, size_t len) {
+    parse_orderbook_snapshot_into(&g_orderbook, json, len);
+    return &g_orderbook;
+}
+
+OrderBook* parse_orderbook_snapshot(const char* json) {
+    return parse_orderbook_snapshot_n(json, strlen(json));
+}
+
+// Parse a diff-depth stream event:
+/*
+ {"e":"depthUpdate","E":1754830000123,"s":"BTCUSDT",
+  "U":74347217296,"u":74347217301,
+  "b":[["118728.39000000","3.51000000"]],
+  "a":[["118728.40000000","0.00000000"]]}
+*/
+size_t parse_depth_message(const char* json, size_t len, DepthUpdate* update) {
+    update->fields = 0;
+    update->bid_count = 0;
+    update->ask_count = 0;
+    update->event_time = 0;
+    update->first_update_id = 0;
+    update->last_update_id = 0;
+    
+    DepthTargets targets = {
+        .last_update_id = &update->last_update_id,
+        .first_update_id = &update->first_update_id,
+        .event_time = &update->event_time,
+        .bids = { .levels = update->bids, .count = &update->bid_count,
+                  .max_entries = MAX_ORDERBOOK_ENTRIES },
+        .asks = { .levels = update->asks, .count = &update->ask_count,
+                  .max_entries = MAX_ORDERBOOK_ENTRIES },
+    };
+    size_t consumed = parse_depth_object(json, len, &targets);
+    update->fields = targets.fields;
+    
+    return consumed;
+}
+
+int parse_depth_update_n(const char* json, size_t len, DepthUpdate* update) {
+    const unsigned required = DEPTH_FIELD_FIRST_UPDATE_ID | DEPTH_FIELD_FINAL_UPDATE_ID;
+    
+    return parse_depth_message(json, len, update) != 0 &&
+           (update->fields & required) == required;
+}
+
+int parse_depth_update(const char* json, DepthUpdate* update) {
+    return parse_depth_update_n(json, strlen(json), update);
+}
+
+// Book storage: sides start empty and double up to max_depth
+
+void orderbook_init(OrderBook* ob, Arena* arena, int max_depth) {
+    memset(ob, 0, sizeof(*ob));
+    ob->arena = arena;
+    ob->max_depth = max_depth;
+}
+
+void orderbook_soa_init(OrderBookSOA* soa, Arena* arena, int max_depth) {
+    memset(soa, 0, sizeof(*soa));
+    soa->arena = arena;
+    soa->max_depth = max_depth;
+}
+
+// New capacity for a side that must hold `needed` levels
+static int grow_capacity(int capacity, int needed, int max_depth) {
+    int grown = capacity ? capacity : ORDERBOOK_INITIAL_CAPACITY;
+    while (grown < needed) grown *= 2;
+    return grown < max_depth ? grown : max_depth;
+}
+
+// Arena blocks are never freed one by one, heap buffers are
+static void* alloc_buffer(Arena* arena, size_t size, size_t align) {
+    if (arena) return arena_alloc(arena, size, align);
+    return aligned_alloc(align, (size + align - 1) & ~(align - 1));
+}
+
+static void release_buffer(Arena* arena, void* buffer) {
+    if (!arena) free(buffer);
+}
+
+// Copy into a new buffer and release the old one. On failure the old
+// buffer is left untouched and NULL is returned.
+static void* grow_buffer(Arena* arena, void* old, size_t old_size, size_t size, size_t align) {
+    if (!arena && align <= sizeof(void*) * 2) {
+        return realloc(old, size);
+    }
+    void* buffer = alloc_buffer(arena, size, align);
+    if (!buffer) return NULL;
+    if (old) memcpy(buffer, old, old_size);
+    release_buffer(arena, old);
+    return buffer;
+}
+
+int orderbook_reserve(OrderBook* ob, int is_bid, int capacity) {
+    int* current = is_bid ? &ob->bid_capacity : &ob->ask_capacity;
+    OrderBookEntry** entries = is_bid ? &ob->bids : &ob->asks;
+    int count = is_bid ? ob->bid_count : ob->ask_count;
+    
+    if (capacity <= *current) return 1;
+    
+    int grown = grow_capacity(*current, capacity, book_max_depth(ob->max_depth));
+    if (grown <= *current) return 1;  // already at max_depth
+    
+    OrderBookEntry* buffer = grow_buffer(ob->arena, *entries, count * sizeof(OrderBookEntry),
+                                         grown * sizeof(OrderBookEntry), _Alignof(OrderBookEntry));
+    if (!buffer) return 0;
+    *entries = buffer;
+    *current = grown;
+    return 1;
+}
+
+int orderbook_soa_reserve(OrderBookSOA* soa, int is_bid, int capacity) {
+    SideSOA* side = is_bid ? &soa->bids : &soa->asks;
+    
+    if (capacity <= side->capacity) return 1;
+    
+    int grown = grow_capacity(side->capacity, capacity, book_max_depth(soa->max_depth));
+    if (grown <= side->capacity) return 1;  // already at max_depth
+    
+    // Both columns or neither: they always share one capacity
+    int64_t* prices = alloc_buffer(soa->arena, grown * sizeof(int64_t), SOA_ALIGNMENT);
+    int64_t* amounts = alloc_buffer(soa->arena, grown * sizeof(int64_t), SOA_ALIGNMENT);
+    if (!prices || !amounts) {
+        release_buffer(soa->arena, prices);
+        release_buffer(soa->arena, amounts);
+        return 0;
     }
+    if (side->count) {
+        memcpy(prices, side->prices, side->count * sizeof(int64_t));
+        memcpy(amounts, side->amounts, side->count * sizeof(int64_t));
+    }
+    release_buffer(soa->arena, side->prices);
+    release_buffer(soa->arena, side->amounts);
+    side->prices = prices;
+    side->amounts = amounts;
     
-    // Find asks array  
-    const char* asks_start = strstr(ptr, "\"asks\":[");
-    if (asks_start) {
-        // Move past "\"asks\":[" 
-        asks_start += 7; // length of "\"asks\":["
+    side->capacity = grown;
+    return 1;
+}
+
+size_t orderbook_memory(const OrderBook* ob) {
+    return (size_t)(ob->bid_capacity + ob->ask_capacity) * sizeof(OrderBookEntry);
+}
+
+size_t orderbook_soa_memory(const OrderBookSOA* soa) {
+    return (size_t)(soa->bids.capacity + soa->asks.capacity) * 2 * sizeof(int64_t);
+}
+
+// Binary search for a price on one side (bids descending, asks ascending)
+// Returns the index, or -(insertion point + 1) when the level does not exist
+static int find_entry(const OrderBookEntry* entries, int count, double price, int is_bid) {
+    int left = 0, right = count - 1;
+    
+    while (left <= right) {
+        int mid = (left + right) / 2;
+        double mid_price = entries[mid].price;
         
-        // Skip whitespace
-        asks_start = skip_whitespace(asks_start);
+        if (mid_price == price) return mid;
         
-        parse_asks_array(asks_start);
+        if ((is_bid && mid_price > price) || (!is_bid && mid_price < price)) {
+            left = mid + 1;
+        } else {
+            right = mid - 1;
+        }
     }
+    return -(left + 1);
+}
+
+int orderbook_apply_level(OrderBook* ob, int is_bid, int64_t price, int64_t amount) {
+    OrderBookEntry* entries = is_bid ? ob->bids : ob->asks;
+    int* count = is_bid ? &ob->bid_count : &ob->ask_count;
+    double level_price = fixed_point_to_double(price);
     
-    return &g_orderbook;
+    int pos = find_entry(entries, *count, level_price, is_bid);
+    
+    if (pos >= 0) {
+        if (amount == 0) {
+            // Quantity zero removes the level
+            memmove(&entries[pos], &entries[pos + 1],
+                    (*count - pos - 1) * sizeof(OrderBookEntry));
+            (*count)--;
+        } else {
+            entries[pos].amount = fixed_point_to_double(amount);
+        }
+        return 1;
+    }
+    
+    if (amount == 0) {
+        // Removing a level we never had (e.g. beyond our depth) is a no-op
+        return 0;
+    }
+    
+    pos = -(pos + 1);
+    int max_depth = book_max_depth(ob->max_depth);
+    if (*count == max_depth) {
+        // Book is full: keep the best levels, drop the deepest one
+        if (pos == max_depth) {
+            return 0;
+        }
+        (*count)--;
+    } else if (!orderbook_reserve(ob, is_bid, *count + 1)) {
+        return 0;
+    }
+    entries = is_bid ? ob->bids : ob->asks;
+    
+    memmove(&entries[pos + 1], &entries[pos],
+            (*count - pos) * sizeof(OrderBookEntry));
+    entries[pos].id = 0;
+    entries[pos].price = level_price;
+    entries[pos].amount = fixed_point_to_double(amount);
+    (*count)++;
+    return 1;
+}
+
+void orderbook_apply_update(OrderBook* ob, const DepthUpdate* update) {
+    for (int i = 0; i < update->bid_count; i++) {
+        orderbook_apply_level(ob, 1, update->bids[i].price, update->bids[i].amount);
+    }
+    for (int i = 0; i < update->ask_count; i++) {
+        orderbook_apply_level(ob, 0, update->asks[i].price, update->asks[i].amount);
+    }
+    ob->last_update_id = update->last_update_id;
 }
 
-// Free order book memory (no-op since we use static allocation)
+// Rebuild a book from fixed-point levels (best first), e.g. a recorded snapshot
+void orderbook_load_levels(OrderBook* ob, uint64_t last_update_id,
+                           const DepthLevel* bids, int bid_count,
+                           const DepthLevel* asks, int ask_count) {
+    int max_depth = book_max_depth(ob->max_depth);
+    if (bid_count > max_depth) bid_count = max_depth;
+    if (ask_count > max_depth) ask_count = max_depth;
+    
+    ob->bid_count = 0;
+    ob->ask_count = 0;
+    if (!orderbook_reserve(ob, 1, bid_count)) bid_count = ob->bid_capacity;
+    if (!orderbook_reserve(ob, 0, ask_count)) ask_count = ob->ask_capacity;
+    
+    for (int i = 0; i < bid_count; i++) {
+        ob->bids[i].id = 0;
+        ob->bids[i].price = fixed_point_to_double(bids[i].price);
+        ob->bids[i].amount = fixed_point_to_double(bids[i].amount);
+    }
+    for (int i = 0; i < ask_count; i++) {
+        ob->asks[i].id = 0;
+        ob->asks[i].price = fixed_point_to_double(asks[i].price);
+        ob->asks[i].amount = fixed_point_to_double(asks[i].amount);
+    }
+    ob->bid_count = bid_count;
+    ob->ask_count = ask_count;
+    ob->last_update_id = last_update_id;
+}
+
+// Free order book memory, the book stays usable (empty)
 void free_orderbook(OrderBook* ob) {
-    // No-op - static allocation doesn't require freeing
+    if (!ob->arena) {
+        free(ob->bids);
+        free(ob->asks);
+    }
+    ob->bids = ob->asks = NULL;
+    ob->bid_count = ob->ask_count = 0;
+    ob->bid_capacity = ob->ask_capacity = 0;
+}
+
+void free_orderbook_soa(OrderBookSOA* soa) {
+    if (!soa->arena) {
+        free(soa->bids.prices);
+        free(soa->bids.amounts);
+        free(soa->asks.prices);
+        free(soa->asks.amounts);
+    }
+    memset(&soa->bids, 0, sizeof(soa->bids));
+    memset(&soa->asks, 0, sizeof(soa->asks));
 }
 
 // Print order book
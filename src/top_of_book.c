@@ -0,0 +1,83 @@
+// top_of_book.c
+#include "../include/top_of_book.h"
+
+#include <string.h>
+
+_Static_assert(sizeof(TopOfBookSnapshot) % sizeof(uint64_t) == 0,
+               "snapshot is copied as whole words");
+
+void top_of_book_init(TopOfBook* top) {
+    atomic_store_explicit(&top->sequence, 0, memory_order_relaxed);
+    for (size_t i = 0; i < TOP_OF_BOOK_WORDS; i++) {
+        atomic_store_explicit(&top->words[i], 0, memory_order_relaxed);
+    }
+}
+
+// The levels go through relaxed atomic word stores/loads: plain copies on
+// x86 and ARM, but not a data race as far as the compiler is concerned
+void top_of_book_publish(TopOfBook* top, const TopOfBookSnapshot* snapshot) {
+    uint64_t words[TOP_OF_BOOK_WORDS];
+    memcpy(words, snapshot, sizeof(words));
+
+    uint64_t sequence = atomic_load_explicit(&top->sequence, memory_order_relaxed);
+    atomic_store_explicit(&top->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  // odd sequence before any level
+
+    for (size_t i = 0; i < TOP_OF_BOOK_WORDS; i++) {
+        atomic_store_explicit(&top->words[i], words[i], memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&top->sequence, sequence + 2, memory_order_release);
+}
+
+void top_of_book_publish_book(TopOfBook* top, const OrderBook* book) {
+    TopOfBookSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    snapshot.last_update_id = book->last_update_id;
+    snapshot.in_sync = 1;
+    snapshot.bid_count = book->bid_count < TOP_OF_BOOK_LEVELS ? book->bid_count : TOP_OF_BOOK_LEVELS;
+    snapshot.ask_count = book->ask_count < TOP_OF_BOOK_LEVELS ? book->ask_count : TOP_OF_BOOK_LEVELS;
+    for (int i = 0; i < snapshot.bid_count; i++) {
+        snapshot.bids[i].price = book->bids[i].price;
+        snapshot.bids[i].amount = book->bids[i].amount;
+    }
+    for (int i = 0; i < snapshot.ask_count; i++) {
+        snapshot.asks[i].price = book->asks[i].price;
+        snapshot.asks[i].amount = book->asks[i].amount;
+    }
+
+    top_of_book_publish(top, &snapshot);
+}
+
+void top_of_book_publish_out_of_sync(TopOfBook* top, uint64_t last_update_id) {
+    TopOfBookSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.last_update_id = last_update_id;
+    top_of_book_publish(top, &snapshot);
+}
+
+int top_of_book_try_read(const TopOfBook* top, TopOfBookSnapshot* out) {
+    uint64_t words[TOP_OF_BOOK_WORDS];
+
+    uint64_t before = atomic_load_explicit(&top->sequence, memory_order_acquire);
+    if (before & 1) return 0;
+
+    for (size_t i = 0; i < TOP_OF_BOOK_WORDS; i++) {
+        words[i] = atomic_load_explicit(&top->words[i], memory_order_relaxed);
+    }
+
+    atomic_thread_fence(memory_order_acquire);  // every level before the re-check
+    if (atomic_load_explicit(&top->sequence, memory_order_relaxed) != before) return 0;
+
+    memcpy(out, words, sizeof(words));
+    return 1;
+}
+
+int top_of_book_read(const TopOfBook* top, TopOfBookSnapshot* out) {
+    int attempts = 1;
+    while (!top_of_book_try_read(top, out)) {
+        attempts++;
+    }
+    return attempts;
+}
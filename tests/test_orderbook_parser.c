@@ -1,6 +1,18 @@
 // test_orderbook_parser.c
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "unity.h"
-#include "../include/orderbook_parser.h"  // Adjust path as needed
+#include "../include/orderbook.h"
+#include "../include/fixed_point.h"
+#include "../include/depth_stream.h"
+#include "../include/capture.h"
+#include "../include/json_scan.h"
+#include "../include/cpu_features.h"
+#include "../include/book_scan.h"
+#include "../include/book_query.h"
+#include "../include/top_of_book.h"
+#include <unistd.h>
 
 void setUp(void) {}
 void tearDown(void) {}
@@ -45,11 +57,478 @@ void test_parse_multiple_entries(void) {
     TEST_ASSERT_EQUAL_FLOAT(2.3, ob->asks[0].amount);
 }
 
+void test_parse_snapshot_without_terminator(void) {
+    // Only the first len bytes belong to the message, the rest must be ignored
+    const char buffer[] = "{\"lastUpdateId\":7,\"bids\":[[\"49500.0\",\"1.2\"]],\"asks\":[[\"50000.0\",\"2.3\"]]}"
+                          "[[\"1.0\",\"1.0\"]]";
+    size_t len = strlen(buffer) - strlen("[[\"1.0\",\"1.0\"]]");
+
+    OrderBook* ob = parse_orderbook_snapshot_n(buffer, len);
+    TEST_ASSERT_EQUAL_UINT64(7, ob->last_update_id);
+    TEST_ASSERT_EQUAL_INT(1, ob->bid_count);
+    TEST_ASSERT_EQUAL_INT(1, ob->ask_count);
+
+    // Truncated in the middle of the asks: parse what is there, never read past len
+    ob = parse_orderbook_snapshot_n(buffer, len - 20);
+    TEST_ASSERT_EQUAL_INT(1, ob->bid_count);
+    TEST_ASSERT_EQUAL_INT(0, ob->ask_count);
+}
+
+void test_parse_into_caller_books(void) {
+    static OrderBook btc, eth;
+    const char* btc_json = "{\"lastUpdateId\":1,\"bids\":[[\"50000.0\",\"1.0\"]],\"asks\":[]}";
+    const char* eth_json = "{\"lastUpdateId\":2,\"bids\":[],\"asks\":[[\"3000.0\",\"2.0\"]]}";
+
+    TEST_ASSERT_TRUE(parse_orderbook_snapshot_into(&btc, btc_json, strlen(btc_json)));
+    TEST_ASSERT_TRUE(parse_orderbook_snapshot_into(&eth, eth_json, strlen(eth_json)));
+    TEST_ASSERT_FALSE(parse_orderbook_snapshot_into(&eth, eth_json, strlen(eth_json) - 1));
+
+    TEST_ASSERT_EQUAL_UINT64(1, btc.last_update_id);
+    TEST_ASSERT_EQUAL_INT(1, btc.bid_count);
+    TEST_ASSERT_EQUAL_INT(0, btc.ask_count);
+    TEST_ASSERT_EQUAL_INT(1, eth.ask_count);
+    TEST_ASSERT_EQUAL_FLOAT(3000.0, eth.asks[0].price);
+}
+
+void test_parse_into_soa_columns(void) {
+    static OrderBookSOA soa;
+    const char* json = "{\"lastUpdateId\":7,\"bids\":[[\"50000.10000000\",\"1.50000000\"],[\"49999.0\",\"2\"]],"
+                       "\"asks\":[[\"50001.0\",\"0.00000001\"]]}";
+
+    TEST_ASSERT_TRUE(parse_orderbook_snapshot_soa_into(&soa, json, strlen(json)));
+    TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)soa.bids.prices % SOA_ALIGNMENT);
+    TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)soa.asks.amounts % SOA_ALIGNMENT);
+    TEST_ASSERT_EQUAL_UINT64(7, soa.last_update_id);
+    TEST_ASSERT_EQUAL_INT(2, soa.bids.count);
+    TEST_ASSERT_EQUAL_INT(1, soa.asks.count);
+    TEST_ASSERT_EQUAL_INT64(5000010000000LL, soa.bids.prices[0]);
+    TEST_ASSERT_EQUAL_INT64(200000000LL, soa.bids.amounts[1]);
+    TEST_ASSERT_EQUAL_INT64(1, soa.asks.amounts[0]);
+
+    // Same book through the AoS path and the conversion
+    TEST_ASSERT_EQUAL_INT(0, compare_orderbook_snapshot(parse_orderbook_snapshot(json), &soa));
+}
+
+void test_arena_book_grows_to_max_depth(void) {
+    Arena arena;
+    OrderBook ob;
+
+    arena_init(&arena, 4096);
+    orderbook_init(&ob, &arena, 100);
+    TEST_ASSERT_EQUAL_UINT64(0, orderbook_memory(&ob));
+
+    // Asks deepen one tick at a time: the side grows, then stops at max_depth
+    for (int i = 0; i < 150; i++) {
+        orderbook_apply_level(&ob, 0, (50000LL + i) * FIXED_POINT_SCALE, FIXED_POINT_SCALE);
+    }
+    TEST_ASSERT_EQUAL_INT(100, ob.ask_count);
+    TEST_ASSERT_EQUAL_INT(100, ob.ask_capacity);
+    TEST_ASSERT_EQUAL_FLOAT(50099.0, ob.asks[99].price);
+
+    // A better price still gets in, pushing the deepest level out
+    orderbook_apply_level(&ob, 0, 49999LL * FIXED_POINT_SCALE, FIXED_POINT_SCALE);
+    TEST_ASSERT_EQUAL_INT(100, ob.ask_count);
+    TEST_ASSERT_EQUAL_FLOAT(49999.0, ob.asks[0].price);
+    TEST_ASSERT_EQUAL_FLOAT(50098.0, ob.asks[99].price);
+
+    TEST_ASSERT_EQUAL_INT(0, ob.bid_capacity);
+    TEST_ASSERT_TRUE(arena.allocated >= orderbook_memory(&ob));
+    arena_free(&arena);
+}
+
+void test_fixed_point_binance_format(void) {
+    const char* price = "118728.39000000";
+    const char* amount = "0.00010000";
+    int64_t value;
+
+    TEST_ASSERT_TRUE(parse_fixed_point(price, price + strlen(price), &value));
+    TEST_ASSERT_EQUAL_INT64(11872839000000LL, value);
+    TEST_ASSERT_TRUE(parse_fixed_point(amount, amount + strlen(amount), &value));
+    TEST_ASSERT_EQUAL_INT64(10000LL, value);
+}
+
+void test_fixed_point_short_and_invalid(void) {
+    const char* short_decimals = "49500.0";
+    const char* no_dot = "50000";
+    const char* too_precise = "1.123456789";
+    const char* garbage = "12a.00000000";
+    const char* no_dot_17 = "12345678912345678";   // fast-path length, no dot in it
+    const char* dot_at_8 = "12345678.12345678";
+    int64_t value;
+
+    TEST_ASSERT_TRUE(parse_fixed_point(short_decimals, short_decimals + strlen(short_decimals), &value));
+    TEST_ASSERT_EQUAL_INT64(4950000000000LL, value);
+    TEST_ASSERT_TRUE(parse_fixed_point(no_dot, no_dot + strlen(no_dot), &value));
+    TEST_ASSERT_EQUAL_INT64(5000000000000LL, value);
+    TEST_ASSERT_FALSE(parse_fixed_point(too_precise, too_precise + strlen(too_precise), &value));
+    TEST_ASSERT_FALSE(parse_fixed_point(garbage, garbage + strlen(garbage), &value));
+    TEST_ASSERT_EQUAL_INT(parse_fixed_point_scalar(no_dot_17, no_dot_17 + 17, &value),
+                          parse_fixed_point(no_dot_17, no_dot_17 + 17, &value));
+    TEST_ASSERT_FALSE(parse_fixed_point(no_dot_17, no_dot_17 + 17, &value));
+    TEST_ASSERT_TRUE(parse_fixed_point(dot_at_8, dot_at_8 + 17, &value));
+    TEST_ASSERT_EQUAL_INT64(1234567812345678LL, value);
+}
+
+void test_structural_scan_matches_scalar(void) {
+    const char* json = "{\"lastUpdateId\":74347217295,\"bids\":[[\"118728.39000000\",\"3.69858000\"],"
+                       "[\"118728.38000000\", \"0.00100000\"]],\"asks\":[{\"x\":1}]} trailing padding   ";
+    int len = strlen(json);
+    JsonScanner scanner;
+    int count = 0;
+
+    // Every alignment of a full block against the reference
+    for (int i = 0; i + JSON_SCAN_BLOCK <= len; i++) {
+        TEST_ASSERT_EQUAL_UINT64(json_structural_mask_scalar(json + i, JSON_SCAN_BLOCK),
+                                 json_structural_mask(json + i));
+    }
+
+    // The scanner visits every structural byte in order, tail included
+    json_scanner_init(&scanner, json, json + len);
+    for (const char* c = json; c < json + len; c++) {
+        if (strchr("\",:[]{}", *c)) {
+            TEST_ASSERT_EQUAL_PTR(c, json_scanner_next(&scanner));
+            count++;
+        }
+    }
+    TEST_ASSERT_NULL(json_scanner_next(&scanner));
+    TEST_ASSERT_TRUE(count > 30);
+}
+
+void test_structural_scan_bound_to_cpu(void) {
+    const CpuFeatures* cpu = cpu_features();
+    const char* expected = cpu->avx2 ? "avx2" : cpu->sse2 ? "sse2" : cpu->neon ? "neon" : "scalar";
+
+    TEST_ASSERT_EQUAL_STRING(expected, json_scan_kernel());
+}
+
+void test_book_scan_matches_reference(void) {
+    int64_t prices[37], amounts[37];
+    for (int i = 0; i < 37; i++) {
+        prices[i] = 11872839000000LL - i * 1000000LL;   // bids, best first
+        amounts[i] = 100000000LL + i * 3700000LL;
+    }
+
+    // Every count covers a different split between vector blocks and tail
+    for (int count = 0; count <= 37; count++) {
+        for (int n = -1; n <= count + 1; n++) {
+            TEST_ASSERT_EQUAL_INT64(book_scan_depth_c(amounts, count, n), book_scan_depth(amounts, count, n));
+        }
+        for (int i = 0; i < 37; i++) {
+            TEST_ASSERT_EQUAL_INT(book_scan_find_c(prices, count, prices[i]),
+                                  book_scan_find(prices, count, prices[i]));
+        }
+        TEST_ASSERT_EQUAL_INT(-1, book_scan_find(prices, count, prices[0] + 1));
+
+        int64_t total = book_scan_depth_c(amounts, count, count);
+        int64_t sizes[] = { 0, 1, amounts[0], amounts[0] + amounts[1] + amounts[2] + amounts[3],
+                            total / 2, total, total + 1 };
+        for (int s = 0; s < 7; s++) {
+            double expected, notional;
+            TEST_ASSERT_EQUAL_INT64(book_scan_vwap_c(prices, amounts, count, sizes[s], &expected),
+                                    book_scan_vwap(prices, amounts, count, sizes[s], &notional));
+            TEST_ASSERT_TRUE(fabs(notional - expected) <= expected * 1e-12);
+        }
+    }
+}
+
+void test_book_query_cost_to_fill(void) {
+    static OrderBookSOA soa;
+    const char* json = "{\"lastUpdateId\":1,\"bids\":[[\"99.0\",\"1.0\"],[\"98.0\",\"2.0\"]],"
+                       "\"asks\":[[\"100.0\",\"1.0\"],[\"101.0\",\"2.0\"],[\"102.0\",\"3.0\"]]}";
+    BookFill fill;
+
+    TEST_ASSERT_TRUE(parse_orderbook_snapshot_soa_into(&soa, json, strlen(json)));
+
+    // Buy 2.5: all of 100, 1.5 of 101
+    TEST_ASSERT_TRUE(book_cost_to_fill(&soa, 1, 250000000LL, &fill));
+    TEST_ASSERT_EQUAL_INT64(250000000LL, fill.filled);
+    TEST_ASSERT_EQUAL_INT(2, fill.levels);
+    TEST_ASSERT_EQUAL_INT64(101 * FIXED_POINT_SCALE, fill.worst_price);
+    TEST_ASSERT_EQUAL_FLOAT(251.5, fill.notional);
+    TEST_ASSERT_EQUAL_FLOAT(100.6, fill.vwap);
+
+    // Sell 5 against 3 on the bids: what there is
+    TEST_ASSERT_FALSE(book_cost_to_fill(&soa, 0, 500000000LL, &fill));
+    TEST_ASSERT_EQUAL_INT64(300000000LL, fill.filled);
+    TEST_ASSERT_EQUAL_INT(2, fill.levels);
+    TEST_ASSERT_EQUAL_INT64(98 * FIXED_POINT_SCALE, fill.worst_price);
+    TEST_ASSERT_EQUAL_FLOAT(295.0, fill.notional);
+
+    // Spend 200 buying: 100 on the first level, whole lots of 101 for the rest
+    TEST_ASSERT_TRUE(book_fill_notional(&soa, 1, 200.0, &fill));
+    TEST_ASSERT_EQUAL_INT64(199009900LL, fill.filled);
+    TEST_ASSERT_EQUAL_INT(2, fill.levels);
+    TEST_ASSERT_TRUE(fill.notional <= 200.0 && fill.notional > 199.999998);
+
+    free_orderbook_soa(&soa);
+}
+
+void test_book_query_matches_reference(void) {
+    int64_t prices[37], amounts[37];
+    for (int i = 0; i < 37; i++) {
+        prices[i] = 11872839000000LL + i * 1000000LL;    // asks, best first
+        amounts[i] = 100000000LL + (i % 5) * 37000000LL;
+    }
+
+    // Every count covers a different split between vector blocks and tail
+    for (int count = 0; count <= 37; count++) {
+        SideSOA side = { prices, amounts, count, 37 };
+        int64_t total = book_scan_depth_c(amounts, count, count);
+        double total_notional;
+        book_scan_vwap_c(prices, amounts, count, total, &total_notional);
+        total_notional /= (double)FIXED_POINT_SCALE * FIXED_POINT_SCALE;
+
+        for (int s = 0; s <= 8; s++) {
+            BookFill expected, fill;
+            int64_t quantity = s < 8 ? total * s / 7 : total + 1;
+            TEST_ASSERT_EQUAL_INT(book_query_quantity_scalar(&side, quantity, &expected),
+                                  book_query_quantity(&side, quantity, &fill));
+            TEST_ASSERT_EQUAL_INT64(expected.filled, fill.filled);
+            TEST_ASSERT_EQUAL_INT(expected.levels, fill.levels);
+            TEST_ASSERT_EQUAL_INT64(expected.worst_price, fill.worst_price);
+            TEST_ASSERT_TRUE(fabs(fill.notional - expected.notional) <= expected.notional * 1e-12);
+
+            // Prefix sums in another order can move the last lot either way
+            double notional = s < 8 ? total_notional * s / 7.3 : total_notional * 1.01;
+            TEST_ASSERT_EQUAL_INT(book_query_notional_scalar(&side, notional, &expected),
+                                  book_query_notional(&side, notional, &fill));
+            TEST_ASSERT_TRUE(llabs(fill.filled - expected.filled) <= 1);
+            TEST_ASSERT_EQUAL_INT(expected.levels, fill.levels);
+            TEST_ASSERT_TRUE(fill.notional <= notional);
+        }
+    }
+}
+
+void test_apply_depth_update_in_place(void) {
+    static DepthUpdate update;
+    const char* snapshot = "{\"lastUpdateId\":100,\"bids\":[[\"49500.0\",\"1.2\"],[\"49400.0\",\"1.5\"]],\"asks\":[[\"50000.0\",\"2.3\"]]}";
+    const char* diff = "{\"e\":\"depthUpdate\",\"E\":1,\"s\":\"BTCUSDT\",\"U\":101,\"u\":102,"
+                       "\"b\":[[\"49500.0\",\"0.0\"],[\"49450.0\",\"3.0\"]],\"a\":[[\"50000.0\",\"0.5\"]]}";
+
+    OrderBook* ob = parse_orderbook_snapshot(snapshot);
+    TEST_ASSERT_EQUAL_UINT64(100, ob->last_update_id);
+
+    TEST_ASSERT_TRUE(parse_depth_update(diff, &update));
+    TEST_ASSERT_EQUAL_UINT64(101, update.first_update_id);
+    TEST_ASSERT_EQUAL_UINT64(102, update.last_update_id);
+    TEST_ASSERT_EQUAL_INT(2, update.bid_count);
+    TEST_ASSERT_EQUAL_INT(1, update.ask_count);
+
+    orderbook_apply_update(ob, &update);
+    TEST_ASSERT_EQUAL_INT(2, ob->bid_count);
+    TEST_ASSERT_EQUAL_FLOAT(49450.0, ob->bids[0].price);
+    TEST_ASSERT_EQUAL_FLOAT(3.0, ob->bids[0].amount);
+    TEST_ASSERT_EQUAL_FLOAT(49400.0, ob->bids[1].price);
+    TEST_ASSERT_EQUAL_FLOAT(0.5, ob->asks[0].amount);
+    TEST_ASSERT_EQUAL_UINT64(102, ob->last_update_id);
+}
+
+void test_depth_message_single_pass(void) {
+    // Keys in any order, unknown values skipped, a second message follows
+    const char* json = "{\"u\":12,\"e\":\"depthUpdate\",\"a\":[[\"2.00000000\",\"3.00000000\"]],"
+                       "\"x\":{\"y\":[1,\"}\"]},\"U\":10,\"b\":[]}{\"U\":13}";
+    static DepthUpdate update;
+
+    size_t consumed = parse_depth_message(json, strlen(json), &update);
+    TEST_ASSERT_EQUAL_UINT64(strlen(json) - strlen("{\"U\":13}"), consumed);
+    TEST_ASSERT_EQUAL_UINT64(10, update.first_update_id);
+    TEST_ASSERT_EQUAL_UINT64(12, update.last_update_id);
+    TEST_ASSERT_EQUAL_INT(0, update.bid_count);
+    TEST_ASSERT_EQUAL_INT(1, update.ask_count);
+    TEST_ASSERT_TRUE(update.fields & DEPTH_FIELD_BIDS);
+
+    // Truncated message
+    TEST_ASSERT_EQUAL_UINT64(0, parse_depth_message(json, 20, &update));
+}
+
+void test_depth_stream_sequencing(void) {
+    static DepthStream ds;
+    static OrderBook book;
+    const char* snapshot = "{\"lastUpdateId\":100,\"bids\":[[\"49500.0\",\"1.2\"]],\"asks\":[[\"50000.0\",\"2.3\"]]}";
+    const char* stale = "{\"U\":90,\"u\":99,\"b\":[[\"49500.0\",\"9.0\"]],\"a\":[]}";
+    const char* first = "{\"U\":95,\"u\":105,\"b\":[[\"49500.0\",\"2.0\"]],\"a\":[]}";
+    const char* next = "{\"U\":106,\"u\":110,\"b\":[],\"a\":[[\"50000.0\",\"0\"]]}";
+    const char* gap = "{\"U\":120,\"u\":125,\"b\":[],\"a\":[]}";
+
+    depth_stream_init(&ds);
+    TEST_ASSERT_EQUAL_INT(DEPTH_BUFFERED, depth_stream_on_message(&ds, stale, strlen(stale)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_BUFFERED, depth_stream_on_message(&ds, first, strlen(first)));
+
+    TEST_ASSERT_TRUE(depth_stream_load_snapshot(&ds, &book, snapshot, strlen(snapshot)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_STREAM_LIVE, ds.state);
+    TEST_ASSERT_EQUAL_UINT64(1, ds.stale);
+    TEST_ASSERT_EQUAL_UINT64(105, ds.last_update_id);
+    TEST_ASSERT_EQUAL_FLOAT(2.0, ds.book->bids[0].amount);
+
+    TEST_ASSERT_EQUAL_INT(DEPTH_APPLIED, depth_stream_on_message(&ds, next, strlen(next)));
+    TEST_ASSERT_EQUAL_INT(0, ds.book->ask_count);
+
+    TEST_ASSERT_EQUAL_INT(DEPTH_GAP, depth_stream_on_message(&ds, gap, strlen(gap)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_STREAM_RESYNC, ds.state);
+    depth_stream_free(&ds);
+}
+
+void test_depth_stream_recovers_after_gap(void) {
+    static DepthStream ds;
+    static OrderBook book;
+    const char* snapshot = "{\"lastUpdateId\":100,\"bids\":[[\"49500.0\",\"1.2\"]],\"asks\":[]}";
+    const char* gap = "{\"U\":120,\"u\":125,\"b\":[[\"49500.0\",\"3.0\"]],\"a\":[]}";
+    const char* next = "{\"U\":126,\"u\":130,\"b\":[],\"a\":[[\"50000.0\",\"1.0\"]]}";
+    const char* newer = "{\"lastUpdateId\":122,\"bids\":[[\"49500.0\",\"2.0\"]],\"asks\":[]}";
+
+    depth_stream_init(&ds);
+    TEST_ASSERT_TRUE(depth_stream_load_snapshot(&ds, &book, snapshot, strlen(snapshot)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_GAP, depth_stream_on_message(&ds, gap, strlen(gap)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_BUFFERED, depth_stream_on_message(&ds, next, strlen(next)));
+
+    // A snapshot still older than the kept events leaves the stream in RESYNC
+    TEST_ASSERT_FALSE(depth_stream_load_snapshot(&ds, &book, snapshot, strlen(snapshot)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_STREAM_RESYNC, ds.state);
+
+    // A newer one replays both kept events and goes live again
+    TEST_ASSERT_TRUE(depth_stream_load_snapshot(&ds, &book, newer, strlen(newer)));
+    TEST_ASSERT_EQUAL_INT(DEPTH_STREAM_LIVE, ds.state);
+    TEST_ASSERT_EQUAL_UINT64(130, ds.last_update_id);
+    TEST_ASSERT_EQUAL_FLOAT(3.0, ds.book->bids[0].amount);
+    TEST_ASSERT_EQUAL_INT(1, ds.book->ask_count);
+    TEST_ASSERT_EQUAL_INT(0, ds.pending_count);
+
+    // Without a snapshot, only the newest DEPTH_STREAM_MAX_PENDING events are kept
+    depth_stream_free(&ds);
+    depth_stream_init(&ds);
+    DepthLevel level = { 4950000000000LL, 100000000LL };
+    for (int i = 0; i <= DEPTH_STREAM_MAX_PENDING; i++) {
+        depth_stream_on_levels(&ds, 200 + i, 200 + i, &level, 1, &level, 0);
+    }
+    TEST_ASSERT_EQUAL_INT(DEPTH_STREAM_MAX_PENDING, ds.pending_count);
+    TEST_ASSERT_EQUAL_UINT64(1, ds.dropped);
+    TEST_ASSERT_EQUAL_UINT64(201, ds.pending[0].first_update_id);
+    depth_stream_free(&ds);
+}
+
+void test_depth_stream_publishes_top_of_book(void) {
+    static DepthStream ds;
+    static OrderBook book;
+    static TopOfBook top;
+    TopOfBookSnapshot seen;
+    const char* snapshot = "{\"lastUpdateId\":100,\"bids\":[[\"49500.0\",\"1.2\"],[\"49400.0\",\"1.0\"]],"
+                           "\"asks\":[[\"50000.0\",\"2.3\"]]}";
+    const char* diff = "{\"U\":101,\"u\":102,\"b\":[[\"49500.0\",\"0\"]],\"a\":[[\"49900.0\",\"0.5\"]]}";
+
+    top_of_book_init(&top);
+    depth_stream_init(&ds);
+    ds.top = &top;
+    TEST_ASSERT_TRUE(depth_stream_load_snapshot(&ds, &book, snapshot, strlen(snapshot)));
+    TEST_ASSERT_EQUAL_INT(1, top_of_book_read(&top, &seen));
+    TEST_ASSERT_EQUAL_UINT64(100, seen.last_update_id);
+    TEST_ASSERT_TRUE(seen.in_sync);
+    TEST_ASSERT_EQUAL_INT(2, seen.bid_count);
+    TEST_ASSERT_EQUAL_FLOAT(49500.0, seen.bids[0].price);
+
+    TEST_ASSERT_EQUAL_INT(DEPTH_APPLIED, depth_stream_on_message(&ds, diff, strlen(diff)));
+    TEST_ASSERT_TRUE(top_of_book_try_read(&top, &seen));
+    TEST_ASSERT_EQUAL_UINT64(102, seen.last_update_id);
+    TEST_ASSERT_EQUAL_INT(1, seen.bid_count);
+    TEST_ASSERT_EQUAL_FLOAT(49400.0, seen.bids[0].price);
+    TEST_ASSERT_EQUAL_INT(2, seen.ask_count);
+    TEST_ASSERT_EQUAL_FLOAT(49900.0, seen.asks[0].price);
+    TEST_ASSERT_EQUAL_FLOAT(0.5, seen.asks[0].amount);
+
+    // A gap takes the stream out of LIVE: the pre-gap levels are withdrawn,
+    // and the next snapshot brings the book back in sync
+    const char* gap = "{\"U\":110,\"u\":111,\"b\":[[\"49400.0\",\"3.0\"]],\"a\":[]}";
+    TEST_ASSERT_EQUAL_INT(DEPTH_GAP, depth_stream_on_message(&ds, gap, strlen(gap)));
+    TEST_ASSERT_TRUE(top_of_book_try_read(&top, &seen));
+    TEST_ASSERT_FALSE(seen.in_sync);
+    TEST_ASSERT_EQUAL_UINT64(102, seen.last_update_id);
+    TEST_ASSERT_EQUAL_INT(0, seen.bid_count);
+    TEST_ASSERT_EQUAL_INT(0, seen.ask_count);
+
+    const char* resync = "{\"lastUpdateId\":110,\"bids\":[[\"49300.0\",\"1.0\"]],\"asks\":[[\"50000.0\",\"2.3\"]]}";
+    TEST_ASSERT_TRUE(depth_stream_load_snapshot(&ds, &book, resync, strlen(resync)));
+    TEST_ASSERT_TRUE(top_of_book_try_read(&top, &seen));
+    TEST_ASSERT_TRUE(seen.in_sync);
+    TEST_ASSERT_EQUAL_UINT64(111, seen.last_update_id);
+    TEST_ASSERT_EQUAL_INT(2, seen.bid_count);
+    TEST_ASSERT_EQUAL_FLOAT(49400.0, seen.bids[0].price);
+
+    // A publish in progress (odd sequence) is never returned
+    atomic_fetch_add(&top.sequence, 1);
+    TEST_ASSERT_FALSE(top_of_book_try_read(&top, &seen));
+    depth_stream_free(&ds);
+}
+
+void test_capture_roundtrip(void) {
+    static DepthUpdate update;
+    const char* path = "test_capture.bin";
+    const char* snapshot = "{\"lastUpdateId\":100,\"bids\":[[\"49500.0\",\"1.2\"]],\"asks\":[[\"50000.0\",\"2.3\"]]}";
+    const char* diff = "{\"E\":7,\"U\":101,\"u\":103,\"b\":[[\"49500.0\",\"0\"]],\"a\":[[\"50001.0\",\"4.0\"]]}";
+
+    unlink(path);
+    CaptureWriter writer;
+    TEST_ASSERT_EQUAL_INT(0, capture_open(&writer, path, "BTCUSDT"));
+    TEST_ASSERT_EQUAL_INT(0, capture_write_snapshot(&writer, 1000, parse_orderbook_snapshot(snapshot)));
+    TEST_ASSERT_TRUE(parse_depth_update(diff, &update));
+    TEST_ASSERT_EQUAL_INT(0, capture_write_update(&writer, 2000, &update));
+    TEST_ASSERT_EQUAL_INT(0, capture_close(&writer));
+
+    CaptureReader reader;
+    CaptureRecord record;
+    TEST_ASSERT_EQUAL_INT(0, capture_map(&reader, path));
+    TEST_ASSERT_TRUE(capture_next(&reader, &record));
+    TEST_ASSERT_EQUAL_INT(CAPTURE_SNAPSHOT, record.header->type);
+    TEST_ASSERT_EQUAL_UINT64(100, record.header->last_update_id);
+    TEST_ASSERT_EQUAL_INT64(4950000000000LL, record.bids[0].price);
+    TEST_ASSERT_EQUAL_INT64(230000000LL, record.asks[0].amount);
+
+    TEST_ASSERT_TRUE(capture_next(&reader, &record));
+    TEST_ASSERT_EQUAL_INT(CAPTURE_DIFF, record.header->type);
+    TEST_ASSERT_EQUAL_UINT64(2000, record.header->recv_time_ns);
+    TEST_ASSERT_EQUAL_UINT64(7, record.header->event_time);
+    TEST_ASSERT_EQUAL_UINT64(101, record.header->first_update_id);
+    TEST_ASSERT_EQUAL_INT(1, record.header->bid_count);
+    TEST_ASSERT_EQUAL_INT64(0, record.bids[0].amount);
+    TEST_ASSERT_EQUAL_INT64(5000100000000LL, record.asks[0].price);
+
+    TEST_ASSERT_FALSE(capture_next(&reader, &record));
+    capture_unmap(&reader);
+
+    // Counts whose 32-bit sum wraps to 0 must not pass as an empty record
+    CaptureRecordHeader corrupt = { .size = sizeof(CaptureRecordHeader), .type = CAPTURE_SNAPSHOT,
+                                    .bid_count = 0xFFFFFFFFu, .ask_count = 1 };
+    FILE* file = fopen(path, "ab");
+    TEST_ASSERT_EQUAL_INT(1, fwrite(&corrupt, sizeof(corrupt), 1, file));
+    fclose(file);
+    TEST_ASSERT_EQUAL_INT(0, capture_map(&reader, path));
+    TEST_ASSERT_TRUE(capture_next(&reader, &record));
+    TEST_ASSERT_TRUE(capture_next(&reader, &record));
+    TEST_ASSERT_FALSE(capture_next(&reader, &record));
+    capture_unmap(&reader);
+    unlink(path);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_parse_empty_orderbook);
     RUN_TEST(test_parse_single_bid_entry);
     RUN_TEST(test_parse_single_ask_entry);
     RUN_TEST(test_parse_multiple_entries);
+    RUN_TEST(test_parse_snapshot_without_terminator);
+    RUN_TEST(test_parse_into_caller_books);
+    RUN_TEST(test_parse_into_soa_columns);
+    RUN_TEST(test_arena_book_grows_to_max_depth);
+    RUN_TEST(test_fixed_point_binance_format);
+    RUN_TEST(test_fixed_point_short_and_invalid);
+    RUN_TEST(test_structural_scan_matches_scalar);
+    RUN_TEST(test_structural_scan_bound_to_cpu);
+    RUN_TEST(test_book_scan_matches_reference);
+    RUN_TEST(test_book_query_cost_to_fill);
+    RUN_TEST(test_book_query_matches_reference);
+    RUN_TEST(test_apply_depth_update_in_place);
+    RUN_TEST(test_depth_message_single_pass);
+    RUN_TEST(test_depth_stream_sequencing);
+    RUN_TEST(test_depth_stream_recovers_after_gap);
+    RUN_TEST(test_depth_stream_publishes_top_of_book);
+    RUN_TEST(test_capture_roundtrip);
     return UNITY_END();
 }
\ No newline at end of file